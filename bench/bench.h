@@ -0,0 +1,110 @@
+/*
+ * Copyright (C) 2023 Emre Simsirli
+ *
+ * Licensed under GPLv3 or any later version.
+ * Refer to the included LICENSE file.
+ */
+
+#pragma once
+
+#include <chrono>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "core/int_types.h"
+
+namespace volkano::bench {
+
+/**
+ * Iteration count of a run and its timer, the timer only covers the loop over the state so
+ * setup before the loop is not measured:
+ *   for ([[maybe_unused]] const u64 i : state) { ... }
+ * Work inside the loop that should not be measured goes between pause_timing and resume_timing.
+ * Measurements other than the time per iteration are reported through counters.
+ */
+class state {
+public:
+    using clock = std::chrono::steady_clock;
+
+    class iterator {
+        state* state_;
+        u64 remaining_;
+
+    public:
+        iterator(state* s, const u64 remaining) noexcept : state_{s}, remaining_{remaining} {}
+
+        u64 operator*() const noexcept { return remaining_; }
+        void operator++() noexcept { --remaining_; }
+        bool operator!=(const iterator&) noexcept
+        {
+            if (remaining_ == 0) {
+                state_->end_ = clock::now();
+                return false;
+            }
+            return true;
+        }
+    };
+
+private:
+    u64 iterations_;
+    clock::time_point begin_;
+    clock::time_point end_;
+    clock::time_point paused_at_;
+    clock::duration paused_{};
+    std::vector<std::pair<std::string_view, f64>> counters_;
+
+public:
+    explicit state(const u64 iterations) noexcept : iterations_{iterations} {}
+
+    iterator begin() noexcept
+    {
+        begin_ = clock::now();
+        return iterator{this, iterations_};
+    }
+    iterator end() noexcept { return iterator{this, 0}; }
+
+    void pause_timing() noexcept { paused_at_ = clock::now(); }
+    void resume_timing() noexcept { paused_ += clock::now() - paused_at_; }
+
+    /** printed next to the time of the last run, name must outlive the run */
+    void set_counter(const std::string_view name, const f64 value) { counters_.emplace_back(name, value); }
+    [[nodiscard]] const std::vector<std::pair<std::string_view, f64>>& counters() const noexcept { return counters_; }
+
+    [[nodiscard]] u64 iterations() const noexcept { return iterations_; }
+    [[nodiscard]] clock::duration elapsed() const noexcept { return end_ - begin_ - paused_; }
+};
+
+struct benchmark {
+    std::string_view name;
+    void (*fn)(state&);
+};
+
+inline std::vector<benchmark>& registry() noexcept
+{
+    static std::vector<benchmark> benchmarks;
+    return benchmarks;
+}
+
+struct registrar {
+    registrar(const std::string_view name, void (*fn)(state&)) noexcept { registry().push_back(benchmark{name, fn}); }
+};
+
+/** keeps the compiler from optimizing away a value that is otherwise unused */
+template<typename T>
+void do_not_optimize(const T& value) noexcept
+{
+#if defined(_MSC_VER)
+    static volatile const void* sink;
+    sink = &value;
+#else
+    asm volatile("" : : "r,m"(value) : "memory");
+#endif
+}
+
+} // namespace volkano::bench
+
+#define VKE_BENCHMARK(name)                                                            \
+    static void name(volkano::bench::state& state);                                    \
+    static const volkano::bench::registrar name##_registrar{#name, &name}; /*NOLINT*/ \
+    static void name([[maybe_unused]] volkano::bench::state& state)
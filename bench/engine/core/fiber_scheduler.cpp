@@ -0,0 +1,76 @@
+/*
+ * Copyright (C) 2023 Emre Simsirli
+ *
+ * Licensed under GPLv3 or any later version.
+ * Refer to the included LICENSE file.
+ */
+
+#include "bench.h"
+#include "core/thread/fiber_scheduler.h"
+
+namespace {
+
+using volkano::fiber;
+using volkano::fiber_counter;
+using volkano::fiber_scheduler;
+using volkano::fiber_scheduler_config;
+using volkano::u32;
+
+constexpr u32 batch_size = 1000;
+
+struct switch_pair {
+    fiber* main = nullptr;
+    fiber* child = nullptr;
+};
+
+void bounce(void* arg)
+{
+    const auto& pair = *static_cast<switch_pair*>(arg);
+    while (true) {
+        fiber::switch_to(*pair.child, *pair.main);
+    }
+}
+
+} // namespace
+
+// a switch into a fiber and back, two context switches per iteration
+VKE_BENCHMARK(fiber_switch_round_trip)
+{
+    fiber main;
+    switch_pair pair;
+    fiber child{&bounce, &pair};
+    pair.main = &main;
+    pair.child = &child;
+
+    for ([[maybe_unused]] const auto i : state) {
+        fiber::switch_to(main, child);
+    }
+}
+
+// compare with job_run_and_wait_single, the job needs a fiber switch on top of the queue round trip
+VKE_BENCHMARK(fiber_job_run_and_wait_single)
+{
+    fiber_scheduler scheduler{fiber_scheduler_config{.worker_count = 2}};
+    for ([[maybe_unused]] const auto i : state) {
+        fiber_counter counter;
+        scheduler.run([]() {}, &counter);
+        scheduler.wait(counter);
+    }
+}
+
+// the waiting job parks instead of helping, its worker picks up the spawned jobs meanwhile
+VKE_BENCHMARK(fiber_job_spawn_1000_nested)
+{
+    fiber_scheduler scheduler;
+    for ([[maybe_unused]] const auto i : state) {
+        fiber_counter root;
+        scheduler.run([&scheduler]() {
+            fiber_counter counter;
+            for (u32 j = 0; j < batch_size; ++j) {
+                scheduler.run([]() {}, &counter);
+            }
+            scheduler.wait(counter);
+        }, &root);
+        scheduler.wait(root);
+    }
+}
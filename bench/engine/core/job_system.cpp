@@ -0,0 +1,104 @@
+/*
+ * Copyright (C) 2023 Emre Simsirli
+ *
+ * Licensed under GPLv3 or any later version.
+ * Refer to the included LICENSE file.
+ */
+
+#include <cmath>
+#include <vector>
+
+#include "bench.h"
+#include "core/thread/job_system.h"
+
+namespace {
+
+using volkano::f64;
+using volkano::job_counter;
+using volkano::job_system;
+using volkano::u32;
+
+constexpr u32 batch_size = 1000;
+constexpr u32 scaling_item_count = 1u << 20;
+
+f64 heavy_work(const u32 begin, const u32 end) noexcept
+{
+    f64 sum = 0.0;
+    for (u32 i = begin; i < end; ++i) {
+        sum += std::sqrt(static_cast<f64>(i)) * std::sin(static_cast<f64>(i));
+    }
+    return sum;
+}
+
+void parallel_for_scaling(volkano::bench::state& state, const u32 worker_count)
+{
+    job_system jobs{worker_count};
+    std::vector<f64> partial_sums(scaling_item_count / 1024);
+    for ([[maybe_unused]] const auto i : state) {
+        jobs.parallel_for(0, static_cast<u32>(partial_sums.size()), /*min_chunk_size=*/1, [&](const u32 begin, const u32 end) {
+            for (u32 block = begin; block < end; ++block) {
+                partial_sums[block] = heavy_work(block * 1024, (block + 1) * 1024);
+            }
+        });
+        volkano::bench::do_not_optimize(partial_sums);
+    }
+}
+
+} // namespace
+
+// round trip of a single job, the latency a fan out of one pays
+VKE_BENCHMARK(job_run_and_wait_single)
+{
+    job_system jobs{2};
+    for ([[maybe_unused]] const auto i : state) {
+        job_counter counter;
+        jobs.run([]() {}, &counter);
+        jobs.wait(counter);
+    }
+}
+
+// spawn overhead from a thread that is not a worker, jobs go through the shared queue
+VKE_BENCHMARK(job_spawn_1000_from_main)
+{
+    job_system jobs;
+    for ([[maybe_unused]] const auto i : state) {
+        job_counter counter;
+        for (u32 j = 0; j < batch_size; ++j) {
+            jobs.run([]() {}, &counter);
+        }
+        jobs.wait(counter);
+    }
+}
+
+// a single worker spawns everything into its own queue, the others only get work by stealing
+VKE_BENCHMARK(job_spawn_1000_stolen)
+{
+    job_system jobs;
+    for ([[maybe_unused]] const auto i : state) {
+        job_counter root;
+        jobs.run([&jobs]() {
+            job_counter counter;
+            for (u32 j = 0; j < batch_size; ++j) {
+                jobs.run([]() {}, &counter);
+            }
+            jobs.wait(counter);
+        }, &root);
+        jobs.wait(root);
+    }
+}
+
+VKE_BENCHMARK(parallel_for_baseline_serial)
+{
+    std::vector<f64> partial_sums(scaling_item_count / 1024);
+    for ([[maybe_unused]] const auto i : state) {
+        for (u32 block = 0; block < partial_sums.size(); ++block) {
+            partial_sums[block] = heavy_work(block * 1024, (block + 1) * 1024);
+        }
+        volkano::bench::do_not_optimize(partial_sums);
+    }
+}
+
+VKE_BENCHMARK(parallel_for_scaling_1_worker) { parallel_for_scaling(state, 1); }
+VKE_BENCHMARK(parallel_for_scaling_3_workers) { parallel_for_scaling(state, 3); }
+VKE_BENCHMARK(parallel_for_scaling_7_workers) { parallel_for_scaling(state, 7); }
+VKE_BENCHMARK(parallel_for_scaling_15_workers) { parallel_for_scaling(state, 15); }
@@ -0,0 +1,67 @@
+/*
+ * Copyright (C) 2023 Emre Simsirli
+ *
+ * Licensed under GPLv3 or any later version.
+ * Refer to the included LICENSE file.
+ */
+
+#include <memory_resource>
+#include <vector>
+
+#include "bench.h"
+#include "core/memory/linear_arena.h"
+#include "core/memory/scratch_arena.h"
+
+namespace {
+
+using volkano::linear_arena;
+using volkano::u32;
+
+// roughly what a frame builds up, sized temporaries like the ones of the render graph
+constexpr u32 containers_per_frame = 16;
+constexpr u32 items_per_container = 64;
+
+template<typename Vector>
+void fill(Vector& values) noexcept
+{
+    values.reserve(items_per_container);
+    for (u32 i = 0; i < items_per_container; ++i) {
+        values.push_back(i);
+    }
+    volkano::bench::do_not_optimize(values.data());
+}
+
+} // namespace
+
+VKE_BENCHMARK(frame_containers_heap)
+{
+    for ([[maybe_unused]] const auto i : state) {
+        for (u32 c = 0; c < containers_per_frame; ++c) {
+            std::vector<u32> values;
+            fill(values);
+        }
+    }
+}
+
+VKE_BENCHMARK(frame_containers_frame_arena)
+{
+    linear_arena arena;
+    for ([[maybe_unused]] const auto i : state) {
+        for (u32 c = 0; c < containers_per_frame; ++c) {
+            std::pmr::vector<u32> values{&arena};
+            fill(values);
+        }
+        arena.reset();
+    }
+}
+
+VKE_BENCHMARK(frame_containers_scratch_scope)
+{
+    for ([[maybe_unused]] const auto i : state) {
+        for (u32 c = 0; c < containers_per_frame; ++c) {
+            volkano::scratch_scope scratch;
+            std::pmr::vector<u32> values{scratch.resource()};
+            fill(values);
+        }
+    }
+}
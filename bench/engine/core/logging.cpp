@@ -0,0 +1,181 @@
+/*
+ * Copyright (C) 2023 Emre Simsirli
+ *
+ * Licensed under GPLv3 or any later version.
+ * Refer to the included LICENSE file.
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <barrier>
+#include <chrono>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "bench.h"
+#include "core/logging/logging.h"
+
+VKE_DEFINE_LOG_CATEGORY_STATIC(bench, verbose);
+
+namespace {
+
+using volkano::async_log_config;
+using volkano::f64;
+using volkano::log_sink;
+using volkano::log_verbosity;
+using volkano::logger;
+using volkano::u32;
+using volkano::u64;
+using volkano::usize;
+
+// the ring holds a whole batch so that calls never wait for the sink thread while they are measured
+constexpr u64 batch_size = 1024;
+
+struct null_sink : log_sink {
+    void sink(const log_verbosity /*verbosity*/, const std::string_view log) override
+    {
+        volkano::bench::do_not_optimize(log.size());
+    }
+};
+
+class null_sinks_scope {
+    std::vector<std::unique_ptr<log_sink>> previous_;
+
+public:
+    null_sinks_scope() noexcept
+    {
+        std::vector<std::unique_ptr<log_sink>> sinks;
+        sinks.push_back(std::make_unique<null_sink>());
+        previous_ = logger::get().set_sinks(std::move(sinks));
+    }
+
+    ~null_sinks_scope() { logger::get().set_sinks(std::move(previous_)); }
+
+    null_sinks_scope(const null_sinks_scope&) = delete;
+    null_sinks_scope& operator=(const null_sinks_scope&) = delete;
+};
+
+void log_calls(volkano::bench::state& state)
+{
+    for (const u64 i : state) {
+        VKE_LOG(bench, warning, "frame {} drew {} instances in {:.3f}ms on {}", i, 256u, 1.25, "main");
+        if (i % batch_size == 0) {
+            state.pause_timing();
+            logger::get().flush();
+            state.resume_timing();
+        }
+    }
+}
+
+void log_calls_async(volkano::bench::state& state, const bool defer_formatting)
+{
+    null_sinks_scope sinks;
+    logger::get().enable_async(async_log_config{.defer_formatting = defer_formatting});
+    log_calls(state);
+    logger::get().disable_async();
+}
+
+/**
+ * Every iteration all threads log calls_per_thread messages at once. The time per iteration gives
+ * the throughput, every call is timed on its own for the latency percentiles.
+ */
+void log_stress(volkano::bench::state& state, const u32 thread_count)
+{
+    using clock = std::chrono::steady_clock;
+    constexpr u32 calls_per_thread = 256;
+
+    std::barrier sync{static_cast<std::ptrdiff_t>(thread_count + 1)};
+    std::atomic<bool> is_done = false;
+    std::vector<std::vector<f64>> latencies_ns(thread_count);
+
+    std::vector<std::jthread> threads;
+    for (u32 t = 0; t < thread_count; ++t) {
+        threads.emplace_back([&, t]() {
+            std::vector<f64>& latencies = latencies_ns[t];
+            latencies.reserve(usize{calls_per_thread} * state.iterations());
+            while (true) {
+                sync.arrive_and_wait();
+                if (is_done.load(std::memory_order_relaxed)) {
+                    return;
+                }
+
+                for (u32 i = 0; i < calls_per_thread; ++i) {
+                    const clock::time_point begin = clock::now();
+                    VKE_LOG(bench, warning, "thread {} call {} took {:.3f}ms on {}", t, i, 0.25, "worker");
+                    const std::chrono::duration<f64, std::nano> latency = clock::now() - begin;
+                    latencies.push_back(latency.count());
+                }
+                sync.arrive_and_wait();
+            }
+        });
+    }
+
+    for ([[maybe_unused]] const auto i : state) {
+        sync.arrive_and_wait();
+        sync.arrive_and_wait();
+    }
+
+    is_done.store(true, std::memory_order_relaxed);
+    sync.arrive_and_wait();
+    threads.clear();
+
+    std::vector<f64> all;
+    for (const std::vector<f64>& latencies : latencies_ns) {
+        all.insert(all.end(), latencies.begin(), latencies.end());
+    }
+    std::ranges::sort(all);
+
+    const auto percentile = [&all](const f64 p) { return all[static_cast<usize>(p * static_cast<f64>(all.size() - 1))]; };
+    const std::chrono::duration<f64> elapsed = state.elapsed();
+    state.set_counter("calls_per_s", static_cast<f64>(all.size()) / elapsed.count());
+    state.set_counter("p50_ns", percentile(0.5));
+    state.set_counter("p99_ns", percentile(0.99));
+    state.set_counter("p999_ns", percentile(0.999));
+    state.set_counter("max_ns", all.back());
+}
+
+void log_stress_sync(volkano::bench::state& state, const u32 thread_count)
+{
+    null_sinks_scope sinks;
+    log_stress(state, thread_count);
+}
+
+void log_stress_async(volkano::bench::state& state, const u32 thread_count)
+{
+    null_sinks_scope sinks;
+    logger::get().enable_async();
+    log_stress(state, thread_count);
+    logger::get().disable_async();
+}
+
+} // namespace
+
+// formats and sinks on the calling thread
+VKE_BENCHMARK(log_call_sync)
+{
+    null_sinks_scope sinks;
+    log_calls(state);
+}
+
+// formats on the calling thread, sinks on the sink thread
+VKE_BENCHMARK(log_call_async_formatted)
+{
+    log_calls_async(state, /*defer_formatting=*/false);
+}
+
+// only copies the arguments on the calling thread, the sink thread formats
+VKE_BENCHMARK(log_call_async_deferred)
+{
+    log_calls_async(state, /*defer_formatting=*/true);
+}
+
+// many threads logging at once, whichever thread gets to drain sinks the messages of the others
+VKE_BENCHMARK(log_stress_sync_1_thread) { log_stress_sync(state, 1); }
+VKE_BENCHMARK(log_stress_sync_4_threads) { log_stress_sync(state, 4); }
+VKE_BENCHMARK(log_stress_sync_8_threads) { log_stress_sync(state, 8); }
+
+// the same with deferred formatting on the sink thread, the calls wait once the ring is full
+VKE_BENCHMARK(log_stress_async_1_thread) { log_stress_async(state, 1); }
+VKE_BENCHMARK(log_stress_async_4_threads) { log_stress_async(state, 4); }
+VKE_BENCHMARK(log_stress_async_8_threads) { log_stress_async(state, 8); }
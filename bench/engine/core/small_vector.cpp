@@ -0,0 +1,65 @@
+/*
+ * Copyright (C) 2023 Emre Simsirli
+ *
+ * Licensed under GPLv3 or any later version.
+ * Refer to the included LICENSE file.
+ */
+
+#include <string>
+#include <vector>
+
+#include "bench.h"
+#include "core/container/small_vector.h"
+#include "core/container/static_vector.h"
+
+namespace {
+
+using volkano::small_vector;
+using volkano::static_vector;
+using volkano::u32;
+
+// the common case fits inline, the spill case grows past it a few times
+constexpr u32 inline_count = 8;
+constexpr u32 spill_count = 64;
+
+template<typename Vector>
+void fill_and_sum(volkano::bench::state& state, const u32 count) noexcept
+{
+    for ([[maybe_unused]] const auto i : state) {
+        Vector values;
+        for (u32 v = 0; v < count; ++v) {
+            values.push_back(v);
+        }
+        u32 sum = 0;
+        for (const u32 value : values) {
+            sum += value;
+        }
+        volkano::bench::do_not_optimize(sum);
+    }
+}
+
+template<typename Vector>
+void fill_strings(volkano::bench::state& state, const u32 count)
+{
+    for ([[maybe_unused]] const auto i : state) {
+        Vector values;
+        for (u32 v = 0; v < count; ++v) {
+            values.emplace_back("a string that does not fit the small string buffer");
+        }
+        volkano::bench::do_not_optimize(values.data());
+    }
+}
+
+} // namespace
+
+VKE_BENCHMARK(vector_inline_std_vector) { fill_and_sum<std::vector<u32>>(state, inline_count); }
+VKE_BENCHMARK(vector_inline_static_vector) { fill_and_sum<static_vector<u32, inline_count>>(state, inline_count); }
+VKE_BENCHMARK(vector_inline_small_vector) { fill_and_sum<small_vector<u32, inline_count>>(state, inline_count); }
+
+VKE_BENCHMARK(vector_spill_std_vector) { fill_and_sum<std::vector<u32>>(state, spill_count); }
+VKE_BENCHMARK(vector_spill_static_vector) { fill_and_sum<static_vector<u32, spill_count>>(state, spill_count); }
+VKE_BENCHMARK(vector_spill_small_vector) { fill_and_sum<small_vector<u32, inline_count>>(state, spill_count); }
+
+// growth of elements that have to be moved one by one, no memcpy fast path
+VKE_BENCHMARK(vector_spill_strings_std_vector) { fill_strings<std::vector<std::string>>(state, spill_count); }
+VKE_BENCHMARK(vector_spill_strings_small_vector) { fill_strings<small_vector<std::string, inline_count>>(state, spill_count); }
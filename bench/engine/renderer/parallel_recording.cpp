@@ -0,0 +1,95 @@
+/*
+ * Copyright (C) 2023 Emre Simsirli
+ *
+ * Licensed under GPLv3 or any later version.
+ * Refer to the included LICENSE file.
+ */
+
+#include <memory>
+#include <span>
+#include <vector>
+
+#include "bench.h"
+#include "volkano.h"
+#include "renderer/vk_renderer.h"
+
+namespace {
+
+using volkano::f32;
+using volkano::u32;
+
+// every draw_instanced call is its own draw, enough of them to give every recording thread work
+constexpr u32 draw_count = 4096;
+constexpr u32 instances_per_draw = 4;
+// frames rendered after the engine is created so that pipelines are compiled before anything is timed
+constexpr u32 warmup_frame_count = 2 * volkano::vk_frame_stats::history_size;
+
+/** the runner calls a benchmark again with more iterations, the engine of a thread count is kept across those calls */
+struct recording_engine {
+    u32 recording_threads = 0;
+    std::unique_ptr<volkano::engine> engine;
+    std::vector<volkano::mesh_instance> instances;
+
+    void render_frame() noexcept
+    {
+        for (u32 draw = 0; draw < draw_count; ++draw) {
+            engine->get_renderer()->draw_instanced(std::span{instances}.subspan(draw * instances_per_draw, instances_per_draw));
+        }
+        engine->tick();
+    }
+
+    [[nodiscard]] volkano::vk_renderer& renderer() noexcept { return *static_cast<volkano::vk_renderer*>(engine->get_renderer()); }
+};
+
+recording_engine& get_recording_engine(const u32 recording_threads)
+{
+    static recording_engine cached;
+    if (cached.engine && cached.recording_threads == recording_threads) {
+        return cached;
+    }
+
+    // the previous engine is gone before the next one starts its workers
+    cached.engine.reset();
+    cached.recording_threads = recording_threads;
+    cached.engine = std::make_unique<volkano::engine>(volkano::engine_config{
+      .headless = true,
+      .job_worker_count = recording_threads,
+      .recording_threads = recording_threads
+    });
+
+    cached.instances.clear();
+    for (u32 i = 0; i < draw_count * instances_per_draw; ++i) {
+        const f32 t = static_cast<f32>(i) / static_cast<f32>(draw_count * instances_per_draw);
+        cached.instances.push_back(volkano::mesh_instance{
+          .translation = volkano::vec3f{t * 2.f - 1.f, 0.f, 0.f},
+          .scale = 0.01f,
+          .color = volkano::vec3f{t, 1.f - t, 1.f}
+        });
+    }
+
+    for (u32 frame = 0; frame < warmup_frame_count; ++frame) {
+        cached.render_frame();
+    }
+    return cached;
+}
+
+// renders a draw heavy frame headless, record_ms is the cpu time spent recording the main pass
+void recording_scaling(volkano::bench::state& state, const u32 recording_threads)
+{
+    recording_engine& e = get_recording_engine(recording_threads);
+
+    // only the timed frames count towards the reported record time
+    e.renderer().reset_frame_stats();
+    for ([[maybe_unused]] const auto i : state) {
+        e.render_frame();
+    }
+
+    state.set_counter("record_ms", e.renderer().get_frame_stats().record_ms.average());
+}
+
+} // namespace
+
+VKE_BENCHMARK(recording_scaling_1_thread) { recording_scaling(state, 1); }
+VKE_BENCHMARK(recording_scaling_2_threads) { recording_scaling(state, 2); }
+VKE_BENCHMARK(recording_scaling_4_threads) { recording_scaling(state, 4); }
+VKE_BENCHMARK(recording_scaling_default_threads) { recording_scaling(state, volkano::job_system::default_worker_count()); }
@@ -0,0 +1,53 @@
+/*
+ * Copyright (C) 2023 Emre Simsirli
+ *
+ * Licensed under GPLv3 or any later version.
+ * Refer to the included LICENSE file.
+ */
+
+#include <chrono>
+#include <string_view>
+
+#include <fmt/format.h>
+
+#include "bench.h"
+
+namespace {
+
+using namespace std::chrono_literals;
+
+// iteration counts double until a run takes at least this long
+constexpr auto min_run_time = 200ms;
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    // the only argument is an optional substring that benchmark names must contain
+    const std::string_view filter = argc > 1 ? std::string_view{argv[1]} : std::string_view{};
+
+    fmt::print("{:<48} {:>12} {:>14}\n", "benchmark", "iterations", "ns/iteration");
+    for (const volkano::bench::benchmark& b : volkano::bench::registry()) {
+        if (!filter.empty() && b.name.find(filter) == std::string_view::npos) {
+            continue;
+        }
+
+        volkano::u64 iterations = 1;
+        while (true) {
+            volkano::bench::state state{iterations};
+            b.fn(state);
+
+            if (state.elapsed() >= min_run_time || iterations >= (volkano::u64{1} << 40)) {
+                const std::chrono::duration<volkano::f64, std::nano> elapsed = state.elapsed();
+                fmt::print("{:<48} {:>12} {:>14.1f}", b.name, iterations, elapsed.count() / static_cast<volkano::f64>(iterations));
+                for (const auto& [name, value] : state.counters()) {
+                    fmt::print(" {}={:.1f}", name, value);
+                }
+                fmt::print("\n");
+                break;
+            }
+            iterations *= 2;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,199 @@
+/*
+ * Copyright (C) 2023 Emre Simsirli
+ *
+ * Licensed under GPLv3 or any later version.
+ * Refer to the included LICENSE file.
+ */
+
+#pragma once
+
+#include <compare>
+#include <limits>
+#include <span>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "core/assert.h"
+#include "core/int_types.h"
+
+namespace volkano {
+
+/**
+ * Stores elements contiguously and hands out 32 bit handles to them that stay valid until the
+ * element is erased, other elements moving around does not affect them.
+ *
+ * A handle is the index of a slot and the generation the slot had when the element was inserted.
+ * Erasing bumps the generation of the slot so stale handles are detected instead of resolving to
+ * whatever reuses the slot. A slot whose generation runs out is retired rather than reused.
+ *
+ * Elements are kept dense, erasing moves the last element into the hole, so iteration visits
+ * live elements only and in no particular order.
+ */
+template<typename T>
+    requires std::is_nothrow_move_constructible_v<T> && std::is_nothrow_move_assignable_v<T>
+class slot_map {
+public:
+    static constexpr u32 index_bits = 20;
+    static constexpr u32 generation_bits = 32 - index_bits;
+    static constexpr u32 max_size = (1u << index_bits) - 1;
+
+    class handle {
+        friend slot_map;
+
+        static constexpr u32 invalid_value = std::numeric_limits<u32>::max();
+
+        u32 value_ = invalid_value;
+
+        constexpr handle(const u32 index, const u32 generation) noexcept
+          : value_{(generation << index_bits) | index} {}
+
+    public:
+        constexpr handle() noexcept = default;
+
+        [[nodiscard]] constexpr u32 index() const noexcept { return value_ & max_size; }
+        [[nodiscard]] constexpr u32 generation() const noexcept { return value_ >> index_bits; }
+        [[nodiscard]] constexpr u32 value() const noexcept { return value_; }
+        /** only says whether the handle was ever assigned, use contains to check if it is still alive */
+        [[nodiscard]] constexpr bool is_valid() const noexcept { return value_ != invalid_value; }
+
+        constexpr auto operator<=>(const handle&) const noexcept = default;
+    };
+
+private:
+    static constexpr u32 max_generation = (1u << generation_bits) - 1;
+    static constexpr u32 no_slot = std::numeric_limits<u32>::max();
+
+    struct slot {
+        /** dense index of the element while alive, next free slot otherwise */
+        u32 index;
+        u32 generation;
+    };
+
+    std::vector<T> values_;
+    /** slot of each dense element, needed to patch the slot of the element that fills a hole */
+    std::vector<u32> value_slots_;
+    std::vector<slot> slots_;
+    u32 free_head_ = no_slot;
+
+public:
+    using value_type = T;
+    using iterator = typename std::vector<T>::iterator;
+    using const_iterator = typename std::vector<T>::const_iterator;
+
+    void reserve(const usize capacity)
+    {
+        values_.reserve(capacity);
+        value_slots_.reserve(capacity);
+        slots_.reserve(capacity);
+    }
+
+    template<typename... Args>
+    handle emplace(Args&&... args)
+    {
+        u32 slot_index = free_head_;
+        if (slot_index != no_slot) {
+            free_head_ = slots_[slot_index].index;
+        } else {
+            VKE_ASSERT_MSG(slots_.size() < max_size, "slot map is out of slots");
+            slot_index = static_cast<u32>(slots_.size());
+            slots_.push_back(slot{.index = 0, .generation = 0});
+        }
+
+        slot& s = slots_[slot_index];
+        s.index = static_cast<u32>(values_.size());
+        values_.emplace_back(std::forward<Args>(args)...);
+        value_slots_.push_back(slot_index);
+        return handle{slot_index, s.generation};
+    }
+
+    handle insert(const T& value) { return emplace(value); }
+    handle insert(T&& value) { return emplace(std::move(value)); }
+
+    /** @return false if the handle is stale */
+    bool erase(const handle h) noexcept
+    {
+        if (!contains(h)) {
+            return false;
+        }
+
+        slot& s = slots_[h.index()];
+        const u32 last = static_cast<u32>(values_.size() - 1);
+        if (s.index != last) {
+            values_[s.index] = std::move(values_.back());
+            value_slots_[s.index] = value_slots_.back();
+            slots_[value_slots_[s.index]].index = s.index;
+        }
+        values_.pop_back();
+        value_slots_.pop_back();
+        release_slot(h.index());
+        return true;
+    }
+
+    /** erases every element, handles to them become stale */
+    void clear() noexcept
+    {
+        for (const u32 slot_index : value_slots_) {
+            release_slot(slot_index);
+        }
+        values_.clear();
+        value_slots_.clear();
+    }
+
+    [[nodiscard]] bool contains(const handle h) const noexcept
+    {
+        // free slots moved on to a newer generation, retired ones kept theirs but have no element
+        return h.index() < slots_.size() && slots_[h.index()].generation == h.generation() && slots_[h.index()].index != no_slot;
+    }
+
+    /** @return nullptr if the handle is stale */
+    [[nodiscard]] T* get(const handle h) noexcept { return contains(h) ? &values_[slots_[h.index()].index] : nullptr; }
+    [[nodiscard]] const T* get(const handle h) const noexcept { return contains(h) ? &values_[slots_[h.index()].index] : nullptr; }
+
+    [[nodiscard]] T& operator[](const handle h) noexcept
+    {
+        VKE_ASSERT_MSG(contains(h), "stale slot map handle {:#x}", h.value());
+        return values_[slots_[h.index()].index];
+    }
+
+    [[nodiscard]] const T& operator[](const handle h) const noexcept
+    {
+        VKE_ASSERT_MSG(contains(h), "stale slot map handle {:#x}", h.value());
+        return values_[slots_[h.index()].index];
+    }
+
+    /** handle of the element at a dense position, for when iteration needs to refer back to elements */
+    [[nodiscard]] handle handle_at(const usize dense_index) const noexcept
+    {
+        VKE_ASSERT(dense_index < values_.size());
+        const u32 slot_index = value_slots_[dense_index];
+        return handle{slot_index, slots_[slot_index].generation};
+    }
+
+    [[nodiscard]] usize size() const noexcept { return values_.size(); }
+    [[nodiscard]] bool empty() const noexcept { return values_.empty(); }
+
+    [[nodiscard]] std::span<T> values() noexcept { return values_; }
+    [[nodiscard]] std::span<const T> values() const noexcept { return values_; }
+
+    [[nodiscard]] iterator begin() noexcept { return values_.begin(); }
+    [[nodiscard]] iterator end() noexcept { return values_.end(); }
+    [[nodiscard]] const_iterator begin() const noexcept { return values_.begin(); }
+    [[nodiscard]] const_iterator end() const noexcept { return values_.end(); }
+
+private:
+    void release_slot(const u32 slot_index) noexcept
+    {
+        slot& s = slots_[slot_index];
+        s.index = no_slot;
+        if (s.generation == max_generation) {
+            return;
+        }
+
+        ++s.generation;
+        s.index = free_head_;
+        free_head_ = slot_index;
+    }
+};
+
+} // namespace volkano
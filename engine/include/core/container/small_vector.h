@@ -0,0 +1,353 @@
+/*
+ * Copyright (C) 2023 Emre Simsirli
+ *
+ * Licensed under GPLv3 or any later version.
+ * Refer to the included LICENSE file.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <compare>
+#include <concepts>
+#include <cstring>
+#include <initializer_list>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <type_traits>
+#include <utility>
+
+#include "core/int_types.h"
+#include "core/assert.h"
+#include "core/type_traits.h"
+#include "core/memory/aligned_union.h"
+
+namespace volkano {
+
+/**
+ * Vector that keeps up to InlineCapacity elements within itself and moves them to a buffer from
+ * Allocator once it outgrows that, for lists that are usually short but have no hard upper bound.
+ *
+ * Elements that are trivially relocatable are moved to a new buffer with a memcpy when it grows.
+ * Like std::vector, growing invalidates pointers to elements. Unlike std::vector, moving the
+ * vector does too while the elements are inline.
+ */
+template<typename T, usize InlineCapacity, typename Allocator = std::allocator<T>>
+    requires (InlineCapacity != 0 && !std::is_void_v<T>)
+class small_vector {
+    using alloc_traits = std::allocator_traits<Allocator>;
+
+public:
+    using size_type = u32;
+    using value_type = T;
+    using allocator_type = Allocator;
+    using reference = value_type&;
+    using const_reference = const value_type&;
+    using pointer = T*;
+    using const_pointer = const T*;
+    using iterator = T*;
+    using const_iterator = const T*;
+    using reverse_iterator = std::reverse_iterator<iterator>;
+    using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+
+    static_assert(InlineCapacity <= std::numeric_limits<size_type>::max(), "inline capacity does not fit into size_type");
+
+private:
+    T* data_;
+    size_type size_ = 0;
+    size_type capacity_ = InlineCapacity;
+    [[no_unique_address]] Allocator allocator_;
+    aligned_union<T> inline_storage_[InlineCapacity];
+
+public:
+    small_vector() noexcept(std::is_nothrow_default_constructible_v<Allocator>)
+      : data_{inline_data()} {}
+
+    explicit small_vector(const Allocator& allocator) noexcept
+      : data_{inline_data()},
+        allocator_{allocator} {}
+
+    explicit small_vector(const size_type size, const Allocator& allocator = Allocator{})
+        requires std::default_initializable<T>
+      : small_vector(allocator)
+    {
+        resize(size);
+    }
+
+    small_vector(const size_type size, const T& value, const Allocator& allocator = Allocator{})
+        requires std::copy_constructible<T>
+      : small_vector(allocator)
+    {
+        reserve(size);
+        std::uninitialized_fill_n(data_, size, value);
+        size_ = size;
+    }
+
+    small_vector(std::initializer_list<T> elems, const Allocator& allocator = Allocator{})
+      : small_vector(allocator)
+    {
+        copy_from(elems.begin(), static_cast<size_type>(elems.size()));
+    }
+
+    ~small_vector() noexcept(std::is_nothrow_destructible_v<T>)
+    {
+        std::destroy(begin(), end());
+        release_buffer();
+    }
+
+    small_vector(const small_vector& other)
+        requires std::copy_constructible<T>
+      : small_vector(alloc_traits::select_on_container_copy_construction(other.allocator_))
+    {
+        copy_from(other.data_, other.size_);
+    }
+
+    small_vector& operator=(const small_vector& other)
+        requires std::copy_constructible<T>
+    {
+        if (&other != this) {
+            clear();
+            if constexpr (alloc_traits::propagate_on_container_copy_assignment::value) {
+                if (!has_equal_allocator(other)) {
+                    release_buffer();
+                }
+                allocator_ = other.allocator_;
+            }
+            copy_from(other.data_, other.size_);
+        }
+        return *this;
+    }
+
+    small_vector(small_vector&& other) noexcept(std::is_nothrow_move_constructible_v<T>)
+      : small_vector(other.allocator_)
+    {
+        take(other);
+    }
+
+    small_vector& operator=(small_vector&& other) noexcept(std::is_nothrow_move_constructible_v<T>)
+    {
+        if (&other != this) {
+            clear();
+            release_buffer();
+            if constexpr (alloc_traits::propagate_on_container_move_assignment::value) {
+                allocator_ = other.allocator_;
+            }
+            take(other);
+        }
+        return *this;
+    }
+
+    small_vector& operator=(std::initializer_list<T> elems)
+    {
+        clear();
+        copy_from(elems.begin(), static_cast<size_type>(elems.size()));
+        return *this;
+    }
+
+    [[nodiscard]] T& operator[](const size_type idx) noexcept { return data_[idx]; }
+    [[nodiscard]] const T& operator[](const size_type idx) const noexcept { return data_[idx]; }
+    [[nodiscard]] T& at(const size_type idx) noexcept { VKE_ASSERT(idx < size_); return data_[idx]; }
+    [[nodiscard]] const T& at(const size_type idx) const noexcept { VKE_ASSERT(idx < size_); return data_[idx]; }
+    [[nodiscard]] T* data() noexcept { return data_; }
+    [[nodiscard]] const T* data() const noexcept { return data_; }
+
+    template<typename... Args>
+        requires std::constructible_from<T, Args...>
+    T& emplace_back(Args&&... args)
+    {
+        if (size_ == capacity_) [[unlikely]] {
+            return grow_and_emplace_back(std::forward<Args>(args)...);
+        }
+
+        T* value = std::construct_at(data_ + size_, std::forward<Args>(args)...);
+        ++size_;
+        return *value;
+    }
+
+    void push_back(const T& t) { emplace_back(t); }
+    void push_back(T&& t) { emplace_back(std::move(t)); }
+
+    [[nodiscard]] bool empty() const noexcept { return size_ == 0; }
+    [[nodiscard]] size_type size() const noexcept { return size_; }
+    [[nodiscard]] static constexpr size_type max_size() noexcept { return std::numeric_limits<size_type>::max(); }
+    [[nodiscard]] size_type capacity() const noexcept { return capacity_; }
+    [[nodiscard]] static constexpr size_type inline_capacity() noexcept { return InlineCapacity; }
+    /** whether the elements are still stored within the vector */
+    [[nodiscard]] bool is_inline() const noexcept { return data_ == inline_data(); }
+    [[nodiscard]] allocator_type get_allocator() const noexcept { return allocator_; }
+
+    T& front() noexcept { return at(0); }
+    const T& front() const noexcept { return at(0); }
+    T& back() noexcept { return at(size() - 1); }
+    const T& back() const noexcept { return at(size() - 1); }
+
+    void erase(iterator first, iterator last) noexcept(std::is_nothrow_move_assignable_v<T>)
+    {
+        const auto count = static_cast<size_type>(std::distance(first, last));
+        std::move(last, end(), first);
+        std::destroy(end() - count, end());
+        size_ -= count;
+    }
+
+    void erase(iterator iter) noexcept(std::is_nothrow_move_assignable_v<T>)
+    {
+        erase(iter, iter + 1);
+    }
+
+    void pop_back() noexcept(std::is_nothrow_destructible_v<T>)
+    {
+        std::destroy_at(end() - 1);
+        --size_;
+    }
+
+    /** keeps the buffer, the vector does not go back to inline storage */
+    void clear() noexcept(std::is_nothrow_destructible_v<T>)
+    {
+        std::destroy(begin(), end());
+        size_ = 0;
+    }
+
+    void reserve(const size_type new_capacity)
+    {
+        if (new_capacity > capacity_) {
+            T* new_data = alloc_traits::allocate(allocator_, new_capacity);
+            relocate(data_, size_, new_data);
+            replace_buffer(new_data, new_capacity);
+        }
+    }
+
+    void resize(const size_type new_size)
+        requires std::default_initializable<T>
+    {
+        if (new_size > size_) {
+            reserve(new_size);
+            std::uninitialized_default_construct_n(end(), new_size - size_);
+        } else {
+            std::destroy(begin() + new_size, end());
+        }
+        size_ = new_size;
+    }
+
+    void resize(const size_type new_size, const T& value)
+        requires std::copy_constructible<T>
+    {
+        if (new_size > size_) {
+            reserve(new_size);
+            std::uninitialized_fill_n(end(), new_size - size_, value);
+        } else {
+            std::destroy(begin() + new_size, end());
+        }
+        size_ = new_size;
+    }
+
+    iterator begin() noexcept { return data_; }
+    const_iterator begin() const noexcept { return data_; }
+    iterator end() noexcept { return data_ + size_; }
+    const_iterator end() const noexcept { return data_ + size_; }
+    reverse_iterator rbegin() noexcept { return reverse_iterator{end()}; }
+    const_reverse_iterator rbegin() const noexcept { return const_reverse_iterator{end()}; }
+    reverse_iterator rend() noexcept { return reverse_iterator{begin()}; }
+    const_reverse_iterator rend() const noexcept { return const_reverse_iterator{begin()}; }
+    const_iterator cbegin() const noexcept { return data_; }
+    const_iterator cend() const noexcept { return data_ + size_; }
+    const_reverse_iterator crbegin() const noexcept { return const_reverse_iterator{cend()}; }
+    const_reverse_iterator crend() const noexcept { return const_reverse_iterator{cbegin()}; }
+
+private:
+    [[nodiscard]] T* inline_data() noexcept { return inline_storage_[0].template value<T>(); }
+    [[nodiscard]] const T* inline_data() const noexcept { return inline_storage_[0].template value<T>(); }
+
+    [[nodiscard]] bool has_equal_allocator(const small_vector& other) const noexcept
+    {
+        if constexpr (alloc_traits::is_always_equal::value) {
+            return true;
+        } else {
+            return allocator_ == other.allocator_;
+        }
+    }
+
+    /** moves count elements to uninitialized memory and ends the lifetime of the originals */
+    static void relocate(T* from, const size_type count, T* to) noexcept(std::is_nothrow_move_constructible_v<T>)
+    {
+        if constexpr (is_trivially_relocatable_v<T>) {
+            if (count != 0) {
+                std::memcpy(static_cast<void*>(to), static_cast<const void*>(from), sizeof(T) * count);
+            }
+        } else {
+            std::uninitialized_move_n(from, count, to);
+            std::destroy_n(from, count);
+        }
+    }
+
+    template<typename... Args>
+    T& grow_and_emplace_back(Args&&... args)
+    {
+        VKE_ASSERT_MSG(capacity_ <= max_size() / 2, "small vector capacity overflow");
+        const size_type new_capacity = capacity_ * 2;
+        T* new_data = alloc_traits::allocate(allocator_, new_capacity);
+
+        // constructed first, the arguments may refer to an element that is about to move
+        T* value = std::construct_at(new_data + size_, std::forward<Args>(args)...);
+        relocate(data_, size_, new_data);
+        replace_buffer(new_data, new_capacity);
+        ++size_;
+        return *value;
+    }
+
+    void replace_buffer(T* new_data, const size_type new_capacity) noexcept
+    {
+        release_buffer();
+        data_ = new_data;
+        capacity_ = new_capacity;
+    }
+
+    /** the vector must be empty, it goes back to inline storage */
+    void release_buffer() noexcept
+    {
+        if (!is_inline()) {
+            alloc_traits::deallocate(allocator_, data_, capacity_);
+            data_ = inline_data();
+            capacity_ = InlineCapacity;
+        }
+    }
+
+    /** this must be empty and inline */
+    void copy_from(const T* first, const size_type count)
+    {
+        reserve(count);
+        std::uninitialized_copy_n(first, count, data_);
+        size_ = count;
+    }
+
+    /** this must be empty and inline, steals the buffer of other if the allocators allow it */
+    void take(small_vector& other) noexcept(std::is_nothrow_move_constructible_v<T>)
+    {
+        if (!other.is_inline() && has_equal_allocator(other)) {
+            data_ = std::exchange(other.data_, other.inline_data());
+            size_ = std::exchange(other.size_, 0);
+            capacity_ = std::exchange(other.capacity_, InlineCapacity);
+            return;
+        }
+
+        reserve(other.size_);
+        relocate(other.data_, other.size_, data_);
+        size_ = std::exchange(other.size_, 0);
+    }
+};
+
+template<typename T, usize InlineCapacity, typename Allocator>
+    requires std::equality_comparable<T>
+bool operator==(const small_vector<T, InlineCapacity, Allocator>& left, const small_vector<T, InlineCapacity, Allocator>& right) noexcept
+{
+    return std::equal(left.begin(), left.end(), right.begin(), right.end());
+}
+
+template<typename T, usize InlineCapacity, typename Allocator>
+    requires std::three_way_comparable<T>
+auto operator<=>(const small_vector<T, InlineCapacity, Allocator>& left, const small_vector<T, InlineCapacity, Allocator>& right) noexcept
+{
+    return std::lexicographical_compare_three_way(left.begin(), left.end(), right.begin(), right.end());
+}
+
+} // namespace volkano
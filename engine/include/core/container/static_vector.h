@@ -12,6 +12,8 @@
 #include <compare>
 #include <type_traits>
 #include <initializer_list>
+#include <iterator>
+#include <memory>
 
 #include "core/int_types.h"
 #include "core/assert.h"
@@ -37,10 +39,10 @@ public:
     using const_reference = const value_type&;
     using pointer = T*;
     using const_pointer = const T*;
-    using iterator = typename std::array<T, Capacity>::iterator;
-    using const_iterator = typename std::array<T, Capacity>::const_iterator;
-    using reverse_iterator = typename std::array<T, Capacity>::reverse_iterator;
-    using const_reverse_iterator = typename std::array<T, Capacity>::const_reverse_iterator;
+    using iterator = T*;
+    using const_iterator = const T*;
+    using reverse_iterator = std::reverse_iterator<iterator>;
+    using const_reverse_iterator = std::reverse_iterator<const_iterator>;
 
     constexpr static_vector() noexcept = default;
     constexpr explicit static_vector(const size_type size)
@@ -181,7 +183,7 @@ public:
     constexpr void resize(const size_type new_size) noexcept(std::is_nothrow_default_constructible_v<T>)
     {
         if (new_size > size_) {
-            VKE_ASSERT(new_size < Capacity);
+            VKE_ASSERT(new_size <= Capacity);
             std::uninitialized_default_construct_n(end(), new_size - size_);
         } else {
             std::destroy(begin() + new_size, end());
@@ -189,16 +191,16 @@ public:
         size_ = new_size;
     }
 
-    constexpr iterator begin() noexcept { return iterator{ptr(0)}; }
-    constexpr const_iterator begin() const noexcept { return const_iterator{ptr(0)}; }
-    constexpr iterator end() noexcept { return iterator{ptr(0), size_}; }
-    constexpr const_iterator end() const noexcept { return const_iterator{ptr(0), size_}; }
+    constexpr iterator begin() noexcept { return ptr(0); }
+    constexpr const_iterator begin() const noexcept { return ptr(0); }
+    constexpr iterator end() noexcept { return ptr(0) + size_; }
+    constexpr const_iterator end() const noexcept { return ptr(0) + size_; }
     constexpr reverse_iterator rbegin() noexcept { return reverse_iterator{end()}; }
-    constexpr const_reverse_iterator rbegin() const noexcept { return const_reverse_iterator{begin()}; }
-    constexpr reverse_iterator rend() noexcept { return reverse_iterator{end()}; }
+    constexpr const_reverse_iterator rbegin() const noexcept { return const_reverse_iterator{end()}; }
+    constexpr reverse_iterator rend() noexcept { return reverse_iterator{begin()}; }
     constexpr const_reverse_iterator rend() const noexcept { return const_reverse_iterator{begin()}; }
-    constexpr const_iterator cbegin() const noexcept { return const_iterator{ptr(0)}; }
-    constexpr const_iterator cend() const noexcept { return const_iterator{ptr(0), size_}; }
+    constexpr const_iterator cbegin() const noexcept { return ptr(0); }
+    constexpr const_iterator cend() const noexcept { return ptr(0) + size_; }
     constexpr const_reverse_iterator crbegin() const noexcept { return const_reverse_iterator{cend()}; }
     constexpr const_reverse_iterator crend() const noexcept { return const_reverse_iterator{cbegin()}; }
 
@@ -0,0 +1,27 @@
+/*
+ * Copyright (C) 2023 Emre Simsirli
+ *
+ * Licensed under GPLv3 or any later version.
+ * Refer to the included LICENSE file.
+ */
+
+#pragma once
+
+#include <span>
+#include <vector>
+
+#include "core/int_types.h"
+
+namespace volkano {
+
+/** byte order of 4 byte pixels */
+enum class pixel_layout : u8 { rgba8, bgra8 };
+
+/**
+ * encodes tightly packed 4 byte pixels as a binary ppm (P6), alpha is dropped
+ * @param row_pitch bytes between the starts of two rows, 0 for tightly packed rows
+ */
+[[nodiscard]] std::vector<u8> encode_ppm(u32 width, u32 height, std::span<const u8> pixels,
+  pixel_layout layout, usize row_pitch = 0) noexcept;
+
+} // namespace volkano
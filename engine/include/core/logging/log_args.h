@@ -0,0 +1,110 @@
+/*
+ * Copyright (C) 2023 Emre Simsirli
+ *
+ * Licensed under GPLv3 or any later version.
+ * Refer to the included LICENSE file.
+ */
+
+#pragma once
+
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+
+#include <fmt/format.h>
+
+#include "core/int_types.h"
+#include "core/type_traits.h"
+
+namespace volkano {
+
+/** everything about a log call that is known at compile time, its address identifies the call site */
+struct log_site {
+    std::string_view format;
+    const char* file_name = "";
+    u32 line = 0;
+};
+
+/**
+ * One site per call, MakeSite is a lambda type that is unique to the call and returns its site.
+ * Unlike a static local this can be used in constexpr functions.
+ *
+ * The site only holds literals, a std::source_location in this inline variable fails to link
+ * with some toolchains under sanitizers, its storage ends up in a discarded section.
+ */
+template<typename MakeSite>
+constexpr inline log_site log_site_v = MakeSite{}();
+
+using log_buffer = fmt::basic_memory_buffer<char, 1024>;
+
+template<typename T>
+constexpr inline bool is_log_string_v = is_one_of_v<std::decay_t<T>, const char*, char*, std::string_view, std::string>;
+
+/**
+ * Arguments that can be copied into a log record as raw bytes and formatted later on another thread.
+ * Strings are copied by value, other types may refer to memory the caller owns and are formatted right away.
+ */
+template<typename T>
+concept deferred_log_arg = std::is_arithmetic_v<std::decay_t<T>> || std::is_enum_v<std::decay_t<T>> || is_log_string_v<T>;
+
+/** the type an argument is decoded into, strings point into the record */
+template<typename T>
+using deferred_log_arg_t = std::conditional_t<is_log_string_v<T>, std::string_view, std::decay_t<T>>;
+
+/** formats the encoded arguments of a record with the format string of its call site */
+using deferred_log_format_fn = void (*)(std::string_view format, const std::byte* args, log_buffer& out);
+
+template<deferred_log_arg T>
+[[nodiscard]] usize encoded_log_arg_size(const T& arg) noexcept
+{
+    if constexpr (is_log_string_v<T>) {
+        return sizeof(u32) + std::string_view{arg}.size();
+    } else {
+        return sizeof(T);
+    }
+}
+
+template<deferred_log_arg T>
+std::byte* encode_log_arg(std::byte* out, const T& arg) noexcept
+{
+    if constexpr (is_log_string_v<T>) {
+        const std::string_view str{arg};
+        const auto size = static_cast<u32>(str.size());
+        std::memcpy(out, &size, sizeof(size));
+        std::memcpy(out + sizeof(size), str.data(), size);
+        return out + sizeof(size) + size;
+    } else {
+        std::memcpy(out, &arg, sizeof(T));
+        return out + sizeof(T);
+    }
+}
+
+template<typename T>
+const std::byte* decode_log_arg(const std::byte* in, T& arg) noexcept
+{
+    if constexpr (std::is_same_v<T, std::string_view>) {
+        u32 size = 0;
+        std::memcpy(&size, in, sizeof(size));
+        arg = std::string_view{reinterpret_cast<const char*>(in + sizeof(size)), size};
+        return in + sizeof(size) + size;
+    } else {
+        std::memcpy(&arg, in, sizeof(T));
+        return in + sizeof(T);
+    }
+}
+
+template<typename... Decoded>
+void format_deferred_log(const std::string_view format, const std::byte* args, log_buffer& out)
+{
+    std::tuple<Decoded...> decoded;
+    std::apply([&](Decoded&... arg) {
+        // a comma fold runs left to right, the order the arguments were encoded in
+        [[maybe_unused]] const std::byte* cursor = args;
+        ((cursor = decode_log_arg(cursor, arg)), ...);
+        fmt::vformat_to(std::back_inserter(out), format, fmt::make_format_args(arg...));
+    }, decoded);
+}
+
+} // namespace volkano
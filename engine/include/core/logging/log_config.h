@@ -0,0 +1,63 @@
+/*
+ * Copyright (C) 2023 Emre Simsirli
+ *
+ * Licensed under GPLv3 or any later version.
+ * Refer to the included LICENSE file.
+ */
+
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "core/filesystem/filesystem.h"
+#include "core/logging/logging_types.h"
+
+namespace volkano {
+
+struct log_config_entry {
+    /** applies to every category */
+    static constexpr std::string_view all_categories = "*";
+
+    std::string_view category;
+    log_verbosity verbosity = log_verbosity::off;
+};
+
+/**
+ * Parses category verbosities such as "renderer=verbose, vulkan_validation=error".
+ * Entries are separated by commas or new lines, # comments out the rest of a line.
+ * Malformed entries are skipped with a warning.
+ */
+[[nodiscard]] std::vector<log_config_entry> parse_log_config(std::string_view text);
+
+/**
+ * Polls a log config file and applies it to the logger whenever it changes, so verbosities can
+ * be changed in a running build. Categories go back to their defaults once they are removed from
+ * the file or the file is deleted.
+ */
+class log_config_watcher {
+    fs::path path_;
+    std::chrono::milliseconds poll_interval_;
+
+    std::mutex mutex_;
+    std::condition_variable_any wake_;
+    std::jthread thread_;
+
+public:
+    explicit log_config_watcher(fs::path path, std::chrono::milliseconds poll_interval = std::chrono::milliseconds{500});
+
+    log_config_watcher(const log_config_watcher&) = delete;
+    log_config_watcher(log_config_watcher&&) = delete;
+    log_config_watcher& operator=(const log_config_watcher&) = delete;
+    log_config_watcher& operator=(log_config_watcher&&) = delete;
+
+private:
+    void watch_loop(std::stop_token stop_token) noexcept;
+    void reload() noexcept;
+};
+
+} // namespace volkano
@@ -0,0 +1,107 @@
+/*
+ * Copyright (C) 2023 Emre Simsirli
+ *
+ * Licensed under GPLv3 or any later version.
+ * Refer to the included LICENSE file.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstring>
+#include <memory>
+#include <span>
+
+#include "core/int_types.h"
+
+namespace volkano {
+
+/**
+ * Bounded multi producer single consumer ring of variable sized byte records.
+ *
+ * Producers reserve space with a single compare exchange, fill the record in place and commit it.
+ * The consumer hands committed records out in reservation order and stops at the first one that
+ * is not committed yet. A record that does not fit before the end of the buffer is preceded by
+ * padding, so records are always contiguous.
+ */
+class log_ring {
+    struct record_header {
+        u32 state;
+        u32 size;
+    };
+
+    enum record_state : u32 {
+        state_empty = 0,
+        state_committed = 1,
+        state_padding = 2
+    };
+
+    static constexpr usize alignment = alignof(record_header);
+
+    std::unique_ptr<record_header[]> buffer_;
+    u64 capacity_;
+    u64 mask_;
+
+    alignas(64) std::atomic<u64> write_pos_ = 0;
+    alignas(64) std::atomic<u64> read_pos_ = 0;
+
+public:
+    /** @param capacity in bytes, rounded up to a power of two */
+    explicit log_ring(usize capacity);
+
+    /**
+     * @return space for size bytes that must be committed, nullptr if the ring is full
+     * @note size must not exceed max_record_size
+     */
+    [[nodiscard]] std::byte* try_reserve(u32 size) noexcept;
+    static void commit(std::byte* record) noexcept;
+
+    /**
+     * Calls fn with every committed record in order, single consumer only.
+     * @return number of records consumed
+     */
+    template<typename Fn>
+    usize consume(Fn&& fn) noexcept
+    {
+        auto* const bytes = reinterpret_cast<std::byte*>(buffer_.get());
+        u64 pos = read_pos_.load(std::memory_order_relaxed);
+        usize count = 0;
+        while (true) {
+            const u64 offset = pos & mask_;
+            auto* header = reinterpret_cast<record_header*>(bytes + offset);
+            const u32 state = std::atomic_ref<u32>{header->state}.load(std::memory_order_acquire);
+            if (state == state_empty) {
+                break;
+            }
+
+            u64 total = capacity_ - offset;
+            if (state == state_committed) {
+                total = record_total_size(header->size);
+                fn(std::span<const std::byte>{bytes + offset + sizeof(record_header), header->size});
+                ++count;
+            }
+
+            // producers only write headers, whatever they land on has to read as empty
+            std::memset(bytes + offset, 0, total);
+            pos += total;
+            read_pos_.store(pos, std::memory_order_release);
+        }
+        return count;
+    }
+
+    [[nodiscard]] usize capacity() const noexcept { return capacity_; }
+    /** largest record that fits, a quarter of the capacity so that wrapping never fills the ring on its own */
+    [[nodiscard]] u32 max_record_size() const noexcept { return static_cast<u32>(capacity_ / 4 - sizeof(record_header)); }
+    /** position just past the last reserved record, consumed once read_position reaches it */
+    [[nodiscard]] u64 write_position() const noexcept { return write_pos_.load(std::memory_order_acquire); }
+    [[nodiscard]] u64 read_position() const noexcept { return read_pos_.load(std::memory_order_acquire); }
+
+private:
+    [[nodiscard]] static u64 record_total_size(const u32 size) noexcept
+    {
+        return (sizeof(record_header) + size + alignment - 1) & ~u64{alignment - 1};
+    }
+};
+
+} // namespace volkano
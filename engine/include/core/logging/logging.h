@@ -7,15 +7,24 @@
 
 #pragma once
 
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
 #include <string_view>
 #include <memory>
-#include <source_location>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <thread>
+#include <unordered_map>
 #include <vector>
 
 #include <fmt/format.h>
 
 #include "core/int_types.h"
 #include "core/platform.h"
+#include "core/logging/log_args.h"
+#include "core/logging/log_ring.h"
 #include "logging_types.h"
 
 #ifndef VKE_LOG_COMPILE_TIME_VERBOSITY
@@ -31,9 +40,12 @@ do {
     constexpr auto v_current = ::volkano::log_verbosity::verbosity;                      \
     constexpr auto v_allowed = ::volkano::log_verbosity{VKE_LOG_COMPILE_TIME_VERBOSITY}; \
     if constexpr (v_current <= v_allowed) {                                              \
+        constexpr auto vke_make_log_site = [] {                                          \
+            return ::volkano::log_site{format, __FILE__, __LINE__};                      \
+        };                                                                               \
         ::volkano::logger::get().log(logcat_ ## category,                                \
-          v_current, std::source_location::current(),                                    \
-          format __VA_OPT__(,) __VA_ARGS__);                                             \
+          v_current, ::volkano::log_site_v<decltype(vke_make_log_site)>                  \
+          __VA_OPT__(,) __VA_ARGS__);                                                    \
     }                                                                                    \
 } while(0)
 
@@ -43,9 +55,12 @@ do {
 do {                                                                                     \
     constexpr auto v_allowed = ::volkano::log_verbosity{VKE_LOG_COMPILE_TIME_VERBOSITY}; \
     if (verbosity <= v_allowed) {                                                        \
+        constexpr auto vke_make_log_site = [] {                                          \
+            return ::volkano::log_site{format, __FILE__, __LINE__};                      \
+        };                                                                               \
         ::volkano::logger::get().log(logcat_ ## category,                                \
-          verbosity, std::source_location::current(),                                    \
-          format __VA_OPT__(,) __VA_ARGS__);                                             \
+          verbosity, ::volkano::log_site_v<decltype(vke_make_log_site)>                  \
+          __VA_OPT__(,) __VA_ARGS__);                                                    \
     }                                                                                    \
 } while(0)
 
@@ -53,44 +68,192 @@ do {
 
 namespace volkano {
 
+struct log_config_entry;
+
+enum class log_overflow_policy : u8 {
+    /** the logging thread waits for the sink thread to make room */
+    block,
+    /** the message is dropped and counted, the sink thread reports the count */
+    drop
+};
+
+struct async_log_config {
+    /** bytes of formatted messages that can be pending at once */
+    usize buffer_size = 1024 * 1024;
+    log_overflow_policy overflow_policy = log_overflow_policy::block;
+    /** sinks are written and flushed at least this often */
+    std::chrono::milliseconds flush_interval{50};
+    /**
+     * calls whose arguments are all numbers, enums or strings only copy them into the buffer,
+     * the sink thread formats the message
+     */
+    bool defer_formatting = true;
+};
+
 class logger {
     friend log_category;
 
+    /** indexed by category id */
     std::vector<log_category*> categories_;
+    std::unordered_map<std::string_view, u32> category_ids_;
     std::vector<std::unique_ptr<log_sink>> sinks_;
 
-    using log_buffer = fmt::basic_memory_buffer<char, 1024>;
-    log_buffer buffer_;
+    enum class record_kind : u8 {
+        text,
+        deferred
+    };
+
+    /** a formatted line follows */
+    struct text_record {
+        record_kind kind;
+        log_verbosity verbosity;
+    };
+
+    /** the encoded arguments follow */
+    struct deferred_record {
+        record_kind kind;
+        log_verbosity verbosity;
+        const log_category* category;
+        const log_site* site;
+        deferred_log_format_fn format_fn;
+        std::chrono::system_clock::time_point time;
+        std::thread::id thread;
+    };
+
+    /** size of the ring while logging is synchronous, logging threads drain it themselves */
+    static constexpr usize sync_buffer_size = 256 * 1024;
+
+    // every message is published into ring_, in async mode sink_thread_ drains it. otherwise
+    // whichever logging thread raises is_draining_ first sinks the messages of all threads
+    std::unique_ptr<log_ring> ring_;
+    std::atomic<bool> is_draining_ = false;
+    bool is_async_ = false;
+    bool defers_formatting_ = false;
+    log_overflow_policy overflow_policy_ = log_overflow_policy::block;
+    std::chrono::milliseconds flush_interval_{};
+    std::jthread sink_thread_;
+    std::mutex sink_mutex_;
+    std::condition_variable_any sink_wake_;
+    std::condition_variable flushed_;
+    /** ring position that a flush waits for the sink thread to reach */
+    u64 flush_target_ = 0;
+    /** ring position up to which messages reached the sinks and were flushed */
+    std::atomic<u64> flushed_pos_ = 0;
+    std::atomic<u64> dropped_count_ = 0;
+    u64 reported_dropped_count_ = 0;
+    /** deferred records are formatted into this by the draining thread */
+    log_buffer sink_buffer_;
 
 public:
     static logger& get() noexcept;
 
-    template<typename Fmt, typename... Args>
+    template<typename... Args>
     void log(const log_category& category, const log_verbosity verbosity,
-      const std::source_location src, const Fmt& fmt, Args&& ... args) noexcept
+      const log_site& site, Args&& ... args) noexcept
     {
         if (category.verbosity() < verbosity) {
             return;
         }
 
-        buffer_.clear();
-        fmt::vformat_to(std::back_inserter(buffer_), fmt, fmt::make_format_args(args...));
+        if constexpr ((deferred_log_arg<Args> && ...)) {
+            if (defers_formatting_ && try_log_deferred(category, verbosity, site, args...)) {
+                return;
+            }
+        }
+
+        log_buffer& buffer = thread_buffer();
+        buffer.clear();
+        fmt::vformat_to(std::back_inserter(buffer), site.format, fmt::make_format_args(args...));
 
-        const std::string_view user_log{buffer_.data(), buffer_.size()};
-        log_internal(category, verbosity, src, user_log);
+        log_internal(category, verbosity, site, buffer);
     }
 
     void set_category_verbosity(std::string_view category_name, log_verbosity verbosity) noexcept;
+    void set_category_verbosity(u32 category_id, log_verbosity verbosity) noexcept;
+    [[nodiscard]] std::optional<u32> find_category_id(std::string_view category_name) const noexcept;
+
+    /** resets every category to its default verbosity, then applies the entries in order */
+    void apply_config(std::span<const log_config_entry> entries) noexcept;
+
+    /**
+     * Moves sinking to a background thread, logging threads only format and enqueue their messages.
+     * Critical messages flush before they return.
+     * @note call while no other thread logs
+     */
+    void enable_async(const async_log_config& config = {});
+    /** flushes pending messages and sinks on the calling thread again */
+    void disable_async() noexcept;
+    [[nodiscard]] bool is_async() const noexcept { return is_async_; }
+
+    /** returns once every message logged before the call reached the sinks */
+    void flush() noexcept;
+
+    /**
+     * @return the previous sinks
+     * @note call while no other thread logs and async logging is off
+     */
+    std::vector<std::unique_ptr<log_sink>> set_sinks(std::vector<std::unique_ptr<log_sink>> sinks) noexcept;
+
+    /** messages dropped because the async buffer was full */
+    [[nodiscard]] u64 dropped_count() const noexcept { return dropped_count_.load(std::memory_order_relaxed); }
 
 private:
     logger();
+    ~logger();
+
+    static log_buffer& thread_buffer() noexcept;
 
     void log_internal(const log_category& category, log_verbosity verbosity,
-      std::source_location src, std::string_view user_log) noexcept;
+      const log_site& site, log_buffer& buffer) noexcept;
 
-    void register_log_category(log_category* category);
+    /** @return false if the record does not fit, the message is formatted right away then */
+    template<typename... Args>
+    bool try_log_deferred(const log_category& category, const log_verbosity verbosity,
+      const log_site& site, const Args& ... args) noexcept
+    {
+        const usize size = sizeof(deferred_record) + (usize{0} + ... + encoded_log_arg_size(args));
+        if (size > ring_->max_record_size()) {
+            return false;
+        }
+
+        std::byte* record = reserve(static_cast<u32>(size));
+        if (record == nullptr) {
+            return true;
+        }
+
+        const deferred_record header{
+          .kind = record_kind::deferred,
+          .verbosity = verbosity,
+          .category = &category,
+          .site = &site,
+          .format_fn = &format_deferred_log<deferred_log_arg_t<Args>...>,
+          .time = std::chrono::system_clock::now(),
+          .thread = std::this_thread::get_id()
+        };
+        std::memcpy(record, &header, sizeof(header));
+        [[maybe_unused]] std::byte* cursor = record + sizeof(header);
+        ((cursor = encode_log_arg(cursor, args)), ...);
+        log_ring::commit(record);
+
+        on_published(verbosity);
+        return true;
+    }
 
-    log_category* find_category_by_name(std::string_view name) noexcept;
+    /** appends the line prefix and newline to a formatted message */
+    static void finish_line(log_buffer& buffer, const log_category& category, log_verbosity verbosity,
+      const log_site& site, std::chrono::system_clock::time_point time, std::thread::id thread);
+
+    /** @return nullptr if the message has to be dropped */
+    [[nodiscard]] std::byte* reserve(u32 size) noexcept;
+    void enqueue(log_verbosity verbosity, std::string_view log) noexcept;
+    void on_published(log_verbosity verbosity) noexcept;
+    void request_drain(u64 target) noexcept;
+    /** sinks everything published so far unless another logging thread already does */
+    void drain_on_caller() noexcept;
+    void sink_loop(std::stop_token stop_token) noexcept;
+    void drain() noexcept;
+
+    void register_log_category(log_category* category);
 };
 
 } // namespace volkano
@@ -7,30 +7,43 @@
 
 #pragma once
 
+#include <atomic>
 #include <string_view>
 
 #include "core/int_types.h"
 
 namespace volkano {
 
+class logger;
+
 enum class log_verbosity : u8 {
     off, critical, error, warning, info, debug, verbose
 };
 
 class log_category {
+    friend logger;
+
     std::string_view name_;
-    log_verbosity verbosity_;
+    /** read by every logging thread, may be changed from any thread */
+    std::atomic<log_verbosity> verbosity_;
+    log_verbosity default_verbosity_;
+    /** dense index in registration order, assigned by the logger */
+    u32 id_ = 0;
 
 public:
     log_category(std::string_view name, log_verbosity verbosity);
 
-    void set_verbosity(const log_verbosity v) noexcept { verbosity_ = v; }
-    [[nodiscard]] log_verbosity verbosity() const noexcept { return verbosity_; }
+    void set_verbosity(const log_verbosity v) noexcept { verbosity_.store(v, std::memory_order_relaxed); }
+    [[nodiscard]] log_verbosity verbosity() const noexcept { return verbosity_.load(std::memory_order_relaxed); }
+    [[nodiscard]] log_verbosity default_verbosity() const noexcept { return default_verbosity_; }
     [[nodiscard]] std::string_view name() const noexcept { return name_; }
+    [[nodiscard]] u32 id() const noexcept { return id_; }
 };
 
 struct log_sink {
     virtual void sink(log_verbosity verbosity, std::string_view log) = 0;
+    /** called after a batch of logs was sunk, sinks may buffer until then */
+    virtual void flush() {}
     virtual ~log_sink() = default;
 };
 
@@ -0,0 +1,69 @@
+/*
+ * Copyright (C) 2023 Emre Simsirli
+ *
+ * Licensed under GPLv3 or any later version.
+ * Refer to the included LICENSE file.
+ */
+
+#pragma once
+
+#include <array>
+
+#include "core/math/vec3.h"
+
+namespace volkano {
+
+/** plane in hessian normal form, points in front of it have a positive signed distance */
+struct plane {
+    vec3f normal;
+    f32 distance = 0.f;
+
+    [[nodiscard]] static plane from_point_normal(const vec3f& point, const vec3f& normal) noexcept
+    {
+        const vec3f unit_normal = normal.get_normalized();
+        return {.normal = unit_normal, .distance = -unit_normal.dot(point)};
+    }
+
+    [[nodiscard]] constexpr f32 signed_distance(const vec3f& point) const noexcept { return normal.dot(point) + distance; }
+};
+
+// planes are handed to shaders as vec4s
+static_assert(sizeof(plane) == 4 * sizeof(f32));
+
+struct sphere {
+    vec3f center;
+    f32 radius = 0.f;
+};
+
+/** convex volume bounded by six planes which face inwards */
+struct frustum {
+    static constexpr usize plane_count = 6;
+
+    /** left, right, bottom, top, near, far */
+    std::array<plane, plane_count> planes;
+
+    [[nodiscard]] constexpr bool intersects(const sphere& s) const noexcept
+    {
+        for (const plane& p : planes) {
+            if (p.signed_distance(s.center) < -s.radius) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    /** frustum of an orthographic projection, the volume between min and max */
+    [[nodiscard]] static constexpr frustum from_bounds(const vec3f& min, const vec3f& max) noexcept
+    {
+        return frustum{.planes = {
+          plane{.normal = vec3f::unit_x(), .distance = -min.x},
+          plane{.normal = vec3f::unit_x() * -1.f, .distance = max.x},
+          plane{.normal = vec3f::unit_y(), .distance = -min.y},
+          plane{.normal = vec3f::unit_y() * -1.f, .distance = max.y},
+          plane{.normal = vec3f::unit_z(), .distance = -min.z},
+          plane{.normal = vec3f::unit_z() * -1.f, .distance = max.z}
+        }};
+    }
+};
+
+} // namespace volkano
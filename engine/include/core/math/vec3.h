@@ -57,7 +57,7 @@ struct vec3 {
     [[nodiscard]] constexpr vec3 get_normalized_safe() const noexcept
     {
         if (is_nearly_zero()) {
-            return zero;
+            return zero();
         }
 
         return get_normalized();
@@ -114,7 +114,7 @@ struct vec3 {
     static constexpr vec3 unit_y() noexcept { return {.x = T(0), .y = T(1), .z = T(0)}; }
     static constexpr vec3 unit_z() noexcept { return {.x = T(0), .y = T(0), .z = T(1)}; }
     static constexpr vec3 zero() noexcept { return {.x = T(0), .y = T(0), .z = T(0)}; }
-    static constexpr vec3 one() noexcept { return {.x = T(1), .y = T(1), .y = T(1)}; }
+    static constexpr vec3 one() noexcept { return {.x = T(1), .y = T(1), .z = T(1)}; }
 
     static constexpr vec3 from_same(const T component) noexcept { return {.x = component, .y = component, .z = component}; }
     static constexpr vec3 from_radians(const T radians) noexcept { return {.x = radians, .y = radians, .z = radians}; }    // todo
@@ -0,0 +1,29 @@
+/*
+ * Copyright (C) 2023 Emre Simsirli
+ *
+ * Licensed under GPLv3 or any later version.
+ * Refer to the included LICENSE file.
+ */
+
+#pragma once
+
+#include "core/int_types.h"
+
+namespace volkano {
+
+/** whether global operator new is replaced to count heap allocations, see the VKE_TRACK_ALLOCATIONS cmake option */
+[[nodiscard]] constexpr bool is_tracking_allocations() noexcept
+{
+#if defined(VKE_TRACK_ALLOCATIONS)
+    return true;
+#else
+    return false;
+#endif
+}
+
+/** operator new calls on every thread since startup, always zero unless allocations are tracked */
+[[nodiscard]] u64 heap_allocation_count() noexcept;
+/** operator new calls on the calling thread, always zero unless allocations are tracked */
+[[nodiscard]] u64 thread_heap_allocation_count() noexcept;
+
+} // namespace volkano
@@ -0,0 +1,123 @@
+/*
+ * Copyright (C) 2023 Emre Simsirli
+ *
+ * Licensed under GPLv3 or any later version.
+ * Refer to the included LICENSE file.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <limits>
+#include <memory>
+#include <utility>
+
+#include "core/assert.h"
+#include "core/int_types.h"
+#include "core/memory/aligned_union.h"
+
+namespace volkano {
+
+/**
+ * Fixed number of blocks that can hold any of Ts, allocated and freed from any thread without locks.
+ *
+ * Free blocks form a stack that is popped and pushed with a single compare exchange. The head
+ * carries a tag that changes on every push so a pop that raced with a pop and push of the same
+ * block fails instead of installing a stale successor. Links live next to the blocks rather than
+ * in them, a thread that lost the race may still read the link of a block that is in use.
+ */
+template<typename... Ts>
+class block_pool {
+public:
+    using block_type = aligned_union<Ts...>;
+
+private:
+    static constexpr u32 no_block = std::numeric_limits<u32>::max();
+
+    [[nodiscard]] static constexpr u64 make_head(const u32 index, const u32 tag) noexcept { return (u64{tag} << 32) | index; }
+    [[nodiscard]] static constexpr u32 head_index(const u64 head) noexcept { return static_cast<u32>(head); }
+    [[nodiscard]] static constexpr u32 head_tag(const u64 head) noexcept { return static_cast<u32>(head >> 32); }
+
+    std::unique_ptr<block_type[]> blocks_;
+    std::unique_ptr<std::atomic<u32>[]> next_;
+    u32 capacity_;
+
+    alignas(64) std::atomic<u64> head_;
+
+public:
+    explicit block_pool(const u32 capacity)
+      : blocks_{std::make_unique_for_overwrite<block_type[]>(capacity)},
+        next_{std::make_unique<std::atomic<u32>[]>(capacity)},
+        capacity_{capacity},
+        head_{make_head(capacity == 0 ? no_block : 0, 0)}
+    {
+        VKE_ASSERT(capacity != no_block);
+        for (u32 i = 0; i < capacity; ++i) {
+            next_[i].store(i + 1 == capacity ? no_block : i + 1, std::memory_order_relaxed);
+        }
+    }
+
+    block_pool(const block_pool&) = delete;
+    block_pool(block_pool&&) = delete;
+    block_pool& operator=(const block_pool&) = delete;
+    block_pool& operator=(block_pool&&) = delete;
+
+    /** @return uninitialized block, nullptr if every block is in use */
+    [[nodiscard]] block_type* allocate() noexcept
+    {
+        u64 head = head_.load(std::memory_order_acquire);
+        while (true) {
+            const u32 index = head_index(head);
+            if (index == no_block) {
+                return nullptr;
+            }
+
+            const u32 next = next_[index].load(std::memory_order_relaxed);
+            if (head_.compare_exchange_weak(head, make_head(next, head_tag(head)), std::memory_order_acquire)) {
+                return &blocks_[index];
+            }
+        }
+    }
+
+    void deallocate(block_type* block) noexcept
+    {
+        VKE_ASSERT_MSG(owns(block), "block does not belong to this pool");
+
+        const auto index = static_cast<u32>(block - blocks_.get());
+        u64 head = head_.load(std::memory_order_relaxed);
+        while (true) {
+            next_[index].store(head_index(head), std::memory_order_relaxed);
+            if (head_.compare_exchange_weak(head, make_head(index, head_tag(head) + 1), std::memory_order_release)) {
+                return;
+            }
+        }
+    }
+
+    /** @return nullptr if every block is in use */
+    template<typename T, typename... Args>
+    [[nodiscard]] T* create(Args&&... args) noexcept(std::is_nothrow_constructible_v<T, Args...>)
+    {
+        block_type* block = allocate();
+        return block ? block->template construct<T>(std::forward<Args>(args)...) : nullptr;
+    }
+
+    /** @param value created by this pool as a T */
+    template<typename T>
+    void destroy(T* value) noexcept(std::is_nothrow_destructible_v<T>)
+    {
+        // the value lives at the start of its block
+        auto* block = reinterpret_cast<block_type*>(value);
+        block->template destruct<T>();
+        deallocate(block);
+    }
+
+    [[nodiscard]] bool owns(const void* ptr) const noexcept
+    {
+        const auto* block = static_cast<const block_type*>(ptr);
+        return block >= blocks_.get() && block < blocks_.get() + capacity_;
+    }
+
+    [[nodiscard]] u32 capacity() const noexcept { return capacity_; }
+};
+
+} // namespace volkano
@@ -0,0 +1,108 @@
+/*
+ * Copyright (C) 2023 Emre Simsirli
+ *
+ * Licensed under GPLv3 or any later version.
+ * Refer to the included LICENSE file.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <memory>
+#include <memory_resource>
+#include <vector>
+
+#include "core/assert.h"
+#include "core/int_types.h"
+
+namespace volkano {
+
+/**
+ * Bump pointer allocator whose memory is released all at once.
+ *
+ * Allocations that do not fit into the block are served from overflow blocks, the next time the
+ * arena is emptied its block grows to the peak usage so a workload that repeats itself, such as a
+ * frame, stops touching the heap after the first time around.
+ *
+ * Doubles as a std::pmr::memory_resource, deallocation is a no-op so containers can use it as long
+ * as they do not outlive the next reset.
+ */
+class linear_arena final : public std::pmr::memory_resource {
+public:
+    /** position of the arena, rewinding to it frees everything that was allocated after it */
+    struct marker {
+        usize offset = 0;
+        usize overflow_count = 0;
+    };
+
+    static constexpr usize default_capacity = 64 * 1024;
+
+private:
+    struct overflow_block {
+        std::unique_ptr<std::byte[]> memory;
+        usize size = 0;
+    };
+
+    std::unique_ptr<std::byte[]> block_;
+    usize capacity_ = 0;
+    usize offset_ = 0;
+
+    std::vector<overflow_block> overflow_blocks_;
+    usize overflow_size_ = 0;
+    usize peak_ = 0;
+
+public:
+    explicit linear_arena(usize capacity = default_capacity);
+
+    linear_arena(const linear_arena&) = delete;
+    linear_arena(linear_arena&&) = delete;
+    linear_arena& operator=(const linear_arena&) = delete;
+    linear_arena& operator=(linear_arena&&) = delete;
+
+    /** @param alignment a power of two */
+    [[nodiscard]] void* allocate_bytes(const usize size, const usize alignment = alignof(std::max_align_t)) noexcept
+    {
+        VKE_ASSERT(std::has_single_bit(alignment));
+
+        // aligns the address rather than the offset, the block itself is only aligned for max_align_t
+        const auto base = reinterpret_cast<uintptr>(block_.get());
+        const uintptr address = (base + offset_ + alignment - 1) & ~uintptr{alignment - 1};
+        const usize end = address - base + size;
+        if (end > capacity_) [[unlikely]] {
+            return allocate_overflow(size, alignment);
+        }
+
+        offset_ = end;
+        peak_ = std::max(peak_, end + overflow_size_);
+        return reinterpret_cast<void*>(address);
+    }
+
+    template<typename T>
+    [[nodiscard]] T* allocate_array(const usize count) noexcept
+    {
+        return static_cast<T*>(allocate_bytes(sizeof(T) * count, alignof(T)));
+    }
+
+    [[nodiscard]] marker mark() const noexcept { return marker{.offset = offset_, .overflow_count = overflow_blocks_.size()}; }
+    /** everything allocated after the marker must no longer be used */
+    void rewind(const marker& m) noexcept;
+    /** frees every allocation and grows the block if the previous use did not fit into it */
+    void reset() noexcept { rewind(marker{}); }
+
+    [[nodiscard]] usize capacity() const noexcept { return capacity_; }
+    /** bytes in use including alignment padding and overflow blocks */
+    [[nodiscard]] usize used() const noexcept { return offset_ + overflow_size_; }
+    /** highest usage so far, the block grows to it when it does not fit */
+    [[nodiscard]] usize peak() const noexcept { return peak_; }
+
+private:
+    void* do_allocate(usize bytes, usize alignment) override { return allocate_bytes(bytes, alignment); }
+    void do_deallocate(void* /*p*/, usize /*bytes*/, usize /*alignment*/) override {}
+    [[nodiscard]] bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override { return this == &other; }
+
+    [[nodiscard]] void* allocate_overflow(usize size, usize alignment) noexcept;
+};
+
+} // namespace volkano
@@ -0,0 +1,46 @@
+/*
+ * Copyright (C) 2023 Emre Simsirli
+ *
+ * Licensed under GPLv3 or any later version.
+ * Refer to the included LICENSE file.
+ */
+
+#pragma once
+
+#include <memory_resource>
+
+#include "core/memory/linear_arena.h"
+
+namespace volkano {
+
+/** arena of the calling thread for temporaries, allocate from it through a scratch_scope */
+[[nodiscard]] linear_arena& thread_scratch_arena() noexcept;
+
+/**
+ * Marks the scratch arena of the calling thread and rewinds it to the mark when destroyed, freeing
+ * everything allocated within the scope. Scopes nest, only the innermost one may allocate.
+ *
+ * Fiber jobs can resume on another thread after a wait, do not keep a scope across one.
+ */
+class scratch_scope {
+    linear_arena& arena_;
+    linear_arena::marker marker_;
+
+public:
+    scratch_scope() noexcept
+      : arena_{thread_scratch_arena()},
+        marker_{arena_.mark()} {}
+
+    ~scratch_scope() noexcept { arena_.rewind(marker_); }
+
+    scratch_scope(const scratch_scope&) = delete;
+    scratch_scope(scratch_scope&&) = delete;
+    scratch_scope& operator=(const scratch_scope&) = delete;
+    scratch_scope& operator=(scratch_scope&&) = delete;
+
+    [[nodiscard]] linear_arena& arena() noexcept { return arena_; }
+    /** for pmr containers, they must not outlive the scope */
+    [[nodiscard]] std::pmr::memory_resource* resource() noexcept { return &arena_; }
+};
+
+} // namespace volkano
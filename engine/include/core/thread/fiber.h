@@ -0,0 +1,57 @@
+/*
+ * Copyright (C) 2023 Emre Simsirli
+ *
+ * Licensed under GPLv3 or any later version.
+ * Refer to the included LICENSE file.
+ */
+
+#pragma once
+
+#include <cstddef>
+
+#include "core/int_types.h"
+#include "core/platform.h"
+
+namespace volkano {
+
+/**
+ * Execution context with its own stack that is switched to cooperatively in user mode.
+ *
+ * Switching saves only the callee saved registers of the current context and restores the ones
+ * of the target, it costs a few nanoseconds and never enters the kernel. x86-64 and aarch64 have
+ * hand written switches, windows uses its native fibers and other unix targets fall back to ucontext.
+ */
+class fiber {
+public:
+    using entry_fn = void (*)(void* arg);
+
+    static constexpr usize default_stack_size = 64 * 1024;
+
+private:
+#if PLATFORM_WINDOWS
+    void* handle_ = nullptr;
+    bool is_thread_ = false;
+#else
+    void* context_ = nullptr;
+    /** mapped stack, its lowest page is a guard that faults when the stack overflows */
+    std::byte* stack_ = nullptr;
+    usize stack_mapping_size_ = 0;
+#endif
+
+public:
+    /** context of the calling thread, only valid as the source of a switch and to switch back to */
+    fiber() noexcept;
+    /** entry must never return, switch to another fiber instead */
+    fiber(entry_fn entry, void* arg, usize stack_size = default_stack_size) noexcept;
+    ~fiber();
+
+    fiber(const fiber&) = delete;
+    fiber(fiber&&) = delete;
+    fiber& operator=(const fiber&) = delete;
+    fiber& operator=(fiber&&) = delete;
+
+    /** suspends the running context into from and resumes to, returns once something switches back to from */
+    static void switch_to(fiber& from, fiber& to) noexcept;
+};
+
+} // namespace volkano
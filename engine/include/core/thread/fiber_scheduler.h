@@ -0,0 +1,127 @@
+/*
+ * Copyright (C) 2023 Emre Simsirli
+ *
+ * Licensed under GPLv3 or any later version.
+ * Refer to the included LICENSE file.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "core/int_types.h"
+#include "core/thread/fiber.h"
+#include "core/thread/job_system.h"
+
+namespace volkano {
+
+class fiber_scheduler;
+/** fiber that runs jobs one after another, defined by the scheduler */
+struct fiber_slot;
+
+/** jobs that are queued or running, fibers that wait on it are parked until it drops to zero */
+class fiber_counter {
+    friend fiber_scheduler;
+
+    std::atomic<u32> count_ = 0;
+    std::mutex waiters_mutex_;
+    std::vector<fiber_slot*> waiters_;
+
+public:
+    fiber_counter() noexcept = default;
+    fiber_counter(const fiber_counter&) = delete;
+    fiber_counter& operator=(const fiber_counter&) = delete;
+
+    /** polling only, call wait before destroying the counter as the last job may still be finishing */
+    [[nodiscard]] bool is_done() const noexcept { return count_.load(std::memory_order_acquire) == 0; }
+};
+
+struct fiber_scheduler_config {
+    u32 worker_count = job_system::default_worker_count();
+    /** jobs that can be started or parked at the same time, a job keeps its fiber until it returns */
+    u32 fiber_count = 128;
+    usize stack_size = fiber::default_stack_size;
+};
+
+/**
+ * Runs every job on a fiber so that waiting never blocks a worker thread.
+ *
+ * A job that waits on an unfinished counter parks its fiber on the counter and its worker picks
+ * up other work, the job resumes on any worker once the counter drops to zero. This makes it
+ * possible to express dependent work as jobs that wait on each other without idling cores.
+ *
+ * Parked fibers keep their stacks so at most fiber_count jobs can be started and not yet finished.
+ * If every fiber is parked the jobs they wait on can never start, this is asserted on.
+ * Jobs may migrate between threads while they wait, do not keep thread local state or locks
+ * across a wait.
+ */
+class fiber_scheduler {
+public:
+    using job = std::function<void()>;
+
+private:
+    struct queued_job {
+        job fn;
+        fiber_counter* counter = nullptr;
+    };
+
+    struct worker_state;
+
+    /** fibers migrate between threads, this is read through current_worker after every switch */
+    static thread_local worker_state* tls_worker_;
+
+    std::vector<std::unique_ptr<fiber_slot>> fibers_;
+    std::vector<std::jthread> workers_;
+
+    std::mutex mutex_;
+    std::condition_variable_any work_available_;
+    std::condition_variable idle_;
+    std::deque<queued_job> jobs_;
+    /** fibers whose counter dropped to zero, resumed before new jobs are started */
+    std::deque<fiber_slot*> ready_fibers_;
+    std::vector<fiber_slot*> free_fibers_;
+    /** fibers registered as waiters on a counter, the scheduler is deadlocked once all of them are */
+    usize parked_fiber_count_ = 0;
+
+public:
+    explicit fiber_scheduler(const fiber_scheduler_config& config = {});
+    /** finishes the jobs that are still queued before the workers stop */
+    ~fiber_scheduler();
+
+    fiber_scheduler(const fiber_scheduler&) = delete;
+    fiber_scheduler(fiber_scheduler&&) = delete;
+    fiber_scheduler& operator=(const fiber_scheduler&) = delete;
+    fiber_scheduler& operator=(fiber_scheduler&&) = delete;
+
+    /** @param counter incremented now and decremented once the job returned, must outlive the job */
+    void run(job fn, fiber_counter* counter = nullptr);
+
+    /** parks the calling job until the counter is done, threads outside the scheduler block instead */
+    void wait(fiber_counter& counter) noexcept;
+
+    [[nodiscard]] u32 worker_count() const noexcept { return static_cast<u32>(workers_.size()); }
+    /** whether the calling code runs in a job of this scheduler */
+    [[nodiscard]] bool is_in_job() const noexcept;
+
+private:
+    [[nodiscard]] static worker_state* current_worker() noexcept;
+
+    void worker_loop(std::stop_token stop_token);
+    static void fiber_main(void* arg);
+
+    /** runs on the worker after the fiber it switched away from is fully suspended */
+    void complete_switch(worker_state& worker) noexcept;
+    /** @param was_parked whether the fiber was registered as a waiter and counted as parked */
+    void make_ready(fiber_slot* slot, bool was_parked) noexcept;
+    void finish_job(fiber_counter& counter) noexcept;
+    [[nodiscard]] bool is_idle() const noexcept;
+};
+
+} // namespace volkano
@@ -0,0 +1,162 @@
+/*
+ * Copyright (C) 2023 Emre Simsirli
+ *
+ * Licensed under GPLv3 or any later version.
+ * Refer to the included LICENSE file.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "core/int_types.h"
+
+namespace volkano {
+
+class job_system;
+
+/** number of jobs that are queued or running, the jobs of a counter can be waited on together */
+class job_counter {
+    friend job_system;
+
+    std::atomic<u32> count_ = 0;
+
+public:
+    job_counter() noexcept = default;
+    job_counter(const job_counter&) = delete;
+    job_counter& operator=(const job_counter&) = delete;
+
+    [[nodiscard]] bool is_done() const noexcept { return count_.load(std::memory_order_acquire) == 0; }
+};
+
+enum class job_priority : u8 {
+    normal,
+    /** long running work that nothing waits on within a frame, such as pipeline compiles */
+    background
+};
+
+struct job_system_stats {
+    u64 executed_count = 0;
+    /** jobs that were taken from the queue of another thread */
+    u64 stolen_count = 0;
+};
+
+/**
+ * Fixed set of worker threads that balance jobs by work stealing.
+ *
+ * Every worker owns a queue, jobs that a worker spawns go to the back of its own queue and it
+ * takes them back from there, so related work stays on a warm cache. An idle worker steals from
+ * the front of the other queues, which holds the oldest and usually largest jobs. Threads that are
+ * not workers submit to a shared queue that workers steal from as well.
+ *
+ * Waiting on a counter never blocks, the waiting thread runs queued jobs until the counter
+ * drops to zero. This is what allows jobs to spawn and wait on other jobs.
+ *
+ * Background jobs go to a queue of their own that only idle workers take from, a waiting thread
+ * never picks one up so a short wait cannot turn into running a long job inline.
+ */
+class job_system {
+public:
+    using job = std::function<void()>;
+
+private:
+    static constexpr usize cache_line_size = 64;
+
+    struct queued_job {
+        job fn;
+        job_counter* counter = nullptr;
+    };
+
+    struct alignas(cache_line_size) job_queue {
+        std::mutex mutex;
+        std::deque<queued_job> jobs;
+        std::atomic<u64> executed_count = 0;
+        std::atomic<u64> stolen_count = 0;
+    };
+
+    std::vector<std::jthread> workers_;
+    /** one per worker, the last one is shared by every thread that is not a worker */
+    std::unique_ptr<job_queue[]> queues_;
+    u32 queue_count_ = 0;
+    job_queue background_queue_;
+
+    std::atomic<u32> queued_count_ = 0;
+    std::atomic<u32> sleeping_count_ = 0;
+    std::mutex sleep_mutex_;
+    std::condition_variable_any wake_;
+
+public:
+    explicit job_system(u32 worker_count = default_worker_count());
+    /** runs the jobs that are still queued before the workers stop */
+    ~job_system();
+
+    job_system(const job_system&) = delete;
+    job_system(job_system&&) = delete;
+    job_system& operator=(const job_system&) = delete;
+    job_system& operator=(job_system&&) = delete;
+
+    /** @param counter incremented now and decremented once the job finished, must outlive the job */
+    void run(job fn, job_counter* counter = nullptr, job_priority priority = job_priority::normal);
+
+    /** runs queued normal priority jobs on the calling thread until every job of the counter finished */
+    void wait(const job_counter& counter) noexcept;
+
+    /**
+     * Calls fn(begin, end) for contiguous chunks of [begin, end) in parallel, returns when all are done.
+     * @param min_chunk_size chunks are never smaller than this, small ranges use fewer threads
+     */
+    template<typename Fn>
+    void parallel_for(u32 begin, u32 end, u32 min_chunk_size, Fn&& fn);
+
+    [[nodiscard]] u32 worker_count() const noexcept { return static_cast<u32>(workers_.size()); }
+    /** index of the calling worker in [0, worker_count), worker_count for any other thread */
+    [[nodiscard]] u32 current_queue_index() const noexcept;
+    [[nodiscard]] job_system_stats stats() const noexcept;
+
+    /** leaves one hardware thread to the main thread */
+    [[nodiscard]] static u32 default_worker_count() noexcept;
+
+private:
+    void worker_loop(std::stop_token stop_token, u32 queue_index);
+
+    /**
+     * Runs a single job from the own queue or a stolen one, false if there was none.
+     * @param allow_background falls back to the background queue when there is no other job
+     */
+    bool try_run_one(u32 queue_index, bool allow_background) noexcept;
+    [[nodiscard]] bool try_pop(u32 queue_index, queued_job& out_job) noexcept;
+    [[nodiscard]] bool try_steal(u32 queue_index, queued_job& out_job) noexcept;
+    [[nodiscard]] bool try_pop_background(queued_job& out_job) noexcept;
+};
+
+template<typename Fn>
+void job_system::parallel_for(const u32 begin, const u32 end, const u32 min_chunk_size, Fn&& fn)
+{
+    if (begin >= end) {
+        return;
+    }
+
+    // the calling thread takes a chunk as well
+    const u32 count = end - begin;
+    const u32 max_chunks = std::max(1u, count / std::max(1u, min_chunk_size));
+    const u32 chunk_count = std::min(worker_count() + 1, max_chunks);
+    const u32 chunk_size = (count + chunk_count - 1) / chunk_count;
+
+    job_counter counter;
+    for (u32 chunk_begin = begin + chunk_size; chunk_begin < end; chunk_begin += chunk_size) {
+        const u32 chunk_end = std::min(end, chunk_begin + chunk_size);
+        run([&fn, chunk_begin, chunk_end]() { fn(chunk_begin, chunk_end); }, &counter);
+    }
+    fn(begin, std::min(end, begin + chunk_size));
+    wait(counter);
+}
+
+} // namespace volkano
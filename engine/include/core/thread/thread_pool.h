@@ -0,0 +1,52 @@
+/*
+ * Copyright (C) 2023 Emre Simsirli
+ *
+ * Licensed under GPLv3 or any later version.
+ * Refer to the included LICENSE file.
+ */
+
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "core/int_types.h"
+#include "core/thread/job_system.h"
+
+namespace volkano {
+
+/** fixed number of worker threads that pull tasks from a shared fifo queue */
+class thread_pool {
+    std::vector<std::jthread> workers_;
+
+    std::mutex mutex_;
+    std::condition_variable_any task_available_;
+    std::condition_variable idle_;
+    std::deque<std::function<void()>> tasks_;
+    usize active_tasks_ = 0;
+
+public:
+    explicit thread_pool(u32 worker_count = job_system::default_worker_count());
+    ~thread_pool();
+
+    thread_pool(const thread_pool&) = delete;
+    thread_pool(thread_pool&&) = delete;
+    thread_pool& operator=(const thread_pool&) = delete;
+    thread_pool& operator=(thread_pool&&) = delete;
+
+    void enqueue(std::function<void()> task);
+
+    /** blocks until the queue is drained and no task is running */
+    void wait_idle();
+
+    [[nodiscard]] u32 worker_count() const noexcept { return static_cast<u32>(workers_.size()); }
+
+private:
+    void worker_loop(std::stop_token stop_token);
+};
+
+} // namespace volkano
@@ -0,0 +1,80 @@
+/*
+ * Copyright (C) 2023 Emre Simsirli
+ *
+ * Licensed under GPLv3 or any later version.
+ * Refer to the included LICENSE file.
+ */
+
+#pragma once
+
+#include <chrono>
+
+#include "core/int_types.h"
+#include "core/util/rolling_stats.h"
+
+namespace volkano {
+
+struct frame_pacer_config {
+    /** frames per second, 0 runs as fast as possible */
+    f64 target_frame_rate = 0.0;
+    /** the end of a wait is spun instead of slept, os sleeps overshoot by up to a scheduler tick */
+    std::chrono::microseconds spin_threshold{1500};
+};
+
+struct frame_pacer_stats {
+    static constexpr usize history_size = 128;
+
+    /** time from the start of a frame to its submission */
+    rolling_stats<history_size> cpu_ms;
+    /** time spent waiting for the start of a frame */
+    rolling_stats<history_size> wait_ms;
+    /**
+     * Time between the cpu starts of two frames, its deviation is the jitter of the pacing.
+     * This is not the present interval, the gpu and the present queue can still add their own.
+     */
+    rolling_stats<history_size> frame_start_interval_ms;
+    /** time from sampling input to the submission of the frame that reacts to it */
+    rolling_stats<history_size> input_latency_ms;
+    u64 frame_count = 0;
+};
+
+/**
+ * Holds frames back to a target rate.
+ *
+ * The wait happens at the start of a frame so that input is sampled as late as possible and
+ * the time from input to submission is just the cpu time of the frame. Deadlines advance by
+ * a fixed period, a frame that is late by more than a period restarts the schedule instead of
+ * rendering a burst of frames to catch up.
+ */
+class frame_pacer {
+public:
+    using clock = std::chrono::steady_clock;
+
+private:
+    frame_pacer_config config_;
+    clock::duration period_ = clock::duration::zero();
+    clock::time_point next_frame_begin_;
+    clock::time_point frame_begin_;
+    clock::time_point input_sampled_;
+    frame_pacer_stats stats_;
+
+public:
+    explicit frame_pacer(const frame_pacer_config& config = {}) noexcept;
+
+    void set_target_frame_rate(f64 target_frame_rate) noexcept;
+    [[nodiscard]] f64 target_frame_rate() const noexcept { return config_.target_frame_rate; }
+
+    /** blocks until the frame should start, sample input right after */
+    void begin_frame() noexcept;
+    /** input latency is measured from the last call in a frame */
+    void mark_input_sampled() noexcept { input_sampled_ = clock::now(); }
+    /** call once the frame is submitted */
+    void end_frame() noexcept;
+
+    [[nodiscard]] const frame_pacer_stats& stats() const noexcept { return stats_; }
+
+    /** sleeps until shortly before the deadline and spins for the rest */
+    static void wait_until(clock::time_point deadline, clock::duration spin_threshold) noexcept;
+};
+
+} // namespace volkano
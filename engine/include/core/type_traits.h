@@ -63,4 +63,14 @@ struct constness_as<To, const From>
 template<typename To, typename From>
 using constness_as_t = typename constness_as<To, From>::type;
 
+/**
+ * Whether moving an object and destroying the source can be done with a memcpy instead.
+ * Specialize for types that are not trivially copyable but do not care where they live.
+ */
+template<typename T>
+struct is_trivially_relocatable : std::is_trivially_copyable<T> {};
+
+template<typename T>
+constexpr inline bool is_trivially_relocatable_v = is_trivially_relocatable<T>::value;
+
 } // namespace volkano
@@ -0,0 +1,56 @@
+/*
+ * Copyright (C) 2023 Emre Simsirli
+ *
+ * Licensed under GPLv3 or any later version.
+ * Refer to the included LICENSE file.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <span>
+#include <string_view>
+#include <type_traits>
+
+#include "core/int_types.h"
+
+namespace volkano {
+
+inline constexpr u64 fnv1a_offset_basis = 14695981039346656037ull;
+inline constexpr u64 fnv1a_prime = 1099511628211ull;
+
+[[nodiscard]] inline u64 hash_bytes(const std::span<const std::byte> bytes, u64 seed = fnv1a_offset_basis) noexcept
+{
+    for (const std::byte b : bytes) {
+        seed ^= static_cast<u64>(b);
+        seed *= fnv1a_prime;
+    }
+    return seed;
+}
+
+[[nodiscard]] inline u64 hash_string(const std::string_view str, const u64 seed = fnv1a_offset_basis) noexcept
+{
+    return hash_bytes(std::as_bytes(std::span{str.data(), str.size()}), seed);
+}
+
+/** hashes the object representation, T must not have padding bytes */
+template<typename T>
+    requires std::is_trivially_copyable_v<T>
+[[nodiscard]] u64 hash_value(const T& value, const u64 seed = fnv1a_offset_basis) noexcept
+{
+    return hash_bytes(std::as_bytes(std::span{&value, 1}), seed);
+}
+
+template<typename T>
+    requires std::is_trivially_copyable_v<T>
+[[nodiscard]] u64 hash_values(const std::span<const T> values, const u64 seed = fnv1a_offset_basis) noexcept
+{
+    return hash_bytes(std::as_bytes(values), seed);
+}
+
+[[nodiscard]] constexpr u64 hash_combine(const u64 seed, const u64 value) noexcept
+{
+    return seed ^ (value + 0x9e3779b97f4a7c15ull + (seed << 6) + (seed >> 2));
+}
+
+} // namespace volkano
@@ -0,0 +1,97 @@
+/*
+ * Copyright (C) 2023 Emre Simsirli
+ *
+ * Licensed under GPLv3 or any later version.
+ * Refer to the included LICENSE file.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <limits>
+
+#include "core/int_types.h"
+
+namespace volkano {
+
+/** keeps the last Size samples and reports simple statistics over them */
+template<usize Size>
+    requires (Size != 0)
+class rolling_stats {
+    std::array<f64, Size> samples_{};
+    usize head_ = 0;
+    usize count_ = 0;
+
+public:
+    constexpr void add(const f64 sample) noexcept
+    {
+        samples_[head_] = sample;
+        head_ = (head_ + 1) % Size;
+        count_ = std::min(count_ + 1, Size);
+    }
+
+    constexpr void reset() noexcept
+    {
+        head_ = 0;
+        count_ = 0;
+    }
+
+    [[nodiscard]] constexpr usize size() const noexcept { return count_; }
+    [[nodiscard]] constexpr bool empty() const noexcept { return count_ == 0; }
+    [[nodiscard]] static constexpr usize capacity() noexcept { return Size; }
+
+    [[nodiscard]] constexpr f64 last() const noexcept
+    {
+        return empty() ? 0.0 : samples_[(head_ + Size - 1) % Size];
+    }
+
+    [[nodiscard]] constexpr f64 average() const noexcept
+    {
+        if (empty()) {
+            return 0.0;
+        }
+
+        f64 sum = 0.0;
+        for (usize i = 0; i < count_; ++i) {
+            sum += samples_[i];
+        }
+        return sum / static_cast<f64>(count_);
+    }
+
+    /** population standard deviation, the jitter of timing samples */
+    [[nodiscard]] f64 standard_deviation() const noexcept
+    {
+        if (empty()) {
+            return 0.0;
+        }
+
+        const f64 mean = average();
+        f64 sum = 0.0;
+        for (usize i = 0; i < count_; ++i) {
+            sum += (samples_[i] - mean) * (samples_[i] - mean);
+        }
+        return std::sqrt(sum / static_cast<f64>(count_));
+    }
+
+    [[nodiscard]] constexpr f64 min() const noexcept
+    {
+        f64 result = std::numeric_limits<f64>::max();
+        for (usize i = 0; i < count_; ++i) {
+            result = std::min(result, samples_[i]);
+        }
+        return empty() ? 0.0 : result;
+    }
+
+    [[nodiscard]] constexpr f64 max() const noexcept
+    {
+        f64 result = std::numeric_limits<f64>::lowest();
+        for (usize i = 0; i < count_; ++i) {
+            result = std::max(result, samples_[i]);
+        }
+        return empty() ? 0.0 : result;
+    }
+};
+
+} // namespace volkano
@@ -7,6 +7,7 @@
 
 #pragma once
 
+#include <functional>
 #include <variant>
 
 namespace volkano {
@@ -7,11 +7,15 @@
 
 #pragma once
 
+#include <limits>
 #include <span>
+#include <variant>
 #include <vector>
 
 #include <range/v3/range/concepts.hpp>
 
+#include "core/assert.h"
+#include "core/util/variant_visit_nt.h"
 #include "renderer/vertex.h"
 
 namespace volkano {
@@ -29,18 +33,60 @@ struct mesh_buffer {
     [[nodiscard]] usize size_in_bytes() const noexcept { return buf.size() * sizeof(T); }
 };
 
+/** per instance data of instanced draws, mirrors the instance attributes of triangle_instanced.vert */
+struct mesh_instance {
+    vec3f translation;
+    f32 scale = 1.f;
+    vec3f color = vec3f::one();
+};
+
+using mesh_index_buffer = std::variant<mesh_buffer<u16>, mesh_buffer<u32>>;
+
 class mesh {
+    /** 16-bit indices halve index fetch bandwidth, 32-bit ones are only used when they can't address every vertex */
+    static constexpr usize max_u16_index_vertex_count = usize{std::numeric_limits<u16>::max()} + 1;
+
     mesh_buffer<vertex> vertices_;
-    mesh_buffer<u16> indices_;
+    mesh_index_buffer indices_;
 
 public:
     mesh() noexcept = default;
     mesh(const ranges::range auto& vertices, const ranges::range auto& indices)
       : vertices_{vertices},
-        indices_{indices} {}
+        indices_{make_index_buffer(vertices_.size(), indices)} {}
 
     [[nodiscard]] const mesh_buffer<vertex>& get_vertex_buffer() const noexcept { return vertices_; }
-    [[nodiscard]] const mesh_buffer<u16>& get_index_buffer() const noexcept { return indices_; }
+    [[nodiscard]] const mesh_index_buffer& get_index_buffer() const noexcept { return indices_; }
+
+    [[nodiscard]] usize index_count() const noexcept
+    {
+        return visit_nt(indices_, [](const auto& buffer) { return buffer.size(); });
+    }
+
+    [[nodiscard]] bool has_indices() const noexcept { return index_count() != 0; }
+
+    /** indices a draw of the mesh consumes, or vertices if it is not indexed */
+    [[nodiscard]] usize element_count() const noexcept { return has_indices() ? index_count() : vertices_.size(); }
+
+private:
+    static mesh_index_buffer make_index_buffer(const usize vertex_count, const ranges::range auto& indices) noexcept
+    {
+        if (vertex_count <= max_u16_index_vertex_count) {
+            return to_index_buffer<u16>(vertex_count, indices);
+        }
+        return to_index_buffer<u32>(vertex_count, indices);
+    }
+
+    template<typename Index>
+    static mesh_buffer<Index> to_index_buffer(const usize vertex_count, const ranges::range auto& indices) noexcept
+    {
+        mesh_buffer<Index> buffer;
+        for (const auto index : indices) {
+            VKE_ASSERT_MSG(static_cast<usize>(index) < vertex_count, "index {} is out of {} vertices", index, vertex_count);
+            buffer.buf.push_back(static_cast<Index>(index));
+        }
+        return buffer;
+    }
 };
 
 } // namespace volkano
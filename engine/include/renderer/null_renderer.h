@@ -16,6 +16,7 @@ public:
     void initialize() noexcept override {}
     void on_window_resize() noexcept override {}
     void render() noexcept override {}
+    void draw_instanced(std::span<const mesh_instance>) noexcept override {}
 };
 
 } // namespace volkano
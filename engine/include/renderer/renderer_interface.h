@@ -7,6 +7,11 @@
 
 #pragma once
 
+#include <span>
+
+#include "core/filesystem/filesystem.h"
+#include "renderer/mesh.h"
+
 namespace volkano {
 
 class renderer_interface {
@@ -14,7 +19,16 @@ public:
     virtual ~renderer_interface() = default;
     virtual void initialize() noexcept = 0;
     virtual void on_window_resize() noexcept = 0;
+    /** blocks until a frame can be recorded, input sampled afterwards is as fresh as possible */
+    virtual void wait_for_frame() noexcept {}
     virtual void render() noexcept = 0;
+    /** called instead of render when no frame is rendered this tick, drops what was queued for it */
+    virtual void skip_frame() noexcept {}
+    /** writes the next rendered frame to the path as a ppm, renderers that cannot capture ignore it */
+    virtual void capture_frame(fs::path /*path*/) noexcept {}
+
+    /** queues instances which are drawn with a single draw call in the next rendered frame */
+    virtual void draw_instanced(std::span<const mesh_instance> instances) noexcept = 0;
 };
 
 } // namespace volkano
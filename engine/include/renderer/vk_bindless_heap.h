@@ -0,0 +1,97 @@
+/*
+ * Copyright (C) 2023 Emre Simsirli
+ *
+ * Licensed under GPLv3 or any later version.
+ * Refer to the included LICENSE file.
+ */
+
+#pragma once
+
+#include <array>
+#include <limits>
+#include <type_traits>
+#include <vector>
+
+#include "core/int_types.h"
+#include "renderer/vk_include.h"
+
+namespace volkano {
+
+struct vk_bindless_heap_config {
+    u32 max_storage_buffers = 16384;
+    u32 max_sampled_images = 16384;
+    u32 max_samplers = 256;
+};
+
+/** binding of each resource type in the heap set, mirrored in shaders/bindless.glsl */
+enum class vk_bindless_type : u32 { storage_buffer, sampled_image, sampler, count };
+
+/** index of a resource in its binding array, shaders receive these through push constants */
+struct vk_bindless_handle {
+    static constexpr u32 invalid_index = std::numeric_limits<u32>::max();
+
+    u32 index = invalid_index;
+
+    [[nodiscard]] bool is_valid() const noexcept { return index != invalid_index; }
+    bool operator==(const vk_bindless_handle&) const noexcept = default;
+};
+
+/**
+ * One update-after-bind descriptor set that holds every storage buffer, sampled image and sampler.
+ *
+ * The set and a single pipeline layout are shared by all pipelines, so the set is bound once per
+ * command buffer and draws only differ in their push constants. Released slots are reused right
+ * away, resources must be released only once the gpu no longer accesses them.
+ */
+class vk_bindless_heap {
+public:
+    static constexpr u32 push_constant_size = 128;
+    static constexpr vk::ShaderStageFlags push_constant_stages =
+      vk::ShaderStageFlagBits::eVertex | vk::ShaderStageFlagBits::eFragment | vk::ShaderStageFlagBits::eCompute;
+
+private:
+    struct slot_allocator {
+        u32 capacity = 0;
+        u32 next_index = 0;
+        std::vector<u32> free_indices;
+    };
+
+    vk::Device device_ = nullptr;
+    vk::DescriptorSetLayout set_layout_ = nullptr;
+    vk::DescriptorPool pool_ = nullptr;
+    vk::DescriptorSet set_ = nullptr;
+    vk::PipelineLayout pipeline_layout_ = nullptr;
+
+    std::array<slot_allocator, static_cast<usize>(vk_bindless_type::count)> slots_;
+
+public:
+    void initialize(vk::Device device, vk::PhysicalDevice physical_device, const vk_bindless_heap_config& config = {}) noexcept;
+    void destroy() noexcept;
+
+    [[nodiscard]] vk_bindless_handle register_storage_buffer(vk::Buffer buffer,
+      vk::DeviceSize offset = 0, vk::DeviceSize range = VK_WHOLE_SIZE) noexcept;
+    [[nodiscard]] vk_bindless_handle register_sampled_image(vk::ImageView view,
+      vk::ImageLayout layout = vk::ImageLayout::eShaderReadOnlyOptimal) noexcept;
+    [[nodiscard]] vk_bindless_handle register_sampler(vk::Sampler sampler) noexcept;
+
+    void release(vk_bindless_type type, vk_bindless_handle handle) noexcept;
+
+    /** binds the heap set, once per bind point for each command buffer is enough */
+    void bind(vk::CommandBuffer cmd, vk::PipelineBindPoint bind_point) const noexcept;
+
+    template<typename T>
+        requires (std::is_trivially_copyable_v<T> && sizeof(T) <= push_constant_size)
+    void push_constants(const vk::CommandBuffer cmd, const T& constants) const noexcept
+    {
+        cmd.pushConstants(pipeline_layout_, push_constant_stages, /*offset=*/0, sizeof(T), &constants);
+    }
+
+    /** layout of every pipeline that reads resources through the heap */
+    [[nodiscard]] vk::PipelineLayout pipeline_layout() const noexcept { return pipeline_layout_; }
+    [[nodiscard]] u32 capacity(vk_bindless_type type) const noexcept { return slots_[static_cast<usize>(type)].capacity; }
+
+private:
+    [[nodiscard]] vk_bindless_handle allocate(vk_bindless_type type) noexcept;
+};
+
+} // namespace volkano
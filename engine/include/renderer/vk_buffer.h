@@ -0,0 +1,44 @@
+/*
+ * Copyright (C) 2023 Emre Simsirli
+ *
+ * Licensed under GPLv3 or any later version.
+ * Refer to the included LICENSE file.
+ */
+
+#pragma once
+
+#include <span>
+
+#include "core/int_types.h"
+#include "renderer/vk_include.h"
+
+namespace volkano {
+
+struct vk_buffer {
+    vk::Buffer handle = nullptr;
+    vma::Allocation allocation = nullptr;
+    vk::DeviceSize size = 0;
+    vk::SharingMode sharing_mode = vk::SharingMode::eExclusive;
+
+    [[nodiscard]] explicit operator bool() const noexcept { return handle; }
+};
+
+/**
+ * creates a buffer that lives in vram, its contents must be filled through a transfer
+ * @param concurrent_family_indices unique queue families that access the buffer without ownership transfers,
+ *        the buffer is exclusive when less than two are given
+ */
+[[nodiscard]] vk_buffer create_device_local_buffer(vma::Allocator allocator,
+  vk::DeviceSize size, vk::BufferUsageFlags usage, std::span<const u32> concurrent_family_indices = {}) noexcept;
+
+/** creates a persistently mapped buffer that the cpu writes sequentially */
+[[nodiscard]] vk_buffer create_host_visible_buffer(vma::Allocator allocator,
+  vk::DeviceSize size, vk::BufferUsageFlags usage, void*& out_mapped_data) noexcept;
+
+/** creates a persistently mapped buffer the gpu writes into and the cpu reads back, must be invalidated before reading */
+[[nodiscard]] vk_buffer create_readback_buffer(vma::Allocator allocator,
+  vk::DeviceSize size, void*& out_mapped_data) noexcept;
+
+void destroy_buffer(vma::Allocator allocator, vk_buffer& buffer) noexcept;
+
+} // namespace volkano
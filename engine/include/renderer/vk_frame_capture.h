@@ -0,0 +1,92 @@
+/*
+ * Copyright (C) 2023 Emre Simsirli
+ *
+ * Licensed under GPLv3 or any later version.
+ * Refer to the included LICENSE file.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <deque>
+#include <memory>
+#include <optional>
+
+#include "core/filesystem/filesystem.h"
+#include "core/image/ppm.h"
+#include "core/int_types.h"
+#include "core/thread/thread_pool.h"
+#include "renderer/vk_buffer.h"
+#include "renderer/vk_include.h"
+#include "renderer/vk_render_graph.h"
+
+namespace volkano {
+
+struct vk_frame_capture_stats {
+    u64 captured_count = 0;
+    /** continuous captures that were skipped because the encoder fell behind */
+    u64 dropped_count = 0;
+};
+
+/**
+ * Copies rendered frames into host visible buffers and writes them to disk without stalling.
+ *
+ * Every frame in flight owns a readback buffer. The copy is recorded into the frame as a render
+ * graph pass, the buffer is handed to a dedicated encoder thread once the frame slot comes around
+ * again and its fence signaled, so the main thread never waits for the gpu nor for the encoding.
+ * A slot is skipped until the encoder is done reading its buffer.
+ */
+class vk_frame_capture {
+    struct slot {
+        vk_buffer buffer;
+        void* mapped_data = nullptr;
+
+        /** copy is recorded, waiting for the frame's fence */
+        bool is_pending = false;
+        fs::path path;
+        vk::Extent2D extent;
+        pixel_layout layout = pixel_layout::rgba8;
+
+        /** encoder still reads the mapped buffer */
+        std::atomic<bool> is_encoding = false;
+    };
+
+    vma::Allocator allocator_ = nullptr;
+    std::unique_ptr<slot[]> slots_;
+    u32 slot_count_ = 0;
+
+    /** a single thread so that captures are written in order and never compete with frame work */
+    std::unique_ptr<thread_pool> encoder_;
+
+    std::deque<fs::path> requests_;
+    fs::path continuous_directory_;
+    u64 continuous_index_ = 0;
+
+    vk_frame_capture_stats stats_;
+
+public:
+    void initialize(vma::Allocator allocator, u32 frame_count) noexcept;
+    /** waits for the encoder, the gpu must no longer use the readback buffers */
+    void destroy() noexcept;
+
+    /** captures the next frame that has a free slot */
+    void request(fs::path path) noexcept;
+    /** captures every frame into the directory as frame_NNNNNN.ppm, an empty path stops it */
+    void set_continuous(fs::path directory) noexcept;
+
+    /**
+     * Adds a pass that copies the image into the readback buffer of the frame if a capture is due.
+     * @return whether a copy was added
+     */
+    bool add_pass(vk_render_graph& graph, vk_rg_resource image, u32 frame_index) noexcept;
+
+    /** hands the copy of the frame slot to the encoder, the fence of the frame must have signaled */
+    void resolve(u32 frame_index) noexcept;
+
+    [[nodiscard]] const vk_frame_capture_stats& stats() const noexcept { return stats_; }
+
+    /** byte order of the format, nullopt if it cannot be encoded */
+    [[nodiscard]] static std::optional<pixel_layout> layout_of(vk::Format format) noexcept;
+};
+
+} // namespace volkano
@@ -0,0 +1,116 @@
+/*
+ * Copyright (C) 2023 Emre Simsirli
+ *
+ * Licensed under GPLv3 or any later version.
+ * Refer to the included LICENSE file.
+ */
+
+#pragma once
+
+#include <array>
+#include <span>
+
+#include "core/container/static_vector.h"
+#include "core/int_types.h"
+#include "core/math/frustum.h"
+#include "renderer/vk_bindless_heap.h"
+#include "renderer/vk_buffer.h"
+#include "renderer/vk_include.h"
+#include "renderer/vk_upload_context.h"
+
+namespace volkano {
+
+/** per object data in the object buffer, mirrors object_data in shaders/object_data.glsl */
+struct vk_gpu_object {
+    vec3f translation;
+    f32 scale = 1.f;
+    sphere bounds;
+};
+
+static_assert(sizeof(vk_gpu_object) == 8 * sizeof(f32));
+
+struct vk_gpu_culling_config {
+    u32 max_objects = 16384;
+};
+
+/**
+ * GPU driven frustum culling.
+ *
+ * Object transforms and bounds live in a storage buffer. Each frame a compute pass culls them
+ * against a frustum and compacts the visible ones into an indirect draw buffer, the graphics
+ * pass then draws all of them with a single drawIndexedIndirectCount, or drawIndirectCount for
+ * unindexed meshes. Buffers that both queues
+ * touch are shared concurrently so no ownership transfers are needed between them. Shaders reach
+ * the buffers through the bindless heap.
+ */
+class vk_gpu_culling {
+public:
+    static constexpr u32 max_frames = 3;
+
+private:
+    /** mirrors cull_constants in shaders/cull.comp */
+    struct cull_push_constants {
+        std::array<plane, frustum::plane_count> frustum_planes;
+        u32 object_count;
+        u32 element_count;
+        u32 is_indexed;
+        u32 objects_index;
+        u32 draw_commands_index;
+        u32 draw_count_index;
+    };
+
+    /** mirrors draw_constants in shaders/triangle.vert */
+    struct draw_push_constants {
+        u32 objects_index;
+    };
+
+    struct frame_resources {
+        vk_buffer draw_commands;
+        vk_buffer draw_count;
+        vk_bindless_handle draw_commands_handle;
+        vk_bindless_handle draw_count_handle;
+    };
+
+    vk::Device device_ = nullptr;
+    vma::Allocator allocator_ = nullptr;
+    vk_bindless_heap* heap_ = nullptr;
+    vk_gpu_culling_config config_;
+
+    vk::Pipeline pipeline_ = nullptr;
+
+    vk_buffer objects_;
+    vk_bindless_handle objects_handle_;
+    u32 object_count_ = 0;
+    static_vector<frame_resources, max_frames> frames_;
+
+public:
+    /**
+     * @param concurrent_family_indices unique queue families that upload, cull and draw
+     */
+    void initialize(vk::Device device, vma::Allocator allocator, vk::PipelineCache pipeline_cache, vk_bindless_heap& heap,
+      std::span<const u32> concurrent_family_indices, u32 frame_count, const vk_gpu_culling_config& config = {}) noexcept;
+    void destroy() noexcept;
+
+    /** replaces every object, uploaded through the upload context */
+    void set_objects(vk_upload_context& upload_context, std::span<const vk_gpu_object> objects) noexcept;
+
+    /**
+     * Records the culling pass into a compute queue command buffer, binds the heap for compute.
+     * @param element_count indices of the drawn mesh, or its vertices if it is not indexed
+     */
+    void record_cull(vk::CommandBuffer cmd, u32 frame_index, const frustum& view_frustum,
+      u32 element_count, bool is_indexed) const noexcept;
+
+    /**
+     * Records the indirect draw, the heap and vertex buffers must already be bound and so must the
+     * index buffer if the draw is indexed. is_indexed must match the one the culling pass recorded with.
+     */
+    void record_draw(vk::CommandBuffer cmd, u32 frame_index, bool is_indexed) const noexcept;
+
+    [[nodiscard]] u32 object_count() const noexcept { return object_count_; }
+
+    /** stages the graphics queue waits on the culling pass with */
+    [[nodiscard]] static constexpr vk::PipelineStageFlags2 consumer_stages() noexcept { return vk::PipelineStageFlagBits2::eDrawIndirect; }
+};
+
+} // namespace volkano
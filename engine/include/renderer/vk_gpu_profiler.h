@@ -0,0 +1,139 @@
+/*
+ * Copyright (C) 2023 Emre Simsirli
+ *
+ * Licensed under GPLv3 or any later version.
+ * Refer to the included LICENSE file.
+ */
+
+#pragma once
+
+#include <limits>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "core/int_types.h"
+#include "core/util/rolling_stats.h"
+#include "renderer/vk_include.h"
+
+namespace volkano {
+
+struct vk_gpu_profiler_config {
+    u32 max_scopes_per_frame = 64;
+    /** wrap scopes in VK_EXT_debug_utils labels, the extension must be enabled on the instance */
+    bool debug_labels = false;
+    /** requires the pipelineStatisticsQuery and inheritedQueries features */
+    bool pipeline_statistics = false;
+};
+
+/** results of a pipeline statistics query, in the bit order of the collected statistics */
+struct vk_gpu_pipeline_statistics {
+    u64 input_assembly_vertices = 0;
+    u64 input_assembly_primitives = 0;
+    u64 vertex_shader_invocations = 0;
+    u64 fragment_shader_invocations = 0;
+    u64 compute_shader_invocations = 0;
+};
+
+struct vk_gpu_scope_stats {
+    static constexpr usize history_size = 128;
+
+    std::string name;
+    rolling_stats<history_size> gpu_ms;
+    /** last resolved results, stays zero unless the scope collects statistics */
+    vk_gpu_pipeline_statistics statistics;
+};
+
+/**
+ * Measures named command buffer regions with timestamp queries.
+ *
+ * Every frame in flight has its own query pools. Results of a frame are read back the next time
+ * its slot comes around, after its fence signaled, so reading them never stalls. Scopes may nest
+ * and may be recorded into any queue of the frame that supports timestamps.
+ */
+class vk_gpu_profiler {
+public:
+    static constexpr u32 invalid_scope = std::numeric_limits<u32>::max();
+
+private:
+    static constexpr u32 statistics_count = 5;
+    static constexpr vk::QueryPipelineStatisticFlags statistics_flags =
+      vk::QueryPipelineStatisticFlagBits::eInputAssemblyVertices
+      | vk::QueryPipelineStatisticFlagBits::eInputAssemblyPrimitives
+      | vk::QueryPipelineStatisticFlagBits::eVertexShaderInvocations
+      | vk::QueryPipelineStatisticFlagBits::eFragmentShaderInvocations
+      | vk::QueryPipelineStatisticFlagBits::eComputeShaderInvocations;
+
+    struct recorded_scope {
+        u32 stats_index = 0;
+        u32 timestamp_query = 0;
+        u32 statistics_query = invalid_scope;
+    };
+
+    struct frame_queries {
+        vk::QueryPool timestamp_pool = nullptr;
+        vk::QueryPool statistics_pool = nullptr;
+        std::vector<recorded_scope> scopes;
+        u32 statistics_query_count = 0;
+    };
+
+    vk::Device device_ = nullptr;
+    vk_gpu_profiler_config config_;
+    f64 timestamp_period_ns_ = 1.0;
+    u64 timestamp_mask_ = 0;
+
+    std::vector<frame_queries> frames_;
+    u32 current_frame_ = 0;
+    /** statistics query that is active in the frame, only one may be active at a time */
+    u32 active_statistics_scope_ = invalid_scope;
+
+    std::vector<vk_gpu_scope_stats> scope_stats_;
+    std::vector<u64> results_;
+
+public:
+    /**
+     * @param timestamp_valid_bits smallest timestampValidBits of the queue families that record scopes,
+     *  timing is disabled if it is zero
+     */
+    void initialize(vk::Device device, vk::PhysicalDevice physical_device, u32 timestamp_valid_bits,
+      u32 frame_count, const vk_gpu_profiler_config& config = {}) noexcept;
+    void destroy() noexcept;
+
+    /** resolves the previous results of the frame slot and resets its queries, its fence must have signaled */
+    void begin_frame(u32 frame_index) noexcept;
+
+    /** @return id that is passed to end_scope, scopes beyond the per frame capacity are only labeled */
+    [[nodiscard]] u32 begin_scope(vk::CommandBuffer cmd, std::string_view name, bool collect_statistics = false) noexcept;
+    void end_scope(vk::CommandBuffer cmd, u32 scope_id) noexcept;
+
+    /** statistics a secondary command buffer must inherit when it executes within the current scopes */
+    [[nodiscard]] vk::QueryPipelineStatisticFlags inherited_statistics() const noexcept;
+
+    [[nodiscard]] const std::vector<vk_gpu_scope_stats>& scope_stats() const noexcept { return scope_stats_; }
+    [[nodiscard]] const vk_gpu_scope_stats* find_scope_stats(std::string_view name) const noexcept;
+    [[nodiscard]] bool is_timing_enabled() const noexcept { return !frames_.empty(); }
+
+private:
+    [[nodiscard]] u32 find_or_add_scope_stats(std::string_view name) noexcept;
+};
+
+/** profiles the lifetime of the object */
+class vk_gpu_scope {
+    vk_gpu_profiler& profiler_;
+    vk::CommandBuffer cmd_;
+    u32 scope_id_;
+
+public:
+    vk_gpu_scope(vk_gpu_profiler& profiler, const vk::CommandBuffer cmd, const std::string_view name,
+      const bool collect_statistics = false) noexcept
+      : profiler_{profiler},
+        cmd_{cmd},
+        scope_id_{profiler.begin_scope(cmd, name, collect_statistics)} {}
+
+    ~vk_gpu_scope() { profiler_.end_scope(cmd_, scope_id_); }
+
+    vk_gpu_scope(const vk_gpu_scope&) = delete;
+    vk_gpu_scope& operator=(const vk_gpu_scope&) = delete;
+};
+
+} // namespace volkano
@@ -0,0 +1,63 @@
+/*
+ * Copyright (C) 2023 Emre Simsirli
+ *
+ * Licensed under GPLv3 or any later version.
+ * Refer to the included LICENSE file.
+ */
+
+#pragma once
+
+#include <functional>
+#include <vector>
+
+#include "core/int_types.h"
+#include "core/thread/job_system.h"
+#include "renderer/vk_include.h"
+
+namespace volkano {
+
+/**
+ * Records a range of work into secondary command buffers on several threads.
+ *
+ * Every frame in flight has one command pool per recording slot, a slot is only ever recorded by a
+ * single thread at a time so the pools need no locking. The range is split into contiguous chunks,
+ * the calling thread records the first chunk while jobs record the rest, and the secondaries
+ * are then executed in order from the primary so the draw order stays the same as serial recording.
+ */
+class vk_parallel_recorder {
+public:
+    /** records items [begin, end) into a secondary that already inherits the rendering state */
+    using record_fn = std::function<void(vk::CommandBuffer cmd, u32 begin, u32 end)>;
+
+private:
+    struct slot {
+        vk::CommandPool pool = nullptr;
+        vk::CommandBuffer cmd = nullptr;
+    };
+
+    vk::Device device_ = nullptr;
+    u32 slot_count_ = 0;
+    /** frame major, slot_count_ slots per frame */
+    std::vector<slot> slots_;
+
+public:
+    void initialize(vk::Device device, u32 queue_family_index, u32 frame_count, u32 slot_count) noexcept;
+    void destroy() noexcept;
+
+    /** resets the pools of a frame, its previous submission must have completed */
+    void reset(u32 frame_index) noexcept;
+
+    /**
+     * Must be called between beginRendering with secondary command buffer contents and endRendering.
+     * @param min_items_per_slot chunks are never made smaller than this, small ranges use fewer threads
+     * @param inherited_statistics pipeline statistics of the query that is active in the primary, if any
+     */
+    void record(vk::CommandBuffer primary, u32 frame_index, job_system& jobs,
+      const vk::CommandBufferInheritanceRenderingInfo& rendering_info,
+      u32 item_count, u32 min_items_per_slot, const record_fn& record_range,
+      vk::QueryPipelineStatisticFlags inherited_statistics = {}) noexcept;
+
+    [[nodiscard]] u32 slot_count() const noexcept { return slot_count_; }
+};
+
+} // namespace volkano
@@ -0,0 +1,38 @@
+/*
+ * Copyright (C) 2023 Emre Simsirli
+ *
+ * Licensed under GPLv3 or any later version.
+ * Refer to the included LICENSE file.
+ */
+
+#pragma once
+
+#include "core/filesystem/filesystem.h"
+#include "renderer/vk_include.h"
+
+namespace volkano {
+
+/**
+ * VkPipelineCache that persists between runs.
+ *
+ * The blob on disk is only used if its header matches the current physical device,
+ * otherwise the cache starts empty and is overwritten on shutdown.
+ */
+class vk_pipeline_cache {
+    vk::Device device_ = nullptr;
+    vk::PipelineCache cache_ = nullptr;
+    fs::path path_;
+    bool loaded_from_disk_ = false;
+
+public:
+    void initialize(vk::Device device, vk::PhysicalDevice physical_device, fs::path path) noexcept;
+    /** saves the cache to disk and destroys it */
+    void destroy() noexcept;
+
+    void save() const noexcept;
+
+    [[nodiscard]] vk::PipelineCache get() const noexcept { return cache_; }
+    [[nodiscard]] bool was_loaded_from_disk() const noexcept { return loaded_from_disk_; }
+};
+
+} // namespace volkano
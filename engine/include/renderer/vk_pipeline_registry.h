@@ -0,0 +1,140 @@
+/*
+ * Copyright (C) 2023 Emre Simsirli
+ *
+ * Licensed under GPLv3 or any later version.
+ * Refer to the included LICENSE file.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <deque>
+#include <limits>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "core/container/static_vector.h"
+#include "core/filesystem/filesystem.h"
+#include "core/int_types.h"
+#include "core/thread/job_system.h"
+#include "renderer/vk_include.h"
+
+namespace volkano {
+
+struct vk_vertex_layout {
+    static_vector<vk::VertexInputBindingDescription, 4> bindings;
+    static_vector<vk::VertexInputAttributeDescription, 8> attributes;
+};
+
+/** full state a graphics pipeline is created and deduplicated with */
+struct vk_graphics_pipeline_desc {
+    fs::path vertex_shader_path;
+    fs::path fragment_shader_path;
+    vk_vertex_layout vertex_layout;
+
+    vk::PrimitiveTopology topology = vk::PrimitiveTopology::eTriangleList;
+    vk::PolygonMode polygon_mode = vk::PolygonMode::eFill;
+    vk::CullModeFlags cull_mode = vk::CullModeFlagBits::eBack;
+    vk::FrontFace front_face = vk::FrontFace::eClockwise;
+
+    vk::PipelineColorBlendAttachmentState blend_state{
+      .blendEnable = false,
+      .srcColorBlendFactor = vk::BlendFactor::eOne,
+      .dstColorBlendFactor = vk::BlendFactor::eZero,
+      .colorBlendOp = vk::BlendOp::eAdd,
+      .srcAlphaBlendFactor = vk::BlendFactor::eOne,
+      .dstAlphaBlendFactor = vk::BlendFactor::eZero,
+      .alphaBlendOp = vk::BlendOp::eAdd,
+      .colorWriteMask = vk::ColorComponentFlagBits::eR | vk::ColorComponentFlagBits::eG
+        | vk::ColorComponentFlagBits::eB | vk::ColorComponentFlagBits::eA
+    };
+
+    vk::PipelineLayout layout = nullptr;
+
+    /** attachment formats of the dynamic rendering pass the pipeline is used in */
+    static_vector<vk::Format, 4> color_formats;
+    vk::Format depth_format = vk::Format::eUndefined;
+
+    bool depth_test_enable = false;
+    bool depth_write_enable = false;
+    vk::CompareOp depth_compare_op = vk::CompareOp::eLess;
+};
+
+struct vk_pipeline_handle {
+    static constexpr u32 invalid_index = std::numeric_limits<u32>::max();
+
+    u32 index = invalid_index;
+
+    [[nodiscard]] bool is_valid() const noexcept { return index != invalid_index; }
+    bool operator==(const vk_pipeline_handle&) const noexcept = default;
+};
+
+enum class vk_pipeline_compile_mode : u8 { sync, async };
+
+/**
+ * Owns every graphics pipeline of the renderer.
+ *
+ * Requests are keyed by a hash of the full pipeline state including the SPIR-V of the shaders,
+ * identical requests share the same pipeline, the state itself is compared on a hash hit. Async requests are compiled on worker threads and
+ * resolve to the fallback pipeline until they are ready.
+ */
+class vk_pipeline_registry {
+    struct shader_code {
+        std::vector<u8> spirv;
+        u64 hash = 0;
+    };
+
+    struct entry {
+        u64 hash = 0;
+        /** compared on a hash hit so that colliding requests do not share a pipeline */
+        vk_graphics_pipeline_desc desc;
+        std::shared_ptr<const shader_code> vert;
+        std::shared_ptr<const shader_code> frag;
+        std::string debug_name;
+        std::atomic<VkPipeline> pipeline = VK_NULL_HANDLE;
+    };
+
+    vk::Device device_ = nullptr;
+    vk::PipelineCache cache_ = nullptr;
+    job_system* jobs_ = nullptr;
+
+    std::unordered_map<std::string, std::shared_ptr<const shader_code>> shader_codes_;
+
+    // only the render thread touches the containers, workers write into the atomic of their own entry
+    std::deque<entry> entries_;
+    std::unordered_multimap<u64, u32> hash_to_index_;
+    std::vector<u32> compiling_indices_;
+    std::atomic<u32> compiling_count_ = 0;
+    job_counter compile_jobs_;
+
+    vk_pipeline_handle fallback_;
+
+public:
+    void initialize(vk::Device device, vk::PipelineCache cache, job_system& jobs) noexcept;
+    /** waits for in flight compilations and destroys all pipelines */
+    void destroy() noexcept;
+
+    [[nodiscard]] vk_pipeline_handle request(const vk_graphics_pipeline_desc& desc,
+      vk_pipeline_compile_mode mode = vk_pipeline_compile_mode::async) noexcept;
+
+    /** pipeline that is handed out while the requested one is still compiling, must be compiled synchronously */
+    void set_fallback(vk_pipeline_handle handle) noexcept;
+
+    /** logs pipelines that finished compiling since the last call, call from the render thread */
+    void update() noexcept;
+
+    [[nodiscard]] vk::Pipeline get(vk_pipeline_handle handle) const noexcept;
+    [[nodiscard]] bool is_ready(vk_pipeline_handle handle) const noexcept;
+    [[nodiscard]] usize pipeline_count() const noexcept;
+    [[nodiscard]] u32 compiling_count() const noexcept { return compiling_count_.load(std::memory_order_relaxed); }
+
+private:
+    [[nodiscard]] std::shared_ptr<const shader_code> load_shader_code(const fs::path& path) noexcept;
+    [[nodiscard]] vk::Pipeline create_pipeline(const vk_graphics_pipeline_desc& desc,
+      const shader_code& vert, const shader_code& frag) const noexcept;
+    [[nodiscard]] const entry& entry_at(vk_pipeline_handle handle) const noexcept;
+};
+
+} // namespace volkano
@@ -0,0 +1,319 @@
+/*
+ * Copyright (C) 2023 Emre Simsirli
+ *
+ * Licensed under GPLv3 or any later version.
+ * Refer to the included LICENSE file.
+ */
+
+#pragma once
+
+#include <functional>
+#include <limits>
+#include <memory_resource>
+#include <optional>
+#include <span>
+#include <string>
+#include <vector>
+
+#include "core/int_types.h"
+#include "renderer/vk_gpu_profiler.h"
+#include "renderer/vk_include.h"
+
+namespace volkano {
+
+/** how a pass touches a resource, layout and image usage are ignored for buffers */
+struct vk_rg_usage {
+    vk::PipelineStageFlags2 stages;
+    vk::AccessFlags2 access;
+    vk::ImageLayout layout = vk::ImageLayout::eUndefined;
+    vk::ImageUsageFlags image_usage;
+};
+
+namespace vk_rg_usages {
+
+inline constexpr vk_rg_usage color_attachment{
+  .stages = vk::PipelineStageFlagBits2::eColorAttachmentOutput,
+  .access = vk::AccessFlagBits2::eColorAttachmentRead | vk::AccessFlagBits2::eColorAttachmentWrite,
+  .layout = vk::ImageLayout::eColorAttachmentOptimal,
+  .image_usage = vk::ImageUsageFlagBits::eColorAttachment
+};
+
+inline constexpr vk_rg_usage depth_attachment{
+  .stages = vk::PipelineStageFlagBits2::eEarlyFragmentTests | vk::PipelineStageFlagBits2::eLateFragmentTests,
+  .access = vk::AccessFlagBits2::eDepthStencilAttachmentRead | vk::AccessFlagBits2::eDepthStencilAttachmentWrite,
+  .layout = vk::ImageLayout::eDepthAttachmentOptimal,
+  .image_usage = vk::ImageUsageFlagBits::eDepthStencilAttachment
+};
+
+inline constexpr vk_rg_usage depth_attachment_read_only{
+  .stages = vk::PipelineStageFlagBits2::eEarlyFragmentTests | vk::PipelineStageFlagBits2::eLateFragmentTests,
+  .access = vk::AccessFlagBits2::eDepthStencilAttachmentRead,
+  .layout = vk::ImageLayout::eDepthReadOnlyOptimal,
+  .image_usage = vk::ImageUsageFlagBits::eDepthStencilAttachment
+};
+
+inline constexpr vk_rg_usage fragment_sampled{
+  .stages = vk::PipelineStageFlagBits2::eFragmentShader,
+  .access = vk::AccessFlagBits2::eShaderSampledRead,
+  .layout = vk::ImageLayout::eShaderReadOnlyOptimal,
+  .image_usage = vk::ImageUsageFlagBits::eSampled
+};
+
+inline constexpr vk_rg_usage compute_storage_read{
+  .stages = vk::PipelineStageFlagBits2::eComputeShader,
+  .access = vk::AccessFlagBits2::eShaderStorageRead,
+  .layout = vk::ImageLayout::eGeneral,
+  .image_usage = vk::ImageUsageFlagBits::eStorage
+};
+
+inline constexpr vk_rg_usage compute_storage_write{
+  .stages = vk::PipelineStageFlagBits2::eComputeShader,
+  .access = vk::AccessFlagBits2::eShaderStorageRead | vk::AccessFlagBits2::eShaderStorageWrite,
+  .layout = vk::ImageLayout::eGeneral,
+  .image_usage = vk::ImageUsageFlagBits::eStorage
+};
+
+inline constexpr vk_rg_usage transfer_src{
+  .stages = vk::PipelineStageFlagBits2::eAllTransfer,
+  .access = vk::AccessFlagBits2::eTransferRead,
+  .layout = vk::ImageLayout::eTransferSrcOptimal,
+  .image_usage = vk::ImageUsageFlagBits::eTransferSrc
+};
+
+inline constexpr vk_rg_usage transfer_dst{
+  .stages = vk::PipelineStageFlagBits2::eAllTransfer,
+  .access = vk::AccessFlagBits2::eTransferWrite,
+  .layout = vk::ImageLayout::eTransferDstOptimal,
+  .image_usage = vk::ImageUsageFlagBits::eTransferDst
+};
+
+inline constexpr vk_rg_usage indirect_read{
+  .stages = vk::PipelineStageFlagBits2::eDrawIndirect,
+  .access = vk::AccessFlagBits2::eIndirectCommandRead
+};
+
+inline constexpr vk_rg_usage vertex_storage_read{
+  .stages = vk::PipelineStageFlagBits2::eVertexShader,
+  .access = vk::AccessFlagBits2::eShaderStorageRead
+};
+
+/** the present engine reads the image after the render finished semaphore, which signals at color output */
+inline constexpr vk_rg_usage present{
+  .stages = vk::PipelineStageFlagBits2::eColorAttachmentOutput,
+  .access = vk::AccessFlagBits2::eNone,
+  .layout = vk::ImageLayout::ePresentSrcKHR
+};
+
+} // namespace vk_rg_usages
+
+struct vk_rg_image_desc {
+    vk::Format format = vk::Format::eUndefined;
+    vk::Extent2D extent;
+    vk::ImageAspectFlags aspect = vk::ImageAspectFlagBits::eColor;
+
+    bool operator==(const vk_rg_image_desc&) const noexcept = default;
+};
+
+struct vk_rg_resource {
+    static constexpr u32 invalid_index = std::numeric_limits<u32>::max();
+
+    u32 index = invalid_index;
+
+    [[nodiscard]] bool is_valid() const noexcept { return index != invalid_index; }
+    bool operator==(const vk_rg_resource&) const noexcept = default;
+};
+
+struct vk_rg_stats {
+    u32 pass_count = 0;
+    u32 culled_pass_count = 0;
+    u32 barrier_count = 0;
+    /** size of the memory block all transient images are aliased in */
+    vk::DeviceSize transient_memory_size = 0;
+    /** sum of the transient image sizes, the difference to the block size is saved by aliasing */
+    vk::DeviceSize transient_requested_size = 0;
+};
+
+/** lifetime of a transient image in pass indices and the memory it needs, placement fills in the offset */
+struct vk_rg_placement {
+    u32 first_pass = 0;
+    u32 last_pass = 0;
+    vk::DeviceSize size = 0;
+    vk::DeviceSize offset = 0;
+};
+
+/**
+ * Places transient images in a single memory block. Images whose lifetimes overlap get disjoint
+ * ranges, the others are free to alias each other.
+ * @param alignment of every offset, the largest alignment any of the images needs
+ * @return size of the block
+ */
+[[nodiscard]] vk::DeviceSize vk_rg_place_transients(std::span<vk_rg_placement> placements, vk::DeviceSize alignment) noexcept;
+
+/**
+ * Frame graph that is rebuilt every frame.
+ *
+ * Passes declare which images and buffers they read and write and how, the graph then culls the
+ * passes whose results nothing consumes, emits the minimal sync2 barriers and layout transitions
+ * between the remaining ones and places transient images with disjoint lifetimes in the same
+ * memory. Transient images are cached and only recreated when the shape of the graph changes.
+ *
+ * The graph owns transient images of a single frame in flight, keep one graph per frame so that
+ * aliased memory is never shared with a frame the gpu is still working on. Pass bookkeeping is
+ * allocated from frame memory so rebuilding the graph does not touch the heap.
+ */
+class vk_render_graph {
+public:
+    using execute_fn = std::function<void(vk::CommandBuffer)>;
+
+    class pass_builder {
+        friend vk_render_graph;
+
+        vk_render_graph& graph_;
+        u32 pass_index_;
+
+        pass_builder(vk_render_graph& graph, const u32 pass_index) noexcept
+          : graph_{graph}, pass_index_{pass_index} {}
+
+    public:
+        /** depends on the current contents of the resource */
+        void read(vk_rg_resource resource, const vk_rg_usage& usage) noexcept;
+        /** overwrites the resource entirely, its previous contents are discarded */
+        void write(vk_rg_resource resource, const vk_rg_usage& usage) noexcept;
+        /** modifies the current contents of the resource */
+        void read_write(vk_rg_resource resource, const vk_rg_usage& usage) noexcept;
+        /** keeps the pass alive even when nothing reads what it writes */
+        void set_side_effects() noexcept;
+    };
+
+private:
+    struct resource_state {
+        vk::PipelineStageFlags2 write_stages;
+        vk::AccessFlags2 write_access;
+        /** stages that read since the last write, a following write has to wait for them */
+        vk::PipelineStageFlags2 read_stages;
+        vk::ImageLayout layout = vk::ImageLayout::eUndefined;
+    };
+
+    struct resource {
+        std::string name;
+        bool is_image = false;
+        bool is_transient = false;
+        vk_rg_image_desc desc;
+        vk::Image image = nullptr;
+        vk::ImageView view = nullptr;
+        vk::Buffer buffer = nullptr;
+        resource_state initial_state;
+        std::optional<vk_rg_usage> final_usage;
+
+        // filled in by compile
+        vk::ImageUsageFlags image_usage;
+        u32 first_pass = std::numeric_limits<u32>::max();
+        u32 last_pass = 0;
+        u32 transient_index = std::numeric_limits<u32>::max();
+    };
+
+    struct resource_use {
+        u32 resource_index = 0;
+        vk_rg_usage usage;
+        bool reads = false;
+        bool writes = false;
+    };
+
+    struct pass {
+        std::string name;
+        std::pmr::vector<resource_use> uses;
+        execute_fn execute;
+        bool has_side_effects = false;
+        bool is_culled = false;
+
+        std::pmr::vector<vk::ImageMemoryBarrier2> image_barriers;
+        std::pmr::vector<vk::BufferMemoryBarrier2> buffer_barriers;
+    };
+
+    /** transient image that survives across frames while the graph keeps the same shape */
+    struct transient_image {
+        vk_rg_image_desc desc;
+        vk::ImageUsageFlags usage;
+        u32 first_pass = 0;
+        u32 last_pass = 0;
+        vk::Image image = nullptr;
+        vk::ImageView view = nullptr;
+        vk::DeviceSize offset = 0;
+        vk::DeviceSize size = 0;
+    };
+
+    vk::Device device_ = nullptr;
+    vma::Allocator allocator_ = nullptr;
+    /** backs everything that only lives until the next reset */
+    std::pmr::memory_resource* frame_memory_ = std::pmr::get_default_resource();
+
+    std::vector<resource> resources_;
+    std::vector<pass> passes_;
+    /** outlive the frame memory, clearing them keeps their capacity so they stop allocating after warm up */
+    std::vector<vk::ImageMemoryBarrier2> final_image_barriers_;
+    std::vector<vk::BufferMemoryBarrier2> final_buffer_barriers_;
+    bool is_compiled_ = false;
+
+    std::vector<transient_image> transients_;
+    vma::Allocation transient_memory_ = nullptr;
+
+    vk_rg_stats stats_;
+
+public:
+    /** @param frame_memory must not be released before the graph is reset, usually a frame arena */
+    void initialize(vk::Device device, vma::Allocator allocator, std::pmr::memory_resource* frame_memory) noexcept;
+    /** the gpu must no longer use the transient images */
+    void destroy() noexcept;
+
+    /** drops the passes and resources of the previous frame, cached transient images are kept */
+    void reset() noexcept;
+
+    /**
+     * @param initial_usage how the image was last used before the graph, usually what a semaphore wait covers
+     * @param final_usage state the image is left in, makes the image an output of the graph
+     */
+    [[nodiscard]] vk_rg_resource import_image(std::string name, vk::Image image, vk::ImageView view, const vk_rg_image_desc& desc,
+      const vk_rg_usage& initial_usage, std::optional<vk_rg_usage> final_usage = std::nullopt) noexcept;
+    [[nodiscard]] vk_rg_resource import_buffer(std::string name, vk::Buffer buffer, const vk_rg_usage& initial_usage) noexcept;
+    /** image that only lives within the graph, its contents are undefined at the first use */
+    [[nodiscard]] vk_rg_resource create_image(std::string name, const vk_rg_image_desc& desc) noexcept;
+
+    void add_pass(std::string name, const std::function<void(pass_builder&)>& setup, execute_fn execute) noexcept;
+
+    /** culls passes, creates transient images and computes barriers */
+    void compile() noexcept;
+    /**
+     * Records every live pass with its barriers, compile must be called first.
+     * @param profiler wraps each pass in a gpu scope named after it if set
+     */
+    void execute(vk::CommandBuffer cmd, vk_gpu_profiler* profiler = nullptr) const noexcept;
+
+    /** valid after compile */
+    [[nodiscard]] vk::Image image(vk_rg_resource resource) const noexcept;
+    /** valid after compile */
+    [[nodiscard]] vk::ImageView image_view(vk_rg_resource resource) const noexcept;
+    [[nodiscard]] vk::Buffer buffer(vk_rg_resource resource) const noexcept;
+    [[nodiscard]] const vk_rg_image_desc& image_desc(vk_rg_resource resource) const noexcept;
+
+    /** passes are indexed in the order they were added, valid after compile */
+    [[nodiscard]] bool is_culled(u32 pass_index) const noexcept;
+    /** barriers recorded right before the pass, valid after compile */
+    [[nodiscard]] std::span<const vk::ImageMemoryBarrier2> image_barriers(u32 pass_index) const noexcept;
+    /** barriers recorded right before the pass, valid after compile */
+    [[nodiscard]] std::span<const vk::BufferMemoryBarrier2> buffer_barriers(u32 pass_index) const noexcept;
+
+    [[nodiscard]] const vk_rg_stats& stats() const noexcept { return stats_; }
+
+private:
+    void add_use(u32 pass_index, vk_rg_resource resource, const vk_rg_usage& usage, bool reads, bool writes) noexcept;
+
+    void cull_passes() noexcept;
+    void compute_lifetimes() noexcept;
+    void allocate_transients() noexcept;
+    void destroy_transients() noexcept;
+    void compute_barriers() noexcept;
+
+    [[nodiscard]] const resource& resource_at(vk_rg_resource handle) const noexcept;
+};
+
+} // namespace volkano
@@ -7,12 +7,27 @@
 
 #pragma once
 
+#include <chrono>
+#include <functional>
 #include <vector>
 
 #include "core/container/static_vector.h"
 #include "core/logging/logging.h"
 #include "core/filesystem/filesystem.h"
+#include "core/memory/linear_arena.h"
+#include "core/thread/job_system.h"
+#include "core/util/rolling_stats.h"
+#include "renderer/vk_bindless_heap.h"
+#include "renderer/vk_buffer.h"
+#include "renderer/vk_frame_capture.h"
+#include "renderer/vk_gpu_culling.h"
+#include "renderer/vk_gpu_profiler.h"
 #include "renderer/vk_include.h"
+#include "renderer/vk_parallel_recorder.h"
+#include "renderer/vk_pipeline_cache.h"
+#include "renderer/vk_pipeline_registry.h"
+#include "renderer/vk_render_graph.h"
+#include "renderer/vk_upload_context.h"
 #include "renderer/renderer_interface.h"
 #include "renderer/mesh.h"
 
@@ -38,7 +53,90 @@ struct vk_surface_capabilities {
     std::vector<vk::PresentModeKHR> present_modes;
 };
 
+struct vk_renderer_config {
+    /** number of frames the cpu is allowed to record ahead of the gpu */
+    u32 frames_in_flight = 2;
+    /** falls back to fifo, which every surface supports */
+    vk::PresentModeKHR present_mode = vk::PresentModeKHR::eMailbox;
+    /** swapchain images, clamped to what the surface allows, 0 picks one more than the minimum */
+    u32 swapchain_image_count = 0;
+    /** pipeline cache blob that is loaded on startup and written back on shutdown */
+    fs::path pipeline_cache_path = "pipeline_cache.bin";
+    /** capacity of the per frame instance buffer */
+    u32 max_instances_per_frame = 65536;
+    /** threads the main pass draws are recorded on, 1 records everything into the primary command buffer */
+    u32 recording_threads = job_system::default_worker_count();
+    /** a recording thread gets at least this many draws, smaller frames use fewer threads */
+    u32 min_draws_per_recording_thread = 64;
+    /** time the frame and each render graph pass on the gpu */
+    bool gpu_profiling = true;
+    /** collect pipeline statistics for the whole frame, ignored if the device does not support them */
+    bool gpu_pipeline_statistics = false;
+
+    /** render into offscreen images instead of a window surface, no window or display is needed */
+    bool headless = false;
+    vk::Extent2D headless_extent{.width = 1280, .height = 720};
+    /** every frame is written here as a ppm if set, copies are read back asynchronously */
+    fs::path capture_directory;
+};
+
+/** a replaced swapchain, presents of its images may still wait on its semaphores */
+struct vk_retired_swapchain {
+    vk::SwapchainKHR swapchain = nullptr;
+    std::vector<vk::ImageView> image_views;
+    std::vector<vk::Semaphore> render_finished_semaphores;
+};
+
+/** instances of a single draw_instanced call, drawn with one instanced draw */
+struct vk_instance_batch {
+    u32 first_instance = 0;
+    u32 instance_count = 0;
+};
+
+/** resources owned by a single frame in flight, reused once its fence signals */
+struct vk_frame_data {
+    vk::CommandPool command_pool = nullptr;
+    vk::CommandBuffer command_buffer = nullptr;
+
+    vk::Semaphore image_available_semaphore = nullptr;
+    vk::Fence in_flight_fence = nullptr;
+
+    vk::CommandPool compute_command_pool = nullptr;
+    vk::CommandBuffer compute_command_buffer = nullptr;
+    vk::Semaphore cull_finished_semaphore = nullptr;
+
+    vk_buffer instance_buffer;
+    mesh_instance* instance_data = nullptr;
+    u32 instance_count = 0;
+    std::vector<vk_instance_batch> instance_batches;
+
+    /** allocations that live until this frame is recorded again, reset after its fence was waited on */
+    linear_arena frame_arena;
+    /** rebuilt every frame, owns the transient attachments of this frame */
+    vk_render_graph render_graph;
+
+    /** transient resources that are destroyed when the gpu is done with this frame */
+    std::vector<std::function<void()>> deferred_destructions;
+};
+
+struct vk_frame_stats {
+    static constexpr usize history_size = 128;
+
+    rolling_stats<history_size> frame_time_ms;
+    rolling_stats<history_size> fence_wait_ms;
+    /** cpu time spent recording the graphics command buffer */
+    rolling_stats<history_size> record_ms;
+    u64 frame_count = 0;
+    /** sum of every frame time, averages over whole runs */
+    f64 total_frame_time_ms = 0.0;
+};
+
 class vk_renderer : public renderer_interface {
+public:
+    static constexpr u32 max_frames_in_flight = 3;
+    static_assert(max_frames_in_flight <= vk_gpu_culling::max_frames);
+
+private:
     engine* engine_;
     u32 available_vk_version_ = VK_VERSION_1_3;
     vk::DynamicLoader dyn_loader_;
@@ -61,50 +159,106 @@ class vk_renderer : public renderer_interface {
     vk::Queue transfer_queue_ = nullptr;
 
     vk::SwapchainKHR swapchain_ = nullptr;
+    vk::PresentModeKHR present_mode_ = vk::PresentModeKHR::eFifo;
+    /** swapchain images, or offscreen render targets in headless mode */
     std::vector<vk::Image> swapchain_images_;
     std::vector<vk::ImageView> swapchain_image_views_;
-    std::vector<vk::Framebuffer> swapchain_framebuffers_;
+    /** signaled by the submit that renders into each swapchain image and waited on by its present */
+    std::vector<vk::Semaphore> render_finished_semaphores_;
+    /** headless only, one per swapchain image */
+    std::vector<vma::Allocation> offscreen_allocations_;
+    /** kept until every image of the current swapchain was acquired once, which retires their presents */
+    std::vector<vk_retired_swapchain> retired_swapchains_;
+    std::vector<bool> acquired_images_;
+    usize unacquired_image_count_ = 0;
 
-    vk::PipelineLayout pipeline_layout_ = nullptr;
-    vk::RenderPass render_pass_ = nullptr;
-    vk::Pipeline pipeline_ = nullptr;
+    /** owned by the engine */
+    job_system* jobs_ = nullptr;
+    vk_pipeline_cache pipeline_cache_;
+    vk_pipeline_registry pipeline_registry_;
+    vk_pipeline_handle triangle_pipeline_;
+    vk_pipeline_handle instanced_pipeline_;
 
-    vk::CommandPool command_pool_ = nullptr;
-    vk::CommandBuffer command_buffer_ = nullptr;
+    vk_renderer_config config_;
+    static_vector<vk_frame_data, max_frames_in_flight> frames_;
+    u32 current_frame_ = 0;
+    /** fence of the frame that last rendered into each swapchain image */
+    std::vector<vk::Fence> image_in_flight_fences_;
 
-    vk::Semaphore image_available_semaphore_ = nullptr;
-    vk::Semaphore render_finished_semaphore_ = nullptr;
-    vk::Fence in_flight_fence_ = nullptr;
+    vk_frame_stats frame_stats_;
+    /** the fence of the current frame was waited on, render does not wait again */
+    bool is_frame_ready_ = false;
+    f64 fence_wait_ms_ = 0.0;
+    std::chrono::steady_clock::time_point last_frame_time_;
 
     vk::Extent2D extent_;
     vk::Format surface_fmt_ = vk::Format::eB8G8R8A8Srgb;
+    vk::Format depth_fmt_ = vk::Format::eUndefined;
 
     vma::Allocator allocator_ = nullptr;
+    vk_upload_context upload_context_;
+    vk_bindless_heap bindless_heap_;
+    vk_gpu_culling gpu_culling_;
 
     mesh triangle_mesh_;
-    vk::Buffer mesh_buffer_ = nullptr;
-    vma::Allocation mesh_buffer_allocation_ = nullptr;
+    vk_buffer mesh_vertex_buffer_;
+    vk_buffer mesh_index_buffer_;
+    std::vector<mesh_instance> pending_instances_;
+    std::vector<u32> pending_batch_sizes_;
+    vk_parallel_recorder parallel_recorder_;
+    vk_gpu_profiler gpu_profiler_;
+    bool supports_pipeline_statistics_ = false;
+    vk_frame_capture frame_capture_;
+    /** the backbuffer can be a transfer source */
+    bool supports_capture_ = false;
 
 public:
-    explicit vk_renderer(engine* engine)
-      : engine_{engine}
+    explicit vk_renderer(engine* engine, const vk_renderer_config& config = {})
+      : engine_{engine},
+        config_{config}
     {
+        VKE_ASSERT_MSG(config_.frames_in_flight != 0 && config_.frames_in_flight <= max_frames_in_flight,
+          "frames in flight must be in [1, {}]", max_frames_in_flight);
+
         const static_vector<vertex, 3> vertices{
           {.position = vec3f{0.0f, -0.5f, 0.f}, .color = vec3f{1.0f, 0.0f, 0.0f}},
           {.position = vec3f{0.5f, 0.5f, 0.f}, .color = vec3f{0.0f, 1.0f, 0.0f}},
           {.position = vec3f{-0.5f, 0.5f, 0.f}, .color = vec3f{0.0f, 0.0f, 1.0f}}
         };
 
-        const static_vector<u16, 1> indices{};
+        const static_vector<u16, 3> indices{0, 1, 2};
         triangle_mesh_ = mesh{vertices, indices};
     }
 
     ~vk_renderer();
 
     void initialize() noexcept override;
+    void wait_for_frame() noexcept override;
     void render() noexcept override;
+    void skip_frame() noexcept override;
 
     void on_window_resize() noexcept override;
+    void draw_instanced(std::span<const mesh_instance> instances) noexcept override;
+
+    [[nodiscard]] const vk_frame_stats& get_frame_stats() const noexcept { return frame_stats_; }
+    /** starts the statistics over, e.g. to leave warm up frames out of a measurement */
+    void reset_frame_stats() noexcept { frame_stats_ = vk_frame_stats{}; }
+    [[nodiscard]] const vk_gpu_profiler& get_gpu_profiler() const noexcept { return gpu_profiler_; }
+    [[nodiscard]] const vk_frame_capture_stats& get_frame_capture_stats() const noexcept { return frame_capture_.stats(); }
+
+    /**
+     * Recreates the swapchain with the present mode and image count, without waiting for the gpu.
+     * Unsupported modes fall back to fifo.
+     */
+    void set_present_mode(vk::PresentModeKHR present_mode, u32 image_count = 0) noexcept;
+    [[nodiscard]] vk::PresentModeKHR get_present_mode() const noexcept { return present_mode_; }
+    [[nodiscard]] const std::vector<vk::PresentModeKHR>& get_supported_present_modes() const noexcept
+    {
+        return surface_capabilities_.present_modes;
+    }
+
+    /** writes the next frame to the path as a ppm once the gpu finished it, never stalls */
+    void capture_frame(fs::path path) noexcept override { frame_capture_.request(std::move(path)); }
 
 private:
     void create_vk_instance() noexcept;
@@ -115,18 +269,35 @@ private:
     void create_logical_device() noexcept;
     void cache_queues() noexcept;
     void create_swap_chain() noexcept;
+    void create_offscreen_targets() noexcept;
     void create_graphics_pipeline() noexcept;
-    void create_render_pass() noexcept;
-    void create_framebuffers() noexcept;
-    void create_vertex_buffer() noexcept;
-    void create_command_pool() noexcept;
-    void create_sync_objects() noexcept;
+    void create_mesh_buffers() noexcept;
+    void create_frame_data() noexcept;
+    void create_gpu_profiler() noexcept;
 
     void destroy_surface_objects() noexcept;
+    /** destroys the retired swapchains once the frame that acquired the last new image finishes */
+    void release_retired_swapchains(vk_frame_data& frame) noexcept;
+    void destroy_frame_data() noexcept;
 
-    void record_command_buffer(u32 img_index) noexcept;
+    void record_command_buffer(vk::CommandBuffer cmd, u32 img_index) noexcept;
+    void record_main_pass(vk::CommandBuffer cmd, vk::ImageView color_view, vk::ImageView depth_view) noexcept;
+    [[nodiscard]] bool use_parallel_recording(u32 draw_item_count) const noexcept;
+    /**
+     * Records draw items [begin, end), item 0 is the gpu culled draw and the rest are instance batches.
+     * @param is_instanced_ready whether the instanced pipeline finished compiling, sampled once per frame
+     */
+    void record_draws(vk::CommandBuffer cmd, u32 begin, u32 end, bool is_instanced_ready) const noexcept;
+    void submit_culling(vk_frame_data& frame) noexcept;
+    void stream_instances(vk_frame_data& frame) noexcept;
+    void update_frame_stats(f64 fence_wait_ms, f64 record_ms) noexcept;
 
-    vk::ShaderModule create_shader_module(std::span<const u8> spirv_binary) noexcept;
+    [[nodiscard]] vk_frame_data& current_frame() noexcept { return frames_[current_frame_]; }
+    /** its fence signals after everything that was submitted so far */
+    [[nodiscard]] vk_frame_data& last_submitted_frame() noexcept
+    {
+        return frames_[(current_frame_ + config_.frames_in_flight - 1) % config_.frames_in_flight];
+    }
 };
 
 } // namespace volkano
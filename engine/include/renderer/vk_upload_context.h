@@ -0,0 +1,123 @@
+/*
+ * Copyright (C) 2023 Emre Simsirli
+ *
+ * Licensed under GPLv3 or any later version.
+ * Refer to the included LICENSE file.
+ */
+
+#pragma once
+
+#include <deque>
+#include <span>
+#include <type_traits>
+#include <vector>
+
+#include "core/int_types.h"
+#include "renderer/vk_buffer.h"
+#include "renderer/vk_include.h"
+
+namespace volkano {
+
+struct vk_upload_context_config {
+    vk::DeviceSize staging_size = 32ull * 1024 * 1024;
+};
+
+/**
+ * Streams data into device local buffers through a persistent staging ring buffer.
+ *
+ * Uploads are batched and submitted to the transfer queue, completion is tracked with a
+ * timeline semaphore which the graphics queue waits on. When the transfer queue belongs to a
+ * different family than the graphics queue, ownership of exclusive buffers is released on the
+ * transfer queue and the matching acquire barriers are handed over to the graphics command buffer.
+ * Concurrent buffers only rely on the timeline semaphore.
+ */
+class vk_upload_context {
+    struct pending_copy {
+        vk::Buffer dst;
+        bool transfers_ownership;
+        vk::BufferCopy region;
+        vk::PipelineStageFlags2 dst_stage;
+        vk::AccessFlags2 dst_access;
+    };
+
+    struct in_flight_batch {
+        vk::CommandBuffer cmd;
+        u64 timeline_value;
+        vk::DeviceSize staging_bytes;
+    };
+
+    vk::Device device_ = nullptr;
+    vma::Allocator allocator_ = nullptr;
+    vk::Queue transfer_queue_ = nullptr;
+    u32 transfer_family_index_ = 0;
+    u32 graphics_family_index_ = 0;
+
+    vk_buffer staging_buffer_;
+    u8* staging_data_ = nullptr;
+    vk::DeviceSize staging_head_ = 0;
+    vk::DeviceSize staging_in_use_ = 0;
+    vk::DeviceSize batch_staging_bytes_ = 0;
+
+    vk::CommandPool command_pool_ = nullptr;
+    std::vector<vk::CommandBuffer> free_command_buffers_;
+    std::deque<in_flight_batch> in_flight_batches_;
+    std::vector<pending_copy> pending_copies_;
+
+    vk::Semaphore timeline_semaphore_ = nullptr;
+    u64 last_submitted_value_ = 0;
+    u64 last_completed_value_ = 0;
+
+    std::vector<vk::BufferMemoryBarrier2> pending_acquire_barriers_;
+    vk::PipelineStageFlags2 wait_stages_;
+
+public:
+    void initialize(vk::Device device, vma::Allocator allocator,
+      vk::Queue transfer_queue, u32 transfer_family_index, u32 graphics_family_index,
+      const vk_upload_context_config& config = {}) noexcept;
+    void destroy() noexcept;
+
+    /**
+     * Queues a copy of data into dst, the data is copied into the staging ring immediately.
+     * @return the timeline value that signals once the upload is complete
+     */
+    u64 upload(const vk_buffer& dst, vk::DeviceSize dst_offset, std::span<const std::byte> data,
+      vk::PipelineStageFlags2 dst_stage, vk::AccessFlags2 dst_access) noexcept;
+
+    template<typename T>
+        requires std::is_trivially_copyable_v<T>
+    u64 upload(const vk_buffer& dst, vk::DeviceSize dst_offset, std::span<const T> data,
+      vk::PipelineStageFlags2 dst_stage, vk::AccessFlags2 dst_access) noexcept
+    {
+        return upload(dst, dst_offset, std::as_bytes(data), dst_stage, dst_access);
+    }
+
+    /** submits all queued copies as one batch to the transfer queue */
+    u64 submit() noexcept;
+
+    /** recycles staging memory and command buffers of the batches that finished */
+    void collect() noexcept;
+
+    /** records queue family ownership acquires for every batch submitted since the last call */
+    void record_acquire_barriers(vk::CommandBuffer cmd) noexcept;
+
+    [[nodiscard]] bool is_complete(u64 timeline_value) noexcept;
+    void wait(u64 timeline_value) noexcept;
+
+    [[nodiscard]] vk::Semaphore timeline_semaphore() const noexcept { return timeline_semaphore_; }
+    [[nodiscard]] u64 last_submitted_value() const noexcept { return last_submitted_value_; }
+
+    /** stages the consuming queues should wait on the timeline semaphore with, none if nothing was uploaded since the last wait */
+    [[nodiscard]] vk::PipelineStageFlags2 wait_stages() const noexcept { return wait_stages_; }
+
+    /**
+     * Call once every queue that reads uploaded data submitted a wait for the last submitted value,
+     * later submissions on those queues are ordered after the wait and don't need to wait again.
+     */
+    void reset_wait_stages() noexcept { wait_stages_ = {}; }
+
+private:
+    vk::DeviceSize allocate_staging(vk::DeviceSize size) noexcept;
+    [[nodiscard]] bool has_ownership_transfer() const noexcept { return transfer_family_index_ != graphics_family_index_; }
+};
+
+} // namespace volkano
@@ -13,21 +13,57 @@
 #include <SDL2/SDL_events.h>
 
 #include "core/int_types.h"
+#include "core/filesystem/filesystem.h"
+#include "core/logging/log_config.h"
 #include "core/math/vec2.h"
+#include "core/thread/job_system.h"
+#include "core/time/frame_pacer.h"
 #include "renderer/renderer_interface.h"
 
 namespace volkano {
 
+struct engine_config {
+    /** render offscreen without creating a window, for automated runs on machines without a display */
+    bool headless = false;
+    /** size of the offscreen render target in headless mode */
+    vec2u headless_extent{.x = 1280, .y = 720};
+    /** tick returns false once this many frames are rendered, 0 runs until the window is closed */
+    u32 max_frames = 0;
+    /** the last frame of a run limited by max_frames is written here as a ppm */
+    fs::path capture_path;
+    /** every rendered frame is written here as a ppm if set */
+    fs::path capture_directory;
+    /** frames per second tick is held to, 0 runs as fast as possible */
+    f64 target_frame_rate = 0.0;
+    /** threads of the job system, the main thread runs jobs as well while it waits on them */
+    u32 job_worker_count = job_system::default_worker_count();
+    /** threads the main pass draws are recorded on, 1 records everything on the main thread */
+    u32 recording_threads = job_system::default_worker_count();
+    /** logs are written to the sinks by a background thread while the engine is alive */
+    bool async_logging = false;
+    /** category verbosities are read from this file and reapplied when it changes, empty disables it */
+    fs::path log_config_path;
+};
+
 class engine {
+    engine_config config_;
+    std::unique_ptr<log_config_watcher> log_config_watcher_;
+    /** declared before the renderer so that it outlives it */
+    job_system jobs_;
     std::unique_ptr<renderer_interface> renderer_;
     SDL_Window* window_ =  nullptr;
     SDL_Event window_event_{};
 
     bool should_render_ = true;
+    u32 rendered_frame_count_ = 0;
+    frame_pacer frame_pacer_;
+    /** main thread allocations at the last frame pacing report */
+    u64 reported_allocation_count_ = 0;
 
 public:
     engine() noexcept;
-    explicit engine(std::unique_ptr<renderer_interface> renderer) noexcept;
+    explicit engine(const engine_config& config) noexcept;
+    explicit engine(std::unique_ptr<renderer_interface> renderer, const engine_config& config = {}) noexcept;
     ~engine() noexcept;
 
     engine(const engine&) = delete;
@@ -37,7 +73,11 @@ public:
 
     bool tick() noexcept;
 
+    renderer_interface* get_renderer() noexcept { return renderer_.get(); }
     SDL_Window* get_window() noexcept { return window_; }
+    job_system& get_job_system() noexcept { return jobs_; }
+    [[nodiscard]] const engine_config& get_config() const noexcept { return config_; }
+    frame_pacer& get_frame_pacer() noexcept { return frame_pacer_; }
     vec2u get_window_extent() noexcept;
 };
 
@@ -0,0 +1,26 @@
+/*
+ * Copyright (C) 2023 Emre Simsirli
+ *
+ * Licensed under GPLv3 or any later version.
+ * Refer to the included LICENSE file.
+ */
+
+#ifndef BINDLESS_GLSL
+#define BINDLESS_GLSL
+
+#extension GL_EXT_nonuniform_qualifier : require
+
+// mirrors vk_bindless_type, resources are indexed with handles passed in push constants
+#define BINDLESS_SET 0
+#define BINDLESS_STORAGE_BUFFER_BINDING 0
+#define BINDLESS_SAMPLED_IMAGE_BINDING 1
+#define BINDLESS_SAMPLER_BINDING 2
+
+// storage buffers alias the same binding with the block type that fits each use
+#define BINDLESS_STORAGE_BUFFER(qualifiers, name, contents) \
+    layout(std430, set = BINDLESS_SET, binding = BINDLESS_STORAGE_BUFFER_BINDING) qualifiers buffer name##_block contents name[]
+
+layout(set = BINDLESS_SET, binding = BINDLESS_SAMPLED_IMAGE_BINDING) uniform texture2D bindless_textures[];
+layout(set = BINDLESS_SET, binding = BINDLESS_SAMPLER_BINDING) uniform sampler bindless_samplers[];
+
+#endif // BINDLESS_GLSL
@@ -0,0 +1,17 @@
+/*
+ * Copyright (C) 2023 Emre Simsirli
+ *
+ * Licensed under GPLv3 or any later version.
+ * Refer to the included LICENSE file.
+ */
+
+#ifndef OBJECT_DATA_GLSL
+#define OBJECT_DATA_GLSL
+
+// mirrors vk_gpu_object
+struct object_data {
+    vec4 transform; // xyz: translation, w: uniform scale
+    vec4 bounds; // world space bounding sphere, xyz: center, w: radius
+};
+
+#endif // OBJECT_DATA_GLSL
@@ -7,12 +7,26 @@
 
 #version 460
 
+#extension GL_GOOGLE_include_directive : require
+
+#include "bindless.glsl"
+#include "object_data.glsl"
+
 layout(location = 0) in vec3 inPosition;
 layout(location = 1) in vec3 inColor;
 
 layout(location = 0) out vec3 fragColor;
 
+BINDLESS_STORAGE_BUFFER(readonly, object_buffers, { object_data objects[]; });
+
+// mirrors vk_gpu_culling::draw_push_constants
+layout(push_constant) uniform draw_constants {
+    uint objects_index;
+};
+
 void main() {
-    gl_Position = vec4(inPosition, 1.0);
+    // culling writes the object index into first instance of every draw
+    const vec4 transform = object_buffers[objects_index].objects[gl_InstanceIndex].transform;
+    gl_Position = vec4(inPosition * transform.w + transform.xyz, 1.0);
     fragColor = inColor;
-}
\ No newline at end of file
+}
@@ -0,0 +1,22 @@
+/*
+ * Copyright (C) 2023 Emre Simsirli
+ *
+ * Licensed under GPLv3 or any later version.
+ * Refer to the included LICENSE file.
+ */
+
+#version 460
+
+layout(location = 0) in vec3 inPosition;
+layout(location = 1) in vec3 inColor;
+
+// mirrors mesh_instance
+layout(location = 2) in vec4 inInstanceTransform; // xyz: translation, w: uniform scale
+layout(location = 3) in vec3 inInstanceColor;
+
+layout(location = 0) out vec3 fragColor;
+
+void main() {
+    gl_Position = vec4(inPosition * inInstanceTransform.w + inInstanceTransform.xyz, 1.0);
+    fragColor = inColor * inInstanceColor;
+}
@@ -0,0 +1,49 @@
+/*
+ * Copyright (C) 2023 Emre Simsirli
+ *
+ * Licensed under GPLv3 or any later version.
+ * Refer to the included LICENSE file.
+ */
+
+#include "core/image/ppm.h"
+
+#include <iterator>
+
+#include <fmt/format.h>
+
+#include "core/assert.h"
+
+namespace volkano {
+
+std::vector<u8> encode_ppm(const u32 width, const u32 height, const std::span<const u8> pixels,
+  const pixel_layout layout, usize row_pitch) noexcept
+{
+    constexpr usize bytes_per_pixel = 4;
+    if (row_pitch == 0) {
+        row_pitch = width * bytes_per_pixel;
+    }
+    VKE_ASSERT_MSG(row_pitch >= width * bytes_per_pixel, "row pitch {} is smaller than a row", row_pitch);
+    VKE_ASSERT_MSG(height == 0 || pixels.size() >= row_pitch * (height - 1) + width * bytes_per_pixel,
+      "{} bytes do not hold a {}x{} image", pixels.size(), width, height);
+
+    std::vector<u8> ppm;
+    fmt::format_to(std::back_inserter(ppm), "P6\n{} {}\n255\n", width, height);
+    const usize header_size = ppm.size();
+    ppm.resize(header_size + static_cast<usize>(width) * height * 3);
+
+    const usize red_offset = layout == pixel_layout::rgba8 ? 0 : 2;
+    const usize blue_offset = 2 - red_offset;
+
+    u8* dst = ppm.data() + header_size;
+    for (u32 y = 0; y < height; ++y) {
+        const u8* src = pixels.data() + y * row_pitch;
+        for (u32 x = 0; x < width; ++x, src += bytes_per_pixel, dst += 3) {
+            dst[0] = src[red_offset];
+            dst[1] = src[1];
+            dst[2] = src[blue_offset];
+        }
+    }
+    return ppm;
+}
+
+} // namespace volkano
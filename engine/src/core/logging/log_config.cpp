@@ -0,0 +1,112 @@
+/*
+ * Copyright (C) 2023 Emre Simsirli
+ *
+ * Licensed under GPLv3 or any later version.
+ * Refer to the included LICENSE file.
+ */
+
+#include "core/logging/log_config.h"
+
+#include <fstream>
+#include <iterator>
+#include <optional>
+#include <string>
+
+#include <magic_enum.hpp>
+
+#include "core/logging/logging.h"
+#include "core/util/string_utils.h"
+
+VKE_DEFINE_LOG_CATEGORY_STATIC(log_config, info);
+
+namespace volkano {
+
+namespace {
+
+std::string_view trim(std::string_view str) noexcept
+{
+    constexpr std::string_view whitespace = " \t\r";
+    const usize begin = str.find_first_not_of(whitespace);
+    if (begin == std::string_view::npos) {
+        return {};
+    }
+    return str.substr(begin, str.find_last_not_of(whitespace) - begin + 1);
+}
+
+} // namespace
+
+std::vector<log_config_entry> parse_log_config(const std::string_view text)
+{
+    std::vector<log_config_entry> entries;
+    for (std::string_view line : string::split_lines(text)) {
+        line = line.substr(0, line.find('#'));
+        for (const std::string_view token : string::split(line, ",")) {
+            const std::string_view entry = trim(token);
+            if (entry.empty()) {
+                continue;
+            }
+
+            const usize separator = entry.find('=');
+            if (separator == std::string_view::npos) {
+                VKE_LOG(log_config, warning, "log config entry without a verbosity: {}", entry);
+                continue;
+            }
+
+            const std::string_view category = trim(entry.substr(0, separator));
+            const std::string_view verbosity_name = trim(entry.substr(separator + 1));
+            const std::optional<log_verbosity> verbosity = magic_enum::enum_cast<log_verbosity>(verbosity_name);
+            if (category.empty() || !verbosity.has_value()) {
+                VKE_LOG(log_config, warning, "malformed log config entry: {}", entry);
+                continue;
+            }
+
+            entries.push_back(log_config_entry{.category = category, .verbosity = *verbosity});
+        }
+    }
+    return entries;
+}
+
+log_config_watcher::log_config_watcher(fs::path path, const std::chrono::milliseconds poll_interval)
+  : path_{std::move(path)},
+    poll_interval_{poll_interval}
+{
+    thread_ = std::jthread{[this](const std::stop_token stop_token) { watch_loop(stop_token); }};
+}
+
+void log_config_watcher::watch_loop(const std::stop_token stop_token) noexcept
+{
+    std::optional<fs::file_time_type> last_write_time;
+    while (!stop_token.stop_requested()) {
+        std::error_code error;
+        const fs::file_time_type write_time = fs::last_write_time(path_, error);
+        if (error) {
+            if (last_write_time.has_value()) {
+                VKE_LOG(log_config, info, "log config {} was removed, verbosities are back to their defaults", path_.string());
+                last_write_time.reset();
+                logger::get().apply_config({});
+            }
+        } else if (write_time != last_write_time) {
+            last_write_time = write_time;
+            reload();
+        }
+
+        std::unique_lock lock{mutex_};
+        wake_.wait_for(lock, stop_token, poll_interval_, [] { return false; });
+    }
+}
+
+void log_config_watcher::reload() noexcept
+{
+    std::ifstream stream{path_};
+    if (!stream.is_open()) {
+        VKE_LOG(log_config, warning, "log config {} could not be opened", path_.string());
+        return;
+    }
+
+    const std::string text{std::istreambuf_iterator<char>{stream}, std::istreambuf_iterator<char>{}};
+    const std::vector<log_config_entry> entries = parse_log_config(text);
+    logger::get().apply_config(entries);
+    VKE_LOG(log_config, info, "applied {} entries from {}", entries.size(), path_.string());
+}
+
+} // namespace volkano
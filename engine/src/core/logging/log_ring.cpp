@@ -0,0 +1,59 @@
+/*
+ * Copyright (C) 2023 Emre Simsirli
+ *
+ * Licensed under GPLv3 or any later version.
+ * Refer to the included LICENSE file.
+ */
+
+#include "core/logging/log_ring.h"
+
+#include <algorithm>
+#include <bit>
+
+#include "core/assert.h"
+
+namespace volkano {
+
+log_ring::log_ring(const usize capacity)
+  : capacity_{std::bit_ceil(std::max<u64>(capacity, 256))},
+    mask_{capacity_ - 1}
+{
+    // value initialized, every header starts out empty
+    buffer_ = std::make_unique<record_header[]>(capacity_ / sizeof(record_header));
+}
+
+std::byte* log_ring::try_reserve(const u32 size) noexcept
+{
+    VKE_ASSERT(size <= max_record_size());
+
+    auto* const bytes = reinterpret_cast<std::byte*>(buffer_.get());
+    const u64 total = record_total_size(size);
+    u64 pos = write_pos_.load(std::memory_order_relaxed);
+    while (true) {
+        const u64 offset = pos & mask_;
+        const u64 to_end = capacity_ - offset;
+        const u64 padding = to_end < total ? to_end : 0;
+        if (pos + padding + total - read_pos_.load(std::memory_order_acquire) > capacity_) {
+            return nullptr;
+        }
+
+        if (write_pos_.compare_exchange_weak(pos, pos + padding + total, std::memory_order_relaxed)) {
+            if (padding != 0) {
+                auto* pad = reinterpret_cast<record_header*>(bytes + offset);
+                std::atomic_ref<u32>{pad->state}.store(state_padding, std::memory_order_release);
+            }
+
+            auto* header = reinterpret_cast<record_header*>(bytes + ((pos + padding) & mask_));
+            header->size = size;
+            return reinterpret_cast<std::byte*>(header + 1);
+        }
+    }
+}
+
+void log_ring::commit(std::byte* record) noexcept
+{
+    auto* header = reinterpret_cast<record_header*>(record) - 1;
+    std::atomic_ref<u32>{header->state}.store(state_committed, std::memory_order_release);
+}
+
+} // namespace volkano
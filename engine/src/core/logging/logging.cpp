@@ -7,15 +7,18 @@
 
 #include "core/logging/logging.h"
 
-#include <thread>
+#include <algorithm>
+#include <cstring>
 
 #include <fmt/os.h>
 #include <fmt/color.h>
 #include <fmt/ostream.h>
-#include <range/v3/algorithm/find_if.hpp>
 #include <range/v3/algorithm/rotate.hpp>
 
+#include "core/assert.h"
 #include "core/platform.h"
+#include "core/logging/log_config.h"
+#include "core/logging/log_ring.h"
 #include "core/util/fmt_formatters.h"
 
 VKE_DEFINE_LOG_CATEGORY(general, info);
@@ -26,10 +29,17 @@ namespace {
 
 struct default_file_sink : log_sink {
     fmt::file log_file{"log.txt", fmt::file::RDWR | fmt::file::CREATE};
+    fmt::memory_buffer pending;
 
     void sink(const log_verbosity /*verbosity*/, const std::string_view log) override
     {
-        log_file.write(log.data(), log.size());
+        pending.append(log);
+    }
+
+    void flush() override
+    {
+        log_file.write(pending.data(), pending.size());
+        pending.clear();
     }
 };
 
@@ -37,6 +47,10 @@ struct default_stdout_sink : log_sink {
     void sink(const log_verbosity verbosity, const std::string_view log) override
     {
         fmt::print(verbosity_style(verbosity), "{}", log);
+    }
+
+    void flush() override
+    {
         std::fflush(stdout);
     }
 
@@ -65,7 +79,8 @@ struct default_stdout_sink : log_sink {
 
 log_category::log_category(const std::string_view name, const log_verbosity verbosity)
   : name_(name),
-    verbosity_(verbosity)
+    verbosity_(verbosity),
+    default_verbosity_(verbosity)
 {
     logger::get().register_log_category(this);
 }
@@ -78,30 +93,141 @@ logger& logger::get() noexcept
 
 void logger::register_log_category(log_category* category)
 {
+    const auto [it, is_inserted] = category_ids_.emplace(category->name(), static_cast<u32>(categories_.size()));
+    VKE_ASSERT_MSG(is_inserted, "log category {} is defined twice", category->name());
+    category->id_ = it->second;
     categories_.push_back(category);
 }
 
 void logger::set_category_verbosity(const std::string_view category_name, const log_verbosity verbosity) noexcept
 {
-    if (log_category* cat = find_category_by_name(category_name)) {
-        cat->set_verbosity(verbosity);
+    if (const std::optional<u32> id = find_category_id(category_name)) {
+        set_category_verbosity(*id, verbosity);
+    }
+}
+
+void logger::set_category_verbosity(const u32 category_id, const log_verbosity verbosity) noexcept
+{
+    VKE_ASSERT(category_id < categories_.size());
+    categories_[category_id]->set_verbosity(verbosity);
+}
+
+std::optional<u32> logger::find_category_id(const std::string_view category_name) const noexcept
+{
+    const auto it = category_ids_.find(category_name);
+    return it == category_ids_.end() ? std::nullopt : std::optional{it->second};
+}
+
+void logger::apply_config(const std::span<const log_config_entry> entries) noexcept
+{
+    // resolved first and stored once, other threads never see a category reset to its default in between
+    std::vector<log_verbosity> verbosities;
+    verbosities.reserve(categories_.size());
+    for (const log_category* category : categories_) {
+        verbosities.push_back(category->default_verbosity());
+    }
+
+    for (const log_config_entry& entry : entries) {
+        if (entry.category == log_config_entry::all_categories) {
+            std::ranges::fill(verbosities, entry.verbosity);
+        } else if (const std::optional<u32> id = find_category_id(entry.category)) {
+            verbosities[*id] = entry.verbosity;
+        } else {
+            VKE_LOG(general, warning, "log config names an unknown category: {}", entry.category);
+        }
+    }
+
+    for (u32 id = 0; id < categories_.size(); ++id) {
+        set_category_verbosity(id, verbosities[id]);
+    }
+}
+
+void logger::enable_async(const async_log_config& config)
+{
+    VKE_ASSERT_MSG(!is_async(), "async logging is already enabled");
+
+    drain_on_caller();
+    ring_ = std::make_unique<log_ring>(config.buffer_size);
+    defers_formatting_ = config.defer_formatting;
+    overflow_policy_ = config.overflow_policy;
+    flush_interval_ = config.flush_interval;
+    flush_target_ = 0;
+    flushed_pos_.store(0, std::memory_order_relaxed);
+    is_async_ = true;
+    sink_thread_ = std::jthread{[this](const std::stop_token stop_token) { sink_loop(stop_token); }};
+}
+
+void logger::disable_async() noexcept
+{
+    if (!is_async()) {
+        return;
+    }
+
+    // the sink thread drains what is left before it returns
+    sink_thread_.request_stop();
+    sink_thread_.join();
+    is_async_ = false;
+    defers_formatting_ = false;
+}
+
+void logger::flush() noexcept
+{
+    const u64 target = ring_->write_position();
+    if (!is_async()) {
+        // another thread may be sinking the messages, it flushes once it is done with them
+        while (flushed_pos_.load(std::memory_order_acquire) < target) {
+            drain_on_caller();
+            std::this_thread::yield();
+        }
+        return;
+    }
+
+    if (std::this_thread::get_id() == sink_thread_.get_id()) {
+        return;
     }
+
+    std::unique_lock lock{sink_mutex_};
+    flush_target_ = std::max(flush_target_, target);
+    sink_wake_.notify_one();
+    flushed_.wait(lock, [this, target] { return flushed_pos_.load(std::memory_order_relaxed) >= target; });
 }
 
-log_category* logger::find_category_by_name(const std::string_view name) noexcept
+std::vector<std::unique_ptr<log_sink>> logger::set_sinks(std::vector<std::unique_ptr<log_sink>> sinks) noexcept
 {
-    const auto it = ranges::find_if(categories_, [name](const log_category* cat) { return name == cat->name(); });
-    return it == categories_.end() ? nullptr : *it;
+    VKE_ASSERT_MSG(!is_async(), "sinks cannot be changed while the sink thread uses them");
+    std::swap(sinks_, sinks);
+    return sinks;
 }
 
 logger::logger()
+  : ring_{std::make_unique<log_ring>(sync_buffer_size)}
 {
     sinks_.push_back(std::make_unique<default_file_sink>());
     sinks_.push_back(std::make_unique<default_stdout_sink>());
 }
 
+logger::~logger()
+{
+    disable_async();
+    drain_on_caller();
+}
+
+log_buffer& logger::thread_buffer() noexcept
+{
+    thread_local log_buffer buffer;
+    return buffer;
+}
+
 void logger::log_internal(const log_category& category, const log_verbosity verbosity,
-  const std::source_location src, const std::string_view user_log) noexcept
+  const log_site& site, log_buffer& buffer) noexcept
+{
+    finish_line(buffer, category, verbosity, site, std::chrono::system_clock::now(), std::this_thread::get_id());
+
+    enqueue(verbosity, std::string_view{buffer.begin(), buffer.size()});
+}
+
+void logger::finish_line(log_buffer& buffer, const log_category& category, const log_verbosity verbosity,
+  const log_site& site, const std::chrono::system_clock::time_point time, const std::thread::id thread)
 {
 #if PLATFORM_WINDOWS
     constexpr const char path_separator = '\\';
@@ -109,23 +235,157 @@ void logger::log_internal(const log_category& category, const log_verbosity verb
     constexpr const char path_separator = '/';
 #endif // PLATFORM
 
-    std::string_view file_name = src.file_name();
+    std::string_view file_name = site.file_name;
     const auto file_start = file_name.find_last_of(path_separator);
     if (file_start != std::string_view::npos) {
         file_name = file_name.substr(file_start + 1);
     }
 
-    const auto now = std::chrono::system_clock::now();
-    fmt::format_to(std::back_inserter(buffer_), "[{:%H:%M}:{:%S}][{}][{}:{}][{}][{}]: ",
-      now, now.time_since_epoch(), std::this_thread::get_id(),
-      file_name, src.line(), category.name(), verbosity);
-    ranges::rotate(buffer_, buffer_.begin() + user_log.size());
-    buffer_.push_back('\n');
+    const usize user_log_size = buffer.size();
+    fmt::format_to(std::back_inserter(buffer), "[{:%H:%M}:{:%S}][{}][{}:{}][{}][{}]: ",
+      time, time.time_since_epoch(), thread,
+      file_name, site.line, category.name(), verbosity);
+    ranges::rotate(buffer, buffer.begin() + user_log_size);
+    buffer.push_back('\n');
+}
+
+std::byte* logger::reserve(const u32 size) noexcept
+{
+    std::byte* record = ring_->try_reserve(size);
+    while (record == nullptr) {
+        if (!is_async()) {
+            drain_on_caller();
+        } else if (overflow_policy_ == log_overflow_policy::drop) {
+            dropped_count_.fetch_add(1, std::memory_order_relaxed);
+            return nullptr;
+        } else {
+            request_drain(ring_->write_position());
+        }
+        std::this_thread::yield();
+        record = ring_->try_reserve(size);
+    }
+    return record;
+}
+
+void logger::enqueue(const log_verbosity verbosity, std::string_view log) noexcept
+{
+    // messages that do not fit are cut short
+    const usize max_log_size = ring_->max_record_size() - sizeof(text_record);
+    const bool is_truncated = log.size() > max_log_size;
+    if (is_truncated) {
+        log = log.substr(0, max_log_size - 1);
+    }
+
+    const auto size = static_cast<u32>(sizeof(text_record) + log.size() + (is_truncated ? 1 : 0));
+    std::byte* record = reserve(size);
+    if (record == nullptr) {
+        return;
+    }
+
+    const text_record header{.kind = record_kind::text, .verbosity = verbosity};
+    std::memcpy(record, &header, sizeof(header));
+    std::memcpy(record + sizeof(header), log.data(), log.size());
+    if (is_truncated) {
+        record[size - 1] = static_cast<std::byte>('\n');
+    }
+    log_ring::commit(record);
+
+    on_published(verbosity);
+}
+
+void logger::on_published(const log_verbosity verbosity) noexcept
+{
+    if (!is_async()) {
+        // pairs with the fence after a draining thread clears is_draining_, either it sees
+        // this message when it checks for more or this thread sees the flag cleared
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        drain_on_caller();
+    }
+
+    if (verbosity == log_verbosity::critical) {
+        flush();
+    }
+}
+
+void logger::request_drain(const u64 target) noexcept
+{
+    {
+        std::scoped_lock lock{sink_mutex_};
+        flush_target_ = std::max(flush_target_, target);
+    }
+    sink_wake_.notify_one();
+}
+
+void logger::drain_on_caller() noexcept
+{
+    while (ring_->read_position() != ring_->write_position()) {
+        if (is_draining_.exchange(true, std::memory_order_acquire)) {
+            return;
+        }
+        drain();
+        is_draining_.store(false, std::memory_order_release);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+    }
+}
+
+void logger::sink_loop(const std::stop_token stop_token) noexcept
+{
+    while (!stop_token.stop_requested()) {
+        {
+            std::unique_lock lock{sink_mutex_};
+            sink_wake_.wait_for(lock, stop_token, flush_interval_, [this] {
+                return flush_target_ > flushed_pos_.load(std::memory_order_relaxed);
+            });
+        }
+        drain();
+    }
+    drain();
+}
+
+void logger::drain() noexcept
+{
+    ring_->consume([this](const std::span<const std::byte> record) {
+        log_verbosity verbosity = log_verbosity::off;
+        std::string_view log;
+        if (static_cast<record_kind>(record[0]) == record_kind::deferred) {
+            deferred_record header{};
+            std::memcpy(&header, record.data(), sizeof(header));
+
+            sink_buffer_.clear();
+            header.format_fn(header.site->format, record.data() + sizeof(header), sink_buffer_);
+            finish_line(sink_buffer_, *header.category, header.verbosity, *header.site, header.time, header.thread);
+            verbosity = header.verbosity;
+            log = std::string_view{sink_buffer_.data(), sink_buffer_.size()};
+        } else {
+            text_record header{};
+            std::memcpy(&header, record.data(), sizeof(header));
+            verbosity = header.verbosity;
+            log = std::string_view{reinterpret_cast<const char*>(record.data() + sizeof(header)), record.size() - sizeof(header)};
+        }
+
+        for (const auto& sink: sinks_) {
+            sink->sink(verbosity, log);
+        }
+    });
+
+    if (const u64 dropped_count = dropped_count_.load(std::memory_order_relaxed); dropped_count != reported_dropped_count_) {
+        const std::string log = fmt::format("[logger]: {} messages were dropped, the async log buffer was full\n",
+          dropped_count - reported_dropped_count_);
+        reported_dropped_count_ = dropped_count;
+        for (const auto& sink: sinks_) {
+            sink->sink(log_verbosity::warning, log);
+        }
+    }
 
-    const std::string_view log{buffer_.begin(), buffer_.size()};
     for (const auto& sink: sinks_) {
-        sink->sink(verbosity, log);
+        sink->flush();
+    }
+
+    {
+        std::scoped_lock lock{sink_mutex_};
+        flushed_pos_.store(ring_->read_position(), std::memory_order_release);
     }
+    flushed_.notify_all();
 }
 
 } // namespace volkano
@@ -0,0 +1,137 @@
+/*
+ * Copyright (C) 2023 Emre Simsirli
+ *
+ * Licensed under GPLv3 or any later version.
+ * Refer to the included LICENSE file.
+ */
+
+#include "core/memory/allocation_tracker.h"
+
+#include <atomic>
+
+#if defined(VKE_TRACK_ALLOCATIONS)
+  #include <cstdlib>
+  #include <new>
+
+  #include "core/platform.h"
+
+  #if PLATFORM_WINDOWS
+    #include <malloc.h>
+  #endif
+#endif
+
+namespace volkano {
+
+namespace {
+
+std::atomic<u64> allocation_count = 0;
+// constant initialized, safe to touch from operator new before anything else on the thread ran
+thread_local u64 thread_allocation_count = 0;
+
+} // namespace
+
+u64 heap_allocation_count() noexcept
+{
+    return allocation_count.load(std::memory_order_relaxed);
+}
+
+u64 thread_heap_allocation_count() noexcept
+{
+    return thread_allocation_count;
+}
+
+#if defined(VKE_TRACK_ALLOCATIONS)
+
+namespace {
+
+void count_allocation() noexcept
+{
+    allocation_count.fetch_add(1, std::memory_order_relaxed);
+    ++thread_allocation_count;
+}
+
+void* allocate(const usize size, const usize alignment) noexcept
+{
+    if (alignment <= __STDCPP_DEFAULT_NEW_ALIGNMENT__) {
+        return std::malloc(size);
+    }
+
+  #if PLATFORM_WINDOWS
+    return _aligned_malloc(size, alignment);
+  #else
+    // aligned_alloc wants a multiple of the alignment
+    return std::aligned_alloc(alignment, (size + alignment - 1) & ~(alignment - 1));
+  #endif
+}
+
+void deallocate(void* ptr, [[maybe_unused]] const usize alignment) noexcept
+{
+  #if PLATFORM_WINDOWS
+    if (alignment > __STDCPP_DEFAULT_NEW_ALIGNMENT__) {
+        _aligned_free(ptr);
+        return;
+    }
+  #endif
+    std::free(ptr);
+}
+
+void* tracked_new(usize size, const usize alignment)
+{
+    count_allocation();
+    if (size == 0) {
+        size = 1;
+    }
+
+    while (true) {
+        if (void* ptr = allocate(size, alignment)) {
+            return ptr;
+        }
+
+        std::new_handler handler = std::get_new_handler();
+        if (!handler) {
+            throw std::bad_alloc{};
+        }
+        handler();
+    }
+}
+
+} // namespace
+
+#endif // defined(VKE_TRACK_ALLOCATIONS)
+
+} // namespace volkano
+
+#if defined(VKE_TRACK_ALLOCATIONS)
+
+// the array and nothrow forms forward to these by default
+void* operator new(const std::size_t size)
+{
+    return volkano::tracked_new(size, __STDCPP_DEFAULT_NEW_ALIGNMENT__);
+}
+
+void* operator new(const std::size_t size, const std::align_val_t alignment)
+{
+    return volkano::tracked_new(size, static_cast<std::size_t>(alignment));
+}
+
+void operator delete(void* ptr) noexcept
+{
+    volkano::deallocate(ptr, __STDCPP_DEFAULT_NEW_ALIGNMENT__);
+}
+
+void operator delete(void* ptr, const std::align_val_t alignment) noexcept
+{
+    volkano::deallocate(ptr, static_cast<std::size_t>(alignment));
+}
+
+void operator delete(void* ptr, std::size_t /*size*/) noexcept
+{
+    volkano::deallocate(ptr, __STDCPP_DEFAULT_NEW_ALIGNMENT__);
+}
+
+void operator delete(void* ptr, std::size_t /*size*/, const std::align_val_t alignment) noexcept
+{
+    volkano::deallocate(ptr, static_cast<std::size_t>(alignment));
+}
+
+#endif // defined(VKE_TRACK_ALLOCATIONS)
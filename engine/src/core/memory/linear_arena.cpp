@@ -0,0 +1,55 @@
+/*
+ * Copyright (C) 2023 Emre Simsirli
+ *
+ * Licensed under GPLv3 or any later version.
+ * Refer to the included LICENSE file.
+ */
+
+#include "core/memory/linear_arena.h"
+
+#include <algorithm>
+#include <bit>
+
+#include "core/assert.h"
+
+namespace volkano {
+
+linear_arena::linear_arena(const usize capacity)
+  : block_{std::make_unique_for_overwrite<std::byte[]>(capacity)},
+    capacity_{capacity}
+{
+    VKE_ASSERT(capacity != 0);
+}
+
+void linear_arena::rewind(const marker& m) noexcept
+{
+    VKE_ASSERT(m.offset <= offset_);
+    VKE_ASSERT(m.overflow_count <= overflow_blocks_.size());
+
+    offset_ = m.offset;
+    while (overflow_blocks_.size() > m.overflow_count) {
+        overflow_size_ -= overflow_blocks_.back().size;
+        overflow_blocks_.pop_back();
+    }
+
+    if (used() == 0 && peak_ > capacity_) {
+        capacity_ = std::bit_ceil(peak_);
+        block_ = std::make_unique_for_overwrite<std::byte[]>(capacity_);
+    }
+}
+
+void* linear_arena::allocate_overflow(const usize size, const usize alignment) noexcept
+{
+    const usize block_size = size + alignment;
+    overflow_blocks_.push_back(overflow_block{
+      .memory = std::make_unique_for_overwrite<std::byte[]>(block_size),
+      .size = block_size
+    });
+    overflow_size_ += block_size;
+    peak_ = std::max(peak_, used());
+
+    const auto base = reinterpret_cast<uintptr>(overflow_blocks_.back().memory.get());
+    return reinterpret_cast<void*>((base + alignment - 1) & ~uintptr{alignment - 1});
+}
+
+} // namespace volkano
@@ -0,0 +1,24 @@
+/*
+ * Copyright (C) 2023 Emre Simsirli
+ *
+ * Licensed under GPLv3 or any later version.
+ * Refer to the included LICENSE file.
+ */
+
+#include "core/memory/scratch_arena.h"
+
+namespace volkano {
+
+namespace {
+
+constexpr usize scratch_arena_capacity = 256 * 1024;
+
+} // namespace
+
+linear_arena& thread_scratch_arena() noexcept
+{
+    thread_local linear_arena arena{scratch_arena_capacity};
+    return arena;
+}
+
+} // namespace volkano
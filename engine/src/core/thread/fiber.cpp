@@ -0,0 +1,316 @@
+/*
+ * Copyright (C) 2023 Emre Simsirli
+ *
+ * Licensed under GPLv3 or any later version.
+ * Refer to the included LICENSE file.
+ */
+
+#include "core/thread/fiber.h"
+
+#include <cstring>
+
+#include "core/assert.h"
+
+#if PLATFORM_WINDOWS
+  #define WIN32_LEAN_AND_MEAN
+  #define NOMINMAX
+  #include <Windows.h>
+  #define VKE_FIBER_ASM 0
+#elif defined(__x86_64__) || defined(__aarch64__)
+  #include <sys/mman.h>
+  #include <unistd.h>
+  #define VKE_FIBER_ASM 1
+#else
+  #include <new>
+  #include <utility>
+  #include <sys/mman.h>
+  #include <ucontext.h>
+  #include <unistd.h>
+  #define VKE_FIBER_ASM 0
+#endif
+
+#if VKE_FIBER_ASM
+
+// saves the callee saved registers on the current stack, stores the stack pointer into *from_sp,
+// then loads to_sp and pops the registers that were saved there. a new fiber starts with a frame
+// that returns into vke_fiber_start which calls entry(arg)
+extern "C" void vke_fiber_switch(void** from_sp, void* to_sp);
+extern "C" void vke_fiber_start();
+
+  #if defined(__x86_64__)
+asm(R"(
+    .text
+    .globl vke_fiber_switch
+    .hidden vke_fiber_switch
+    .type vke_fiber_switch, @function
+    .p2align 4
+vke_fiber_switch:
+    pushq %rbp
+    pushq %rbx
+    pushq %r12
+    pushq %r13
+    pushq %r14
+    pushq %r15
+    subq $8, %rsp
+    stmxcsr (%rsp)
+    fnstcw 4(%rsp)
+    movq %rsp, (%rdi)
+    movq %rsi, %rsp
+    ldmxcsr (%rsp)
+    fldcw 4(%rsp)
+    addq $8, %rsp
+    popq %r15
+    popq %r14
+    popq %r13
+    popq %r12
+    popq %rbx
+    popq %rbp
+    ret
+    .size vke_fiber_switch, .-vke_fiber_switch
+
+    .globl vke_fiber_start
+    .hidden vke_fiber_start
+    .type vke_fiber_start, @function
+    .p2align 4
+vke_fiber_start:
+    movq %r12, %rdi
+    callq *%r13
+    ud2
+    .size vke_fiber_start, .-vke_fiber_start
+)");
+  #elif defined(__aarch64__)
+asm(R"(
+    .text
+    .globl vke_fiber_switch
+    .hidden vke_fiber_switch
+    .type vke_fiber_switch, %function
+    .p2align 4
+vke_fiber_switch:
+    sub sp, sp, #176
+    stp x19, x20, [sp, #0]
+    stp x21, x22, [sp, #16]
+    stp x23, x24, [sp, #32]
+    stp x25, x26, [sp, #48]
+    stp x27, x28, [sp, #64]
+    stp x29, x30, [sp, #80]
+    stp d8, d9, [sp, #96]
+    stp d10, d11, [sp, #112]
+    stp d12, d13, [sp, #128]
+    stp d14, d15, [sp, #144]
+    mov x9, sp
+    str x9, [x0]
+    mov sp, x1
+    ldp x19, x20, [sp, #0]
+    ldp x21, x22, [sp, #16]
+    ldp x23, x24, [sp, #32]
+    ldp x25, x26, [sp, #48]
+    ldp x27, x28, [sp, #64]
+    ldp x29, x30, [sp, #80]
+    ldp d8, d9, [sp, #96]
+    ldp d10, d11, [sp, #112]
+    ldp d12, d13, [sp, #128]
+    ldp d14, d15, [sp, #144]
+    add sp, sp, #176
+    ret
+    .size vke_fiber_switch, .-vke_fiber_switch
+
+    .globl vke_fiber_start
+    .hidden vke_fiber_start
+    .type vke_fiber_start, %function
+    .p2align 4
+vke_fiber_start:
+    mov x0, x19
+    blr x20
+    brk #0
+    .size vke_fiber_start, .-vke_fiber_start
+)");
+  #endif
+
+#endif // VKE_FIBER_ASM
+
+namespace volkano {
+
+namespace {
+
+#if PLATFORM_WINDOWS
+
+struct start_info {
+    fiber::entry_fn entry;
+    void* arg;
+};
+
+void WINAPI windows_fiber_start(void* param)
+{
+    const start_info info = *static_cast<start_info*>(param);
+    delete static_cast<start_info*>(param);
+    info.entry(info.arg);
+}
+
+#else
+
+usize page_size() noexcept
+{
+    static const auto size = static_cast<usize>(sysconf(_SC_PAGESIZE));
+    return size;
+}
+
+/**
+ * Maps the stack with an inaccessible page below it, stacks grow down so an overflow faults on the
+ * guard instead of silently corrupting whatever lives next to the stack.
+ * @return start of the mapping, the guard page, mapping_size receives the size to unmap
+ */
+std::byte* map_stack(const usize stack_size, usize& mapping_size) noexcept
+{
+    const usize page = page_size();
+    mapping_size = ((stack_size + page - 1) & ~(page - 1)) + page;
+
+    void* mapping = mmap(nullptr, mapping_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    VKE_ASSERT_MSG(mapping != MAP_FAILED, "fiber stack of {} bytes could not be mapped", mapping_size);
+    [[maybe_unused]] const int result = mprotect(mapping, page, PROT_NONE);
+    VKE_ASSERT_MSG(result == 0, "fiber stack guard page could not be protected");
+    return static_cast<std::byte*>(mapping);
+}
+
+void unmap_stack(std::byte* stack, const usize mapping_size) noexcept
+{
+    if (stack) {
+        munmap(stack, mapping_size);
+    }
+}
+
+#endif
+
+#if !PLATFORM_WINDOWS && !VKE_FIBER_ASM
+
+// makecontext only passes int arguments, the pointer is split in two
+void ucontext_start(const unsigned hi, const unsigned lo)
+{
+    const u64 bits = (u64{hi} << 32) | u64{lo};
+    const auto* info = reinterpret_cast<const std::pair<fiber::entry_fn, void*>*>(static_cast<uintptr>(bits));
+    info->first(info->second);
+}
+
+#endif
+
+} // namespace
+
+#if PLATFORM_WINDOWS
+
+fiber::fiber() noexcept
+  : is_thread_{true}
+{
+    handle_ = ConvertThreadToFiber(nullptr);
+    VKE_ASSERT_MSG(handle_ != nullptr, "thread could not be converted to a fiber");
+}
+
+fiber::fiber(const entry_fn entry, void* arg, const usize stack_size) noexcept
+{
+    // freed by the fiber once it starts. the system reserves the stack with a guard page of its own
+    handle_ = CreateFiber(stack_size, &windows_fiber_start, new start_info{entry, arg});
+    VKE_ASSERT_MSG(handle_ != nullptr, "fiber could not be created");
+}
+
+fiber::~fiber()
+{
+    if (is_thread_) {
+        ConvertFiberToThread();
+    } else if (handle_) {
+        DeleteFiber(handle_);
+    }
+}
+
+void fiber::switch_to([[maybe_unused]] fiber& from, fiber& to) noexcept
+{
+    SwitchToFiber(to.handle_);
+}
+
+#elif VKE_FIBER_ASM
+
+fiber::fiber() noexcept = default;
+
+fiber::fiber(const entry_fn entry, void* arg, const usize stack_size) noexcept
+{
+    // assigned here, stack_mapping_size_ is initialized after stack_
+    stack_ = map_stack(stack_size, stack_mapping_size_);
+
+    // the initial frame is what vke_fiber_switch pops, with the start trampoline as return address
+    auto top = reinterpret_cast<uintptr>(stack_ + stack_mapping_size_) & ~uintptr{15};
+  #if defined(__x86_64__)
+    // mxcsr and x87 control word, r15, r14, r13, r12, rbx, rbp, return address, padding to keep
+    // the stack 16 byte aligned at the call in vke_fiber_start
+    top -= 16;
+    auto* frame = reinterpret_cast<u64*>(top - 64);
+    constexpr u32 default_mxcsr = 0x1F80;
+    constexpr u16 default_fpu_cw = 0x037F;
+    std::memcpy(frame, &default_mxcsr, sizeof(default_mxcsr));
+    std::memcpy(reinterpret_cast<std::byte*>(frame) + 4, &default_fpu_cw, sizeof(default_fpu_cw));
+    frame[1] = 0;                                      // r15
+    frame[2] = 0;                                      // r14
+    frame[3] = reinterpret_cast<u64>(entry);           // r13
+    frame[4] = reinterpret_cast<u64>(arg);             // r12
+    frame[5] = 0;                                      // rbx
+    frame[6] = 0;                                      // rbp
+    frame[7] = reinterpret_cast<u64>(&vke_fiber_start); // return address
+  #elif defined(__aarch64__)
+    // x19-x28, fp, lr, d8-d15, the stack pointer ends up at top once the frame is popped
+    auto* frame = reinterpret_cast<u64*>(top - 176);
+    std::memset(frame, 0, 176);
+    frame[0] = reinterpret_cast<u64>(arg);              // x19
+    frame[1] = reinterpret_cast<u64>(entry);            // x20
+    frame[11] = reinterpret_cast<u64>(&vke_fiber_start); // x30
+  #endif
+    context_ = frame;
+}
+
+fiber::~fiber()
+{
+    unmap_stack(stack_, stack_mapping_size_);
+}
+
+void fiber::switch_to(fiber& from, fiber& to) noexcept
+{
+    vke_fiber_switch(&from.context_, to.context_);
+}
+
+#else // ucontext
+
+fiber::fiber() noexcept
+{
+    context_ = new ucontext_t{};
+}
+
+fiber::fiber(const entry_fn entry, void* arg, const usize stack_size) noexcept
+{
+    stack_ = map_stack(stack_size + sizeof(std::pair<entry_fn, void*>), stack_mapping_size_);
+
+    // the start info is kept at the bottom of the stack, right above the guard page
+    std::byte* bottom = stack_ + page_size();
+    auto* info = new (bottom) std::pair<entry_fn, void*>{entry, arg};
+
+    auto* context = new ucontext_t{};
+    [[maybe_unused]] const int result = getcontext(context);
+    VKE_ASSERT(result == 0);
+    context->uc_stack.ss_sp = bottom + sizeof(*info);
+    context->uc_stack.ss_size = static_cast<usize>(stack_ + stack_mapping_size_ - bottom) - sizeof(*info);
+    context->uc_link = nullptr;
+
+    const auto bits = static_cast<u64>(reinterpret_cast<uintptr>(info));
+    makecontext(context, reinterpret_cast<void (*)()>(&ucontext_start), 2,
+      static_cast<unsigned>(bits >> 32), static_cast<unsigned>(bits & 0xFFFFFFFFu));
+    context_ = context;
+}
+
+fiber::~fiber()
+{
+    delete static_cast<ucontext_t*>(context_);
+    unmap_stack(stack_, stack_mapping_size_);
+}
+
+void fiber::switch_to(fiber& from, fiber& to) noexcept
+{
+    swapcontext(static_cast<ucontext_t*>(from.context_), static_cast<ucontext_t*>(to.context_));
+}
+
+#endif
+
+} // namespace volkano
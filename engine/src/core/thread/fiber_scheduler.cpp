@@ -0,0 +1,264 @@
+/*
+ * Copyright (C) 2023 Emre Simsirli
+ *
+ * Licensed under GPLv3 or any later version.
+ * Refer to the included LICENSE file.
+ */
+
+#include "core/thread/fiber_scheduler.h"
+
+#include <utility>
+
+#include "core/assert.h"
+
+#if PLATFORM_WINDOWS
+  #define VKE_NOINLINE __declspec(noinline)
+#else
+  #define VKE_NOINLINE [[gnu::noinline]]
+#endif
+
+namespace volkano {
+
+struct fiber_slot {
+    fiber_scheduler* scheduler;
+    fiber_scheduler::job fn;
+    fiber_counter* counter = nullptr;
+    fiber context;
+
+    fiber_slot(fiber_scheduler* owner, const fiber::entry_fn entry, const usize stack_size) noexcept
+      : scheduler{owner},
+        context{entry, this, stack_size}
+    {
+    }
+};
+
+struct fiber_scheduler::worker_state {
+    /** what the worker does with the fiber it just switched away from */
+    enum class switch_action : u8 {
+        none,
+        finish,
+        park
+    };
+
+    fiber_scheduler* scheduler = nullptr;
+    fiber thread_fiber;
+    fiber_slot* current = nullptr;
+    switch_action action = switch_action::none;
+    fiber_counter* park_counter = nullptr;
+};
+
+thread_local fiber_scheduler::worker_state* fiber_scheduler::tls_worker_ = nullptr;
+
+fiber_scheduler::fiber_scheduler(const fiber_scheduler_config& config)
+{
+    VKE_ASSERT(config.worker_count != 0);
+    VKE_ASSERT(config.fiber_count != 0);
+
+    fibers_.reserve(config.fiber_count);
+    free_fibers_.reserve(config.fiber_count);
+    for (u32 i = 0; i < config.fiber_count; ++i) {
+        fibers_.push_back(std::make_unique<fiber_slot>(this, &fiber_main, config.stack_size));
+        free_fibers_.push_back(fibers_.back().get());
+    }
+
+    workers_.reserve(config.worker_count);
+    for (u32 i = 0; i < config.worker_count; ++i) {
+        workers_.emplace_back([this](const std::stop_token stop_token) { worker_loop(stop_token); });
+    }
+}
+
+fiber_scheduler::~fiber_scheduler()
+{
+    VKE_ASSERT_MSG(!is_in_job(), "fiber scheduler destroyed from one of its own jobs");
+
+    {
+        std::unique_lock lock{mutex_};
+        idle_.wait(lock, [this] { return is_idle(); });
+    }
+
+    for (std::jthread& worker : workers_) {
+        worker.request_stop();
+    }
+    work_available_.notify_all();
+    workers_.clear();
+    fibers_.clear();
+}
+
+void fiber_scheduler::run(job fn, fiber_counter* counter)
+{
+    if (counter) {
+        counter->count_.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    {
+        std::scoped_lock lock{mutex_};
+        jobs_.push_back(queued_job{.fn = std::move(fn), .counter = counter});
+    }
+    work_available_.notify_one();
+}
+
+void fiber_scheduler::wait(fiber_counter& counter) noexcept
+{
+    // the counter is only known to be untouched by the job that finished it once its mutex was taken
+    const auto is_done = [&counter] {
+        std::scoped_lock lock{counter.waiters_mutex_};
+        return counter.count_.load(std::memory_order_acquire) == 0;
+    };
+
+    worker_state* worker = current_worker();
+    if (!worker || worker->scheduler != this || !worker->current) {
+        while (!is_done()) {
+            std::this_thread::yield();
+        }
+        return;
+    }
+
+    if (is_done()) {
+        return;
+    }
+
+    // the worker registers this fiber as a waiter after the switch, the counter is checked again
+    // there so a job that finishes in between does not leave it parked forever
+    worker->action = worker_state::switch_action::park;
+    worker->park_counter = &counter;
+    fiber::switch_to(worker->current->context, worker->thread_fiber);
+}
+
+bool fiber_scheduler::is_in_job() const noexcept
+{
+    const worker_state* worker = current_worker();
+    return worker && worker->scheduler == this && worker->current;
+}
+
+VKE_NOINLINE fiber_scheduler::worker_state* fiber_scheduler::current_worker() noexcept
+{
+    return tls_worker_;
+}
+
+void fiber_scheduler::worker_loop(const std::stop_token stop_token)
+{
+    worker_state worker;
+    worker.scheduler = this;
+    tls_worker_ = &worker;
+
+    while (true) {
+        fiber_slot* slot = nullptr;
+        {
+            std::unique_lock lock{mutex_};
+            const bool has_work = work_available_.wait(lock, stop_token, [this] {
+                return !ready_fibers_.empty() || (!jobs_.empty() && !free_fibers_.empty());
+            });
+            if (!has_work) {
+                break;
+            }
+
+            if (!ready_fibers_.empty()) {
+                slot = ready_fibers_.front();
+                ready_fibers_.pop_front();
+            } else {
+                slot = free_fibers_.back();
+                free_fibers_.pop_back();
+                slot->fn = std::move(jobs_.front().fn);
+                slot->counter = jobs_.front().counter;
+                jobs_.pop_front();
+            }
+        }
+
+        worker.current = slot;
+        fiber::switch_to(worker.thread_fiber, slot->context);
+        complete_switch(worker);
+    }
+
+    tls_worker_ = nullptr;
+}
+
+void fiber_scheduler::fiber_main(void* arg)
+{
+    auto& slot = *static_cast<fiber_slot*>(arg);
+    while (true) {
+        slot.fn();
+        slot.fn = nullptr;
+        if (fiber_counter* counter = std::exchange(slot.counter, nullptr)) {
+            slot.scheduler->finish_job(*counter);
+        }
+
+        // the job may have resumed on another thread after a wait
+        worker_state* worker = current_worker();
+        worker->action = worker_state::switch_action::finish;
+        fiber::switch_to(slot.context, worker->thread_fiber);
+    }
+}
+
+void fiber_scheduler::complete_switch(worker_state& worker) noexcept
+{
+    fiber_slot* slot = std::exchange(worker.current, nullptr);
+    switch (std::exchange(worker.action, worker_state::switch_action::none)) {
+        case worker_state::switch_action::finish: {
+            std::scoped_lock lock{mutex_};
+            free_fibers_.push_back(slot);
+            if (is_idle()) {
+                idle_.notify_all();
+            }
+            break;
+        }
+        case worker_state::switch_action::park: {
+            fiber_counter& counter = *std::exchange(worker.park_counter, nullptr);
+            {
+                std::scoped_lock lock{counter.waiters_mutex_};
+                if (counter.count_.load(std::memory_order_acquire) != 0) {
+                    counter.waiters_.push_back(slot);
+                    slot = nullptr;
+
+                    // counted while the waiter lock is held so that the wake up always comes after it
+                    std::scoped_lock scheduler_lock{mutex_};
+                    ++parked_fiber_count_;
+                    VKE_ASSERT_MSG(parked_fiber_count_ < fibers_.size(),
+                      "all {} fibers are parked, the jobs they wait on can never start, raise fiber_count", fibers_.size());
+                }
+            }
+            if (slot) {
+                make_ready(slot, /*was_parked=*/false);
+            }
+            break;
+        }
+        case worker_state::switch_action::none:
+            VKE_ASSERT_MSG(false, "fiber switched back to its worker without an action");
+            break;
+    }
+}
+
+void fiber_scheduler::make_ready(fiber_slot* slot, const bool was_parked) noexcept
+{
+    {
+        std::scoped_lock lock{mutex_};
+        if (was_parked) {
+            --parked_fiber_count_;
+        }
+        ready_fibers_.push_back(slot);
+    }
+    work_available_.notify_one();
+}
+
+void fiber_scheduler::finish_job(fiber_counter& counter) noexcept
+{
+    // decremented under the mutex so that a waiter which sees zero can destroy the counter
+    // as soon as it took the mutex itself
+    std::vector<fiber_slot*> waiters;
+    {
+        std::scoped_lock lock{counter.waiters_mutex_};
+        if (counter.count_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            waiters.swap(counter.waiters_);
+        }
+    }
+
+    for (fiber_slot* waiter : waiters) {
+        make_ready(waiter, /*was_parked=*/true);
+    }
+}
+
+bool fiber_scheduler::is_idle() const noexcept
+{
+    return jobs_.empty() && ready_fibers_.empty() && free_fibers_.size() == fibers_.size();
+}
+
+} // namespace volkano
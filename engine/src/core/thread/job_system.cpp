@@ -0,0 +1,191 @@
+/*
+ * Copyright (C) 2023 Emre Simsirli
+ *
+ * Licensed under GPLv3 or any later version.
+ * Refer to the included LICENSE file.
+ */
+
+#include "core/thread/job_system.h"
+
+#include "core/assert.h"
+
+namespace volkano {
+
+namespace {
+
+// identifies the queue of a worker thread, several job systems may exist at once
+thread_local const job_system* tls_job_system = nullptr;
+thread_local u32 tls_queue_index = 0;
+
+} // namespace
+
+job_system::job_system(const u32 worker_count)
+  : queues_{std::make_unique<job_queue[]>(worker_count + 1)},
+    queue_count_{worker_count + 1}
+{
+    VKE_ASSERT(worker_count != 0);
+
+    workers_.reserve(worker_count);
+    for (u32 i = 0; i < worker_count; ++i) {
+        workers_.emplace_back([this, i](const std::stop_token stop_token) { worker_loop(stop_token, i); });
+    }
+}
+
+job_system::~job_system()
+{
+    const u32 queue_index = current_queue_index();
+    while (queued_count_.load(std::memory_order_acquire) != 0) {
+        if (!try_run_one(queue_index, /*allow_background=*/true)) {
+            std::this_thread::yield();
+        }
+    }
+
+    for (std::jthread& worker : workers_) {
+        worker.request_stop();
+    }
+    {
+        std::scoped_lock lock{sleep_mutex_};
+    }
+    wake_.notify_all();
+    workers_.clear();
+}
+
+void job_system::run(job fn, job_counter* counter, const job_priority priority)
+{
+    if (counter) {
+        counter->count_.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    // counted before it is visible so that the count never drops below zero when it is taken right away,
+    // pairs with the sleeping count increment of a worker so one of the two sides sees the other
+    queued_count_.fetch_add(1, std::memory_order_seq_cst);
+
+    job_queue& queue = priority == job_priority::background ? background_queue_ : queues_[current_queue_index()];
+    {
+        std::scoped_lock lock{queue.mutex};
+        queue.jobs.push_back(queued_job{.fn = std::move(fn), .counter = counter});
+    }
+
+    if (sleeping_count_.load(std::memory_order_seq_cst) != 0) {
+        {
+            std::scoped_lock lock{sleep_mutex_};
+        }
+        wake_.notify_one();
+    }
+}
+
+void job_system::wait(const job_counter& counter) noexcept
+{
+    const u32 queue_index = current_queue_index();
+    while (!counter.is_done()) {
+        if (!try_run_one(queue_index, /*allow_background=*/false)) {
+            std::this_thread::yield();
+        }
+    }
+}
+
+u32 job_system::current_queue_index() const noexcept
+{
+    return tls_job_system == this ? tls_queue_index : queue_count_ - 1;
+}
+
+job_system_stats job_system::stats() const noexcept
+{
+    job_system_stats stats;
+    for (u32 i = 0; i < queue_count_; ++i) {
+        stats.executed_count += queues_[i].executed_count.load(std::memory_order_relaxed);
+        stats.stolen_count += queues_[i].stolen_count.load(std::memory_order_relaxed);
+    }
+    return stats;
+}
+
+u32 job_system::default_worker_count() noexcept
+{
+    // hardware_concurrency is 0 when it cannot be determined, one thread is left for the caller
+    return std::max(2u, std::thread::hardware_concurrency()) - 1;
+}
+
+void job_system::worker_loop(const std::stop_token stop_token, const u32 queue_index)
+{
+    tls_job_system = this;
+    tls_queue_index = queue_index;
+
+    while (!stop_token.stop_requested()) {
+        if (try_run_one(queue_index, /*allow_background=*/true)) {
+            continue;
+        }
+
+        std::unique_lock lock{sleep_mutex_};
+        sleeping_count_.fetch_add(1, std::memory_order_seq_cst);
+        wake_.wait(lock, stop_token, [this]() { return queued_count_.load(std::memory_order_seq_cst) != 0; });
+        sleeping_count_.fetch_sub(1, std::memory_order_relaxed);
+    }
+}
+
+bool job_system::try_run_one(const u32 queue_index, const bool allow_background) noexcept
+{
+    queued_job j;
+    if (try_pop(queue_index, j)) {
+        queues_[queue_index].executed_count.fetch_add(1, std::memory_order_relaxed);
+    } else if (try_steal(queue_index, j)) {
+        queues_[queue_index].executed_count.fetch_add(1, std::memory_order_relaxed);
+        queues_[queue_index].stolen_count.fetch_add(1, std::memory_order_relaxed);
+    } else if (allow_background && try_pop_background(j)) {
+        queues_[queue_index].executed_count.fetch_add(1, std::memory_order_relaxed);
+    } else {
+        return false;
+    }
+
+    queued_count_.fetch_sub(1, std::memory_order_relaxed);
+    j.fn();
+    if (j.counter) {
+        j.counter->count_.fetch_sub(1, std::memory_order_release);
+    }
+    return true;
+}
+
+bool job_system::try_pop(const u32 queue_index, queued_job& out_job) noexcept
+{
+    job_queue& queue = queues_[queue_index];
+    std::scoped_lock lock{queue.mutex};
+    if (queue.jobs.empty()) {
+        return false;
+    }
+
+    // newest first, its data is most likely still in cache
+    out_job = std::move(queue.jobs.back());
+    queue.jobs.pop_back();
+    return true;
+}
+
+bool job_system::try_pop_background(queued_job& out_job) noexcept
+{
+    std::scoped_lock lock{background_queue_.mutex};
+    if (background_queue_.jobs.empty()) {
+        return false;
+    }
+
+    // oldest first, background jobs are independent and should finish in the order they were queued
+    out_job = std::move(background_queue_.jobs.front());
+    background_queue_.jobs.pop_front();
+    return true;
+}
+
+bool job_system::try_steal(const u32 queue_index, queued_job& out_job) noexcept
+{
+    // start from the neighbour so thieves spread over the victims
+    for (u32 offset = 1; offset < queue_count_; ++offset) {
+        job_queue& victim = queues_[(queue_index + offset) % queue_count_];
+        std::unique_lock lock{victim.mutex, std::try_to_lock};
+        if (!lock.owns_lock() || victim.jobs.empty()) {
+            continue;
+        }
+
+        out_job = std::move(victim.jobs.front());
+        victim.jobs.pop_front();
+        return true;
+    }
+    return false;
+}
+
+} // namespace volkano
@@ -0,0 +1,73 @@
+/*
+ * Copyright (C) 2023 Emre Simsirli
+ *
+ * Licensed under GPLv3 or any later version.
+ * Refer to the included LICENSE file.
+ */
+
+#include "core/thread/thread_pool.h"
+
+#include "core/assert.h"
+
+namespace volkano {
+
+thread_pool::thread_pool(const u32 worker_count)
+{
+    VKE_ASSERT(worker_count != 0);
+
+    workers_.reserve(worker_count);
+    for (u32 i = 0; i < worker_count; ++i) {
+        workers_.emplace_back([this](const std::stop_token stop_token) { worker_loop(stop_token); });
+    }
+}
+
+thread_pool::~thread_pool()
+{
+    for (std::jthread& worker : workers_) {
+        worker.request_stop();
+    }
+    task_available_.notify_all();
+    workers_.clear();
+}
+
+void thread_pool::enqueue(std::function<void()> task)
+{
+    {
+        std::scoped_lock lock{mutex_};
+        tasks_.push_back(std::move(task));
+    }
+    task_available_.notify_one();
+}
+
+void thread_pool::wait_idle()
+{
+    std::unique_lock lock{mutex_};
+    idle_.wait(lock, [this]() { return tasks_.empty() && active_tasks_ == 0; });
+}
+
+void thread_pool::worker_loop(const std::stop_token stop_token)
+{
+    while (true) {
+        std::function<void()> task;
+        {
+            std::unique_lock lock{mutex_};
+            if (!task_available_.wait(lock, stop_token, [this]() { return !tasks_.empty(); })) {
+                return;
+            }
+
+            task = std::move(tasks_.front());
+            tasks_.pop_front();
+            ++active_tasks_;
+        }
+
+        task();
+
+        {
+            std::scoped_lock lock{mutex_};
+            --active_tasks_;
+        }
+        idle_.notify_all();
+    }
+}
+
+} // namespace volkano
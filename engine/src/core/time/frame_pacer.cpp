@@ -0,0 +1,74 @@
+/*
+ * Copyright (C) 2023 Emre Simsirli
+ *
+ * Licensed under GPLv3 or any later version.
+ * Refer to the included LICENSE file.
+ */
+
+#include "core/time/frame_pacer.h"
+
+#include <thread>
+
+#include "core/assert.h"
+
+namespace volkano {
+
+frame_pacer::frame_pacer(const frame_pacer_config& config) noexcept
+  : config_{config}
+{
+    set_target_frame_rate(config_.target_frame_rate);
+}
+
+void frame_pacer::set_target_frame_rate(const f64 target_frame_rate) noexcept
+{
+    VKE_ASSERT(target_frame_rate >= 0.0);
+
+    config_.target_frame_rate = target_frame_rate;
+    period_ = target_frame_rate == 0.0
+      ? clock::duration::zero()
+      : std::chrono::duration_cast<clock::duration>(std::chrono::duration<f64>{1.0 / target_frame_rate});
+    next_frame_begin_ = clock::time_point{};
+}
+
+void frame_pacer::begin_frame() noexcept
+{
+    const clock::time_point wait_begin = clock::now();
+    if (period_ != clock::duration::zero()) {
+        // late by more than a period, start a new schedule from now instead of catching up
+        if (next_frame_begin_ + period_ < wait_begin) {
+            next_frame_begin_ = wait_begin;
+        }
+        wait_until(next_frame_begin_, config_.spin_threshold);
+    }
+
+    const clock::time_point now = clock::now();
+    if (stats_.frame_count != 0) {
+        stats_.frame_start_interval_ms.add(std::chrono::duration<f64, std::milli>{now - frame_begin_}.count());
+    }
+    stats_.wait_ms.add(std::chrono::duration<f64, std::milli>{now - wait_begin}.count());
+
+    frame_begin_ = now;
+    input_sampled_ = now;
+    next_frame_begin_ += period_;
+}
+
+void frame_pacer::end_frame() noexcept
+{
+    const clock::time_point now = clock::now();
+    stats_.cpu_ms.add(std::chrono::duration<f64, std::milli>{now - frame_begin_}.count());
+    stats_.input_latency_ms.add(std::chrono::duration<f64, std::milli>{now - input_sampled_}.count());
+    ++stats_.frame_count;
+}
+
+void frame_pacer::wait_until(const clock::time_point deadline, const clock::duration spin_threshold) noexcept
+{
+    if (const clock::time_point sleep_deadline = deadline - spin_threshold; clock::now() < sleep_deadline) {
+        std::this_thread::sleep_until(sleep_deadline);
+    }
+
+    while (clock::now() < deadline) {
+        std::this_thread::yield();
+    }
+}
+
+} // namespace volkano
@@ -0,0 +1,225 @@
+/*
+ * Copyright (C) 2023 Emre Simsirli
+ *
+ * Licensed under GPLv3 or any later version.
+ * Refer to the included LICENSE file.
+ */
+
+#include "renderer/vk_bindless_heap.h"
+
+#include <algorithm>
+
+#include "renderer/vk_renderer.h"
+
+namespace volkano {
+
+namespace {
+
+constexpr u32 to_binding(const vk_bindless_type type) noexcept { return static_cast<u32>(type); }
+
+constexpr vk::DescriptorType to_descriptor_type(const vk_bindless_type type) noexcept
+{
+    switch (type) {
+        case vk_bindless_type::storage_buffer: return vk::DescriptorType::eStorageBuffer;
+        case vk_bindless_type::sampled_image: return vk::DescriptorType::eSampledImage;
+        case vk_bindless_type::sampler: return vk::DescriptorType::eSampler;
+        default: VKE_UNREACHABLE();
+    }
+}
+
+} // namespace
+
+void vk_bindless_heap::initialize(const vk::Device device, const vk::PhysicalDevice physical_device,
+  const vk_bindless_heap_config& config) noexcept
+{
+    device_ = device;
+
+    vk::PhysicalDeviceVulkan12Properties vk12_properties{};
+    vk::PhysicalDeviceProperties2 properties{};
+    properties.pNext = &vk12_properties;
+    physical_device.getProperties2(&properties);
+
+    // every binding is visible to all stages, so the per stage limits apply as well
+    slots_[to_binding(vk_bindless_type::storage_buffer)].capacity = std::min({config.max_storage_buffers,
+      vk12_properties.maxDescriptorSetUpdateAfterBindStorageBuffers,
+      vk12_properties.maxPerStageDescriptorUpdateAfterBindStorageBuffers});
+    slots_[to_binding(vk_bindless_type::sampled_image)].capacity = std::min({config.max_sampled_images,
+      vk12_properties.maxDescriptorSetUpdateAfterBindSampledImages,
+      vk12_properties.maxPerStageDescriptorUpdateAfterBindSampledImages});
+    slots_[to_binding(vk_bindless_type::sampler)].capacity = std::min({config.max_samplers,
+      vk12_properties.maxDescriptorSetUpdateAfterBindSamplers,
+      vk12_properties.maxPerStageDescriptorUpdateAfterBindSamplers});
+
+    // the bindings together count against the per stage resource limit as well, scale them down
+    // evenly when they do not fit
+    u64 total_count = 0;
+    for (const slot_allocator& slots : slots_) {
+        total_count += slots.capacity;
+    }
+    if (const u64 max_resources = vk12_properties.maxPerStageUpdateAfterBindResources; total_count > max_resources) {
+        for (slot_allocator& slots : slots_) {
+            slots.capacity = static_cast<u32>(u64{slots.capacity} * max_resources / total_count);
+        }
+    }
+
+    std::array<vk::DescriptorSetLayoutBinding, static_cast<usize>(vk_bindless_type::count)> bindings;
+    std::array<vk::DescriptorBindingFlags, static_cast<usize>(vk_bindless_type::count)> binding_flags;
+    std::array<vk::DescriptorPoolSize, static_cast<usize>(vk_bindless_type::count)> pool_sizes;
+    for (u32 binding = 0; binding < bindings.size(); ++binding) {
+        const auto type = static_cast<vk_bindless_type>(binding);
+        bindings[binding] = vk::DescriptorSetLayoutBinding{
+          .binding = binding,
+          .descriptorType = to_descriptor_type(type),
+          .descriptorCount = capacity(type),
+          .stageFlags = push_constant_stages
+        };
+        // slots are written while the set is bound and most of them are empty at any time
+        binding_flags[binding] = vk::DescriptorBindingFlagBits::eUpdateAfterBind
+          | vk::DescriptorBindingFlagBits::eUpdateUnusedWhilePending
+          | vk::DescriptorBindingFlagBits::ePartiallyBound;
+        pool_sizes[binding] = vk::DescriptorPoolSize{
+          .type = to_descriptor_type(type),
+          .descriptorCount = capacity(type)
+        };
+    }
+
+    const vk::DescriptorSetLayoutBindingFlagsCreateInfo binding_flags_create_info{
+      .bindingCount = static_cast<u32>(binding_flags.size()),
+      .pBindingFlags = binding_flags.data()
+    };
+    set_layout_ = vk_check_result(device_.createDescriptorSetLayout(vk::DescriptorSetLayoutCreateInfo{
+      .pNext = &binding_flags_create_info,
+      .flags = vk::DescriptorSetLayoutCreateFlagBits::eUpdateAfterBindPool,
+      .bindingCount = static_cast<u32>(bindings.size()),
+      .pBindings = bindings.data()
+    }));
+
+    pool_ = vk_check_result(device_.createDescriptorPool(vk::DescriptorPoolCreateInfo{
+      .flags = vk::DescriptorPoolCreateFlagBits::eUpdateAfterBind,
+      .maxSets = 1,
+      .poolSizeCount = static_cast<u32>(pool_sizes.size()),
+      .pPoolSizes = pool_sizes.data()
+    }));
+
+    set_ = vk_check_result(device_.allocateDescriptorSets(vk::DescriptorSetAllocateInfo{
+      .descriptorPool = pool_,
+      .descriptorSetCount = 1,
+      .pSetLayouts = &set_layout_
+    })).front();
+
+    const vk::PushConstantRange push_constant_range{
+      .stageFlags = push_constant_stages,
+      .offset = 0,
+      .size = push_constant_size
+    };
+    pipeline_layout_ = vk_check_result(device_.createPipelineLayout(vk::PipelineLayoutCreateInfo{
+      .setLayoutCount = 1,
+      .pSetLayouts = &set_layout_,
+      .pushConstantRangeCount = 1,
+      .pPushConstantRanges = &push_constant_range
+    }));
+
+    VKE_LOG(renderer, verbose, "bindless heap created, storage buffers: {} sampled images: {} samplers: {}",
+      capacity(vk_bindless_type::storage_buffer),
+      capacity(vk_bindless_type::sampled_image),
+      capacity(vk_bindless_type::sampler));
+}
+
+void vk_bindless_heap::destroy() noexcept
+{
+    if (!device_) {
+        return;
+    }
+
+    device_.destroy(pipeline_layout_);
+    device_.destroy(pool_);
+    device_.destroy(set_layout_);
+    slots_ = {};
+    device_ = nullptr;
+}
+
+vk_bindless_handle vk_bindless_heap::register_storage_buffer(const vk::Buffer buffer,
+  const vk::DeviceSize offset, const vk::DeviceSize range) noexcept
+{
+    const vk_bindless_handle handle = allocate(vk_bindless_type::storage_buffer);
+    const vk::DescriptorBufferInfo buffer_info{
+      .buffer = buffer,
+      .offset = offset,
+      .range = range
+    };
+    device_.updateDescriptorSets(vk::WriteDescriptorSet{
+      .dstSet = set_,
+      .dstBinding = to_binding(vk_bindless_type::storage_buffer),
+      .dstArrayElement = handle.index,
+      .descriptorCount = 1,
+      .descriptorType = vk::DescriptorType::eStorageBuffer,
+      .pBufferInfo = &buffer_info
+    }, {});
+    return handle;
+}
+
+vk_bindless_handle vk_bindless_heap::register_sampled_image(const vk::ImageView view, const vk::ImageLayout layout) noexcept
+{
+    const vk_bindless_handle handle = allocate(vk_bindless_type::sampled_image);
+    const vk::DescriptorImageInfo image_info{
+      .imageView = view,
+      .imageLayout = layout
+    };
+    device_.updateDescriptorSets(vk::WriteDescriptorSet{
+      .dstSet = set_,
+      .dstBinding = to_binding(vk_bindless_type::sampled_image),
+      .dstArrayElement = handle.index,
+      .descriptorCount = 1,
+      .descriptorType = vk::DescriptorType::eSampledImage,
+      .pImageInfo = &image_info
+    }, {});
+    return handle;
+}
+
+vk_bindless_handle vk_bindless_heap::register_sampler(const vk::Sampler sampler) noexcept
+{
+    const vk_bindless_handle handle = allocate(vk_bindless_type::sampler);
+    const vk::DescriptorImageInfo image_info{
+      .sampler = sampler
+    };
+    device_.updateDescriptorSets(vk::WriteDescriptorSet{
+      .dstSet = set_,
+      .dstBinding = to_binding(vk_bindless_type::sampler),
+      .dstArrayElement = handle.index,
+      .descriptorCount = 1,
+      .descriptorType = vk::DescriptorType::eSampler,
+      .pImageInfo = &image_info
+    }, {});
+    return handle;
+}
+
+void vk_bindless_heap::release(const vk_bindless_type type, const vk_bindless_handle handle) noexcept
+{
+    if (!handle.is_valid()) {
+        return;
+    }
+
+    slot_allocator& slots = slots_[to_binding(type)];
+    VKE_ASSERT(handle.index < slots.next_index);
+    slots.free_indices.push_back(handle.index);
+}
+
+void vk_bindless_heap::bind(const vk::CommandBuffer cmd, const vk::PipelineBindPoint bind_point) const noexcept
+{
+    cmd.bindDescriptorSets(bind_point, pipeline_layout_, /*firstSet=*/0, {set_}, {});
+}
+
+vk_bindless_handle vk_bindless_heap::allocate(const vk_bindless_type type) noexcept
+{
+    slot_allocator& slots = slots_[to_binding(type)];
+    if (!slots.free_indices.empty()) {
+        const u32 index = slots.free_indices.back();
+        slots.free_indices.pop_back();
+        return vk_bindless_handle{index};
+    }
+
+    VKE_ASSERT_MSG(slots.next_index < slots.capacity, "bindless heap is out of {} slots", static_cast<u32>(type));
+    return vk_bindless_handle{slots.next_index++};
+}
+
+} // namespace volkano
@@ -0,0 +1,93 @@
+/*
+ * Copyright (C) 2023 Emre Simsirli
+ *
+ * Licensed under GPLv3 or any later version.
+ * Refer to the included LICENSE file.
+ */
+
+#include "renderer/vk_buffer.h"
+
+namespace volkano {
+
+vk_buffer create_device_local_buffer(const vma::Allocator allocator,
+  const vk::DeviceSize size, const vk::BufferUsageFlags usage, const std::span<const u32> concurrent_family_indices) noexcept
+{
+    const bool is_concurrent = concurrent_family_indices.size() > 1;
+    const vk::BufferCreateInfo buffer_create_info{
+      .size = size,
+      .usage = usage,
+      .sharingMode = is_concurrent ? vk::SharingMode::eConcurrent : vk::SharingMode::eExclusive,
+      .queueFamilyIndexCount = is_concurrent ? static_cast<u32>(concurrent_family_indices.size()) : 0,
+      .pQueueFamilyIndices = is_concurrent ? concurrent_family_indices.data() : nullptr
+    };
+
+    const vma::AllocationCreateInfo alloc_create_info{
+      .usage = vma::MemoryUsage::eAutoPreferDevice
+    };
+
+    vk_buffer buffer{.size = size, .sharing_mode = buffer_create_info.sharingMode};
+    vma::AllocationInfo alloc_info;
+    std::tie(buffer.handle, buffer.allocation) =
+      vk_check_result(allocator.createBuffer(buffer_create_info, alloc_create_info, alloc_info));
+    return buffer;
+}
+
+vk_buffer create_host_visible_buffer(const vma::Allocator allocator,
+  const vk::DeviceSize size, const vk::BufferUsageFlags usage, void*& out_mapped_data) noexcept
+{
+    const vk::BufferCreateInfo buffer_create_info{
+      .size = size,
+      .usage = usage,
+      .sharingMode = vk::SharingMode::eExclusive,
+    };
+
+    const vma::AllocationCreateInfo alloc_create_info{
+      .flags = vma::AllocationCreateFlagBits::eMapped | vma::AllocationCreateFlagBits::eHostAccessSequentialWrite,
+      .usage = vma::MemoryUsage::eAuto,
+      .preferredFlags = vk::MemoryPropertyFlagBits::eHostCoherent
+    };
+
+    vk_buffer buffer{.size = size};
+    vma::AllocationInfo alloc_info;
+    std::tie(buffer.handle, buffer.allocation) =
+      vk_check_result(allocator.createBuffer(buffer_create_info, alloc_create_info, alloc_info));
+
+    out_mapped_data = alloc_info.pMappedData;
+    VKE_ASSERT(out_mapped_data != nullptr);
+    return buffer;
+}
+
+vk_buffer create_readback_buffer(const vma::Allocator allocator, const vk::DeviceSize size, void*& out_mapped_data) noexcept
+{
+    const vk::BufferCreateInfo buffer_create_info{
+      .size = size,
+      .usage = vk::BufferUsageFlagBits::eTransferDst,
+      .sharingMode = vk::SharingMode::eExclusive,
+    };
+
+    // cached memory keeps cpu reads fast, write combined memory is very slow to read from
+    const vma::AllocationCreateInfo alloc_create_info{
+      .flags = vma::AllocationCreateFlagBits::eMapped | vma::AllocationCreateFlagBits::eHostAccessRandom,
+      .usage = vma::MemoryUsage::eAuto,
+      .preferredFlags = vk::MemoryPropertyFlagBits::eHostCached
+    };
+
+    vk_buffer buffer{.size = size};
+    vma::AllocationInfo alloc_info;
+    std::tie(buffer.handle, buffer.allocation) =
+      vk_check_result(allocator.createBuffer(buffer_create_info, alloc_create_info, alloc_info));
+
+    out_mapped_data = alloc_info.pMappedData;
+    VKE_ASSERT(out_mapped_data != nullptr);
+    return buffer;
+}
+
+void destroy_buffer(const vma::Allocator allocator, vk_buffer& buffer) noexcept
+{
+    if (buffer) {
+        allocator.destroyBuffer(buffer.handle, buffer.allocation);
+    }
+    buffer = vk_buffer{};
+}
+
+} // namespace volkano
@@ -0,0 +1,187 @@
+/*
+ * Copyright (C) 2023 Emre Simsirli
+ *
+ * Licensed under GPLv3 or any later version.
+ * Refer to the included LICENSE file.
+ */
+
+#include "renderer/vk_frame_capture.h"
+
+#include "renderer/vk_renderer.h"
+
+namespace volkano {
+
+void vk_frame_capture::initialize(const vma::Allocator allocator, const u32 frame_count) noexcept
+{
+    VKE_ASSERT(frame_count != 0);
+
+    allocator_ = allocator;
+    slot_count_ = frame_count;
+    slots_ = std::make_unique<slot[]>(frame_count);
+    encoder_ = std::make_unique<thread_pool>(/*worker_count=*/1);
+}
+
+void vk_frame_capture::destroy() noexcept
+{
+    if (!allocator_) {
+        return;
+    }
+
+    // copies that were submitted but never resolved are complete now, write them as well
+    for (u32 i = 0; i < slot_count_; ++i) {
+        resolve(i);
+    }
+    encoder_->wait_idle();
+    encoder_.reset();
+
+    for (u32 i = 0; i < slot_count_; ++i) {
+        destroy_buffer(allocator_, slots_[i].buffer);
+    }
+    slots_.reset();
+    slot_count_ = 0;
+    allocator_ = nullptr;
+
+    if (stats_.captured_count != 0 || stats_.dropped_count != 0) {
+        VKE_LOG(renderer, info, "frame capture finished, {} frames written, {} dropped", stats_.captured_count, stats_.dropped_count);
+    }
+}
+
+void vk_frame_capture::request(fs::path path) noexcept
+{
+    requests_.push_back(std::move(path));
+}
+
+void vk_frame_capture::set_continuous(fs::path directory) noexcept
+{
+    continuous_directory_ = std::move(directory);
+    continuous_index_ = 0;
+
+    if (!continuous_directory_.empty()) {
+        std::error_code error;
+        fs::create_directories(continuous_directory_, error);
+        VKE_ASSERT_MSG(!error, "capture directory {} could not be created: {}", continuous_directory_.string(), error.message());
+    }
+}
+
+bool vk_frame_capture::add_pass(vk_render_graph& graph, const vk_rg_resource image, const u32 frame_index) noexcept
+{
+    const bool is_continuous = !continuous_directory_.empty();
+    if (requests_.empty() && !is_continuous) {
+        return false;
+    }
+
+    slot& s = slots_[frame_index];
+    VKE_ASSERT_MSG(!s.is_pending, "capture of frame slot {} was never resolved", frame_index);
+
+    // requests stay queued until a slot frees up, continuous captures are not worth falling behind for
+    if (s.is_encoding.load(std::memory_order_acquire)) {
+        if (requests_.empty()) {
+            ++stats_.dropped_count;
+        }
+        return false;
+    }
+
+    const vk_rg_image_desc& desc = graph.image_desc(image);
+    const std::optional<pixel_layout> layout = layout_of(desc.format);
+    if (!layout) {
+        VKE_LOG(renderer, warning, "frame capture does not support format {}, captures are dropped", vk::to_string(desc.format));
+        requests_.clear();
+        continuous_directory_.clear();
+        return false;
+    }
+
+    const vk::DeviceSize size = vk::DeviceSize{desc.extent.width} * desc.extent.height * 4;
+    if (s.buffer.size < size) {
+        destroy_buffer(allocator_, s.buffer);
+        s.buffer = create_readback_buffer(allocator_, size, s.mapped_data);
+    }
+
+    if (!requests_.empty()) {
+        s.path = std::move(requests_.front());
+        requests_.pop_front();
+    } else {
+        s.path = continuous_directory_ / fmt::format("frame_{:06}.ppm", continuous_index_++);
+    }
+    s.extent = desc.extent;
+    s.layout = *layout;
+    s.is_pending = true;
+
+    graph.add_pass("capture",
+      [&](vk_render_graph::pass_builder& builder) {
+          builder.read(image, vk_rg_usages::transfer_src);
+          builder.set_side_effects();
+      },
+      [&graph, image, buffer = s.buffer.handle, extent = desc.extent](const vk::CommandBuffer cmd) {
+          cmd.copyImageToBuffer(graph.image(image), vk::ImageLayout::eTransferSrcOptimal, buffer, vk::BufferImageCopy{
+            .bufferOffset = 0,
+            .bufferRowLength = 0,
+            .bufferImageHeight = 0,
+            .imageSubresource = vk::ImageSubresourceLayers{
+              .aspectMask = vk::ImageAspectFlagBits::eColor,
+              .mipLevel = 0,
+              .baseArrayLayer = 0,
+              .layerCount = 1
+            },
+            .imageOffset = vk::Offset3D{},
+            .imageExtent = vk::Extent3D{.width = extent.width, .height = extent.height, .depth = 1}
+          });
+
+          // makes the copy visible to the host once the fence of the frame signals
+          const vk::BufferMemoryBarrier2 host_barrier{
+            .srcStageMask = vk::PipelineStageFlagBits2::eAllTransfer,
+            .srcAccessMask = vk::AccessFlagBits2::eTransferWrite,
+            .dstStageMask = vk::PipelineStageFlagBits2::eHost,
+            .dstAccessMask = vk::AccessFlagBits2::eHostRead,
+            .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+            .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+            .buffer = buffer,
+            .offset = 0,
+            .size = VK_WHOLE_SIZE
+          };
+          cmd.pipelineBarrier2(vk::DependencyInfo{
+            .bufferMemoryBarrierCount = 1,
+            .pBufferMemoryBarriers = &host_barrier
+          });
+      });
+
+    return true;
+}
+
+void vk_frame_capture::resolve(const u32 frame_index) noexcept
+{
+    slot& s = slots_[frame_index];
+    if (!s.is_pending) {
+        return;
+    }
+
+    s.is_pending = false;
+    allocator_.invalidateAllocation(s.buffer.allocation, /*offset=*/0, VK_WHOLE_SIZE);
+    ++stats_.captured_count;
+
+    // the slot is not touched by the main thread until the encoder clears the flag
+    s.is_encoding.store(true, std::memory_order_relaxed);
+    encoder_->enqueue([&s] {
+        const auto size = static_cast<usize>(vk::DeviceSize{s.extent.width} * s.extent.height * 4);
+        const std::vector<u8> ppm = encode_ppm(s.extent.width, s.extent.height,
+          std::span{static_cast<const u8*>(s.mapped_data), size}, s.layout);
+        fs::write_bytes_to_file(s.path, ppm);
+
+        s.is_encoding.store(false, std::memory_order_release);
+    });
+}
+
+std::optional<pixel_layout> vk_frame_capture::layout_of(const vk::Format format) noexcept
+{
+    switch (format) {
+        case vk::Format::eR8G8B8A8Unorm:
+        case vk::Format::eR8G8B8A8Srgb:
+            return pixel_layout::rgba8;
+        case vk::Format::eB8G8R8A8Unorm:
+        case vk::Format::eB8G8R8A8Srgb:
+            return pixel_layout::bgra8;
+        default:
+            return std::nullopt;
+    }
+}
+
+} // namespace volkano
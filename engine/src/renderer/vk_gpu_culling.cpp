@@ -0,0 +1,162 @@
+/*
+ * Copyright (C) 2023 Emre Simsirli
+ *
+ * Licensed under GPLv3 or any later version.
+ * Refer to the included LICENSE file.
+ */
+
+#include "renderer/vk_gpu_culling.h"
+
+#include "core/filesystem/filesystem.h"
+#include "renderer/vk_renderer.h"
+
+namespace volkano {
+
+namespace {
+
+constexpr u32 cull_group_size = 64;
+
+} // namespace
+
+void vk_gpu_culling::initialize(const vk::Device device, const vma::Allocator allocator, const vk::PipelineCache pipeline_cache,
+  vk_bindless_heap& heap, const std::span<const u32> concurrent_family_indices, const u32 frame_count,
+  const vk_gpu_culling_config& config) noexcept
+{
+    VKE_ASSERT(frame_count != 0 && frame_count <= max_frames);
+
+    device_ = device;
+    allocator_ = allocator;
+    heap_ = &heap;
+    config_ = config;
+
+    const std::vector<u8> spirv = fs::read_bytes_from_file("engine/shaders/cull.comp.spr");
+    const vk::ShaderModule module = vk_check_result(device_.createShaderModule(vk::ShaderModuleCreateInfo{
+      .codeSize = spirv.size(),
+      .pCode = reinterpret_cast<const u32*>(spirv.data())
+    }));
+
+    pipeline_ = vk_check_result(device_.createComputePipeline(pipeline_cache, vk::ComputePipelineCreateInfo{
+      .stage = vk::PipelineShaderStageCreateInfo{
+        .stage = vk::ShaderStageFlagBits::eCompute,
+        .module = module,
+        .pName = "main"
+      },
+      .layout = heap_->pipeline_layout()
+    }));
+    device_.destroy(module);
+
+    objects_ = create_device_local_buffer(allocator_, sizeof(vk_gpu_object) * config_.max_objects,
+      vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eTransferDst, concurrent_family_indices);
+    objects_handle_ = heap_->register_storage_buffer(objects_.handle);
+
+    frames_.resize(frame_count);
+    for (frame_resources& frame : frames_) {
+        frame.draw_commands = create_device_local_buffer(allocator_, sizeof(vk::DrawIndexedIndirectCommand) * config_.max_objects,
+          vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eIndirectBuffer, concurrent_family_indices);
+        frame.draw_count = create_device_local_buffer(allocator_, sizeof(u32),
+          vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eIndirectBuffer | vk::BufferUsageFlagBits::eTransferDst,
+          concurrent_family_indices);
+
+        frame.draw_commands_handle = heap_->register_storage_buffer(frame.draw_commands.handle);
+        frame.draw_count_handle = heap_->register_storage_buffer(frame.draw_count.handle);
+    }
+
+    VKE_LOG(renderer, verbose, "gpu culling created, max objects: {}", config_.max_objects);
+}
+
+void vk_gpu_culling::destroy() noexcept
+{
+    if (!device_) {
+        return;
+    }
+
+    for (frame_resources& frame : frames_) {
+        heap_->release(vk_bindless_type::storage_buffer, frame.draw_commands_handle);
+        heap_->release(vk_bindless_type::storage_buffer, frame.draw_count_handle);
+        destroy_buffer(allocator_, frame.draw_commands);
+        destroy_buffer(allocator_, frame.draw_count);
+    }
+    frames_.clear();
+
+    heap_->release(vk_bindless_type::storage_buffer, objects_handle_);
+    destroy_buffer(allocator_, objects_);
+
+    device_.destroy(pipeline_);
+    device_ = nullptr;
+}
+
+void vk_gpu_culling::set_objects(vk_upload_context& upload_context, const std::span<const vk_gpu_object> objects) noexcept
+{
+    VKE_ASSERT_MSG(objects.size() <= config_.max_objects, "{} objects exceed the maximum of {}", objects.size(), config_.max_objects);
+
+    object_count_ = static_cast<u32>(objects.size());
+    if (!objects.empty()) {
+        upload_context.upload(objects_, /*dst_offset=*/0, objects,
+          vk::PipelineStageFlagBits2::eComputeShader | vk::PipelineStageFlagBits2::eVertexShader,
+          vk::AccessFlagBits2::eShaderStorageRead);
+    }
+}
+
+void vk_gpu_culling::record_cull(const vk::CommandBuffer cmd, const u32 frame_index,
+  const frustum& view_frustum, const u32 element_count, const bool is_indexed) const noexcept
+{
+    const frame_resources& frame = frames_[frame_index];
+
+    cmd.fillBuffer(frame.draw_count.handle, /*dstOffset=*/0, /*size=*/sizeof(u32), /*data=*/0);
+
+    const vk::BufferMemoryBarrier2 count_reset_barrier{
+      .srcStageMask = vk::PipelineStageFlagBits2::eClear,
+      .srcAccessMask = vk::AccessFlagBits2::eTransferWrite,
+      .dstStageMask = vk::PipelineStageFlagBits2::eComputeShader,
+      .dstAccessMask = vk::AccessFlagBits2::eShaderStorageRead | vk::AccessFlagBits2::eShaderStorageWrite,
+      .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+      .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+      .buffer = frame.draw_count.handle,
+      .offset = 0,
+      .size = VK_WHOLE_SIZE
+    };
+    cmd.pipelineBarrier2(vk::DependencyInfo{
+      .bufferMemoryBarrierCount = 1,
+      .pBufferMemoryBarriers = &count_reset_barrier
+    });
+
+    if (object_count_ == 0) {
+        return;
+    }
+
+    const cull_push_constants constants{
+      .frustum_planes = view_frustum.planes,
+      .object_count = object_count_,
+      .element_count = element_count,
+      .is_indexed = is_indexed ? 1u : 0u,
+      .objects_index = objects_handle_.index,
+      .draw_commands_index = frame.draw_commands_handle.index,
+      .draw_count_index = frame.draw_count_handle.index
+    };
+
+    cmd.bindPipeline(vk::PipelineBindPoint::eCompute, pipeline_);
+    heap_->bind(cmd, vk::PipelineBindPoint::eCompute);
+    heap_->push_constants(cmd, constants);
+    cmd.dispatch((object_count_ + cull_group_size - 1) / cull_group_size, 1, 1);
+}
+
+void vk_gpu_culling::record_draw(const vk::CommandBuffer cmd, const u32 frame_index, const bool is_indexed) const noexcept
+{
+    const frame_resources& frame = frames_[frame_index];
+
+    heap_->push_constants(cmd, draw_push_constants{.objects_index = objects_handle_.index});
+
+    // unindexed commands use the leading fields of the same slots, the stride stays the same
+    if (!is_indexed) {
+        cmd.drawIndirectCount(frame.draw_commands.handle, /*offset=*/0,
+          frame.draw_count.handle, /*countBufferOffset=*/0,
+          /*maxDrawCount=*/object_count_, sizeof(vk::DrawIndexedIndirectCommand));
+        return;
+    }
+
+    cmd.drawIndexedIndirectCount(frame.draw_commands.handle, /*offset=*/0,
+      frame.draw_count.handle, /*countBufferOffset=*/0,
+      /*maxDrawCount=*/object_count_, sizeof(vk::DrawIndexedIndirectCommand));
+}
+
+} // namespace volkano
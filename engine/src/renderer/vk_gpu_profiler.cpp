@@ -0,0 +1,218 @@
+/*
+ * Copyright (C) 2023 Emre Simsirli
+ *
+ * Licensed under GPLv3 or any later version.
+ * Refer to the included LICENSE file.
+ */
+
+#include "renderer/vk_gpu_profiler.h"
+
+#include "core/algo/find_ptr.h"
+#include "renderer/vk_renderer.h"
+
+namespace volkano {
+
+void vk_gpu_profiler::initialize(const vk::Device device, const vk::PhysicalDevice physical_device,
+  const u32 timestamp_valid_bits, const u32 frame_count, const vk_gpu_profiler_config& config) noexcept
+{
+    VKE_ASSERT(frame_count != 0);
+
+    device_ = device;
+    config_ = config;
+
+    if (timestamp_valid_bits == 0) {
+        VKE_LOG(renderer, warning, "queues do not support timestamps, gpu timing is disabled");
+        return;
+    }
+
+    timestamp_period_ns_ = physical_device.getProperties().limits.timestampPeriod;
+    timestamp_mask_ = timestamp_valid_bits >= 64 ? std::numeric_limits<u64>::max() : (u64{1} << timestamp_valid_bits) - 1;
+
+    frames_.resize(frame_count);
+    for (frame_queries& frame : frames_) {
+        frame.timestamp_pool = vk_check_result(device_.createQueryPool(vk::QueryPoolCreateInfo{
+          .queryType = vk::QueryType::eTimestamp,
+          .queryCount = config_.max_scopes_per_frame * 2
+        }));
+        device_.resetQueryPool(frame.timestamp_pool, /*firstQuery=*/0, config_.max_scopes_per_frame * 2);
+
+        if (config_.pipeline_statistics) {
+            frame.statistics_pool = vk_check_result(device_.createQueryPool(vk::QueryPoolCreateInfo{
+              .queryType = vk::QueryType::ePipelineStatistics,
+              .queryCount = config_.max_scopes_per_frame,
+              .pipelineStatistics = statistics_flags
+            }));
+            device_.resetQueryPool(frame.statistics_pool, /*firstQuery=*/0, config_.max_scopes_per_frame);
+        }
+
+        frame.scopes.reserve(config_.max_scopes_per_frame);
+    }
+
+    VKE_LOG(renderer, verbose, "gpu profiler created, timestamp period: {}ns, valid bits: {}, pipeline statistics: {}",
+      timestamp_period_ns_, timestamp_valid_bits, config_.pipeline_statistics);
+}
+
+void vk_gpu_profiler::destroy() noexcept
+{
+    if (!device_) {
+        return;
+    }
+
+    for (const frame_queries& frame : frames_) {
+        device_.destroy(frame.timestamp_pool);
+        device_.destroy(frame.statistics_pool);
+    }
+    frames_.clear();
+    scope_stats_.clear();
+    device_ = nullptr;
+}
+
+void vk_gpu_profiler::begin_frame(const u32 frame_index) noexcept
+{
+    current_frame_ = frame_index;
+    VKE_ASSERT_MSG(active_statistics_scope_ == invalid_scope, "a pipeline statistics scope was never ended");
+
+    if (frames_.empty()) {
+        return;
+    }
+
+    frame_queries& frame = frames_[frame_index];
+    const auto timestamp_count = static_cast<u32>(frame.scopes.size() * 2);
+    if (timestamp_count != 0) {
+        results_.resize(timestamp_count);
+        const vk::Result result = device_.getQueryPoolResults(frame.timestamp_pool, /*firstQuery=*/0, timestamp_count,
+          results_.size() * sizeof(u64), results_.data(), /*stride=*/sizeof(u64), vk::QueryResultFlagBits::e64);
+
+        // the fence signaled so the results are available unless a scope was never submitted
+        if (result == vk::Result::eSuccess) {
+            for (const recorded_scope& scope : frame.scopes) {
+                const u64 ticks = (results_[scope.timestamp_query + 1] - results_[scope.timestamp_query]) & timestamp_mask_;
+                scope_stats_[scope.stats_index].gpu_ms.add(static_cast<f64>(ticks) * timestamp_period_ns_ / 1'000'000.0);
+            }
+        }
+    }
+
+    if (frame.statistics_query_count != 0) {
+        results_.resize(frame.statistics_query_count * statistics_count);
+        const vk::Result result = device_.getQueryPoolResults(frame.statistics_pool, /*firstQuery=*/0, frame.statistics_query_count,
+          results_.size() * sizeof(u64), results_.data(), /*stride=*/statistics_count * sizeof(u64), vk::QueryResultFlagBits::e64);
+
+        if (result == vk::Result::eSuccess) {
+            for (const recorded_scope& scope : frame.scopes) {
+                if (scope.statistics_query == invalid_scope) {
+                    continue;
+                }
+
+                const u64* values = results_.data() + scope.statistics_query * statistics_count;
+                scope_stats_[scope.stats_index].statistics = vk_gpu_pipeline_statistics{
+                  .input_assembly_vertices = values[0],
+                  .input_assembly_primitives = values[1],
+                  .vertex_shader_invocations = values[2],
+                  .fragment_shader_invocations = values[3],
+                  .compute_shader_invocations = values[4]
+                };
+            }
+        }
+    }
+
+    // host reset, the queries of this slot are not in use by the gpu anymore
+    if (timestamp_count != 0) {
+        device_.resetQueryPool(frame.timestamp_pool, /*firstQuery=*/0, timestamp_count);
+    }
+    if (frame.statistics_query_count != 0) {
+        device_.resetQueryPool(frame.statistics_pool, /*firstQuery=*/0, frame.statistics_query_count);
+    }
+
+    frame.scopes.clear();
+    frame.statistics_query_count = 0;
+}
+
+u32 vk_gpu_profiler::begin_scope(const vk::CommandBuffer cmd, const std::string_view name, const bool collect_statistics) noexcept
+{
+    if (!device_) {
+        return invalid_scope;
+    }
+
+    const u32 stats_index = find_or_add_scope_stats(name);
+    if (config_.debug_labels) {
+        cmd.beginDebugUtilsLabelEXT(vk::DebugUtilsLabelEXT{
+          .pLabelName = scope_stats_[stats_index].name.c_str(),
+          .color = {{0.f, 0.f, 0.f, 0.f}}
+        });
+    }
+
+    if (frames_.empty()) {
+        return invalid_scope;
+    }
+
+    frame_queries& frame = frames_[current_frame_];
+    if (frame.scopes.size() == config_.max_scopes_per_frame) {
+        return invalid_scope;
+    }
+
+    const auto scope_id = static_cast<u32>(frame.scopes.size());
+    recorded_scope& scope = frame.scopes.emplace_back(recorded_scope{
+      .stats_index = stats_index,
+      .timestamp_query = scope_id * 2
+    });
+
+    cmd.writeTimestamp2(vk::PipelineStageFlagBits2::eAllCommands, frame.timestamp_pool, scope.timestamp_query);
+
+    if (collect_statistics && config_.pipeline_statistics) {
+        VKE_ASSERT_MSG(active_statistics_scope_ == invalid_scope, "pipeline statistics scope {} is nested in another one", name);
+
+        scope.statistics_query = frame.statistics_query_count++;
+        active_statistics_scope_ = scope_id;
+        cmd.beginQuery(frame.statistics_pool, scope.statistics_query, vk::QueryControlFlags{});
+    }
+
+    return scope_id;
+}
+
+void vk_gpu_profiler::end_scope(const vk::CommandBuffer cmd, const u32 scope_id) noexcept
+{
+    if (!device_) {
+        return;
+    }
+
+    if (scope_id != invalid_scope) {
+        frame_queries& frame = frames_[current_frame_];
+        const recorded_scope& scope = frame.scopes[scope_id];
+
+        if (scope.statistics_query != invalid_scope) {
+            cmd.endQuery(frame.statistics_pool, scope.statistics_query);
+            active_statistics_scope_ = invalid_scope;
+        }
+
+        cmd.writeTimestamp2(vk::PipelineStageFlagBits2::eAllCommands, frame.timestamp_pool, scope.timestamp_query + 1);
+    }
+
+    if (config_.debug_labels) {
+        cmd.endDebugUtilsLabelEXT();
+    }
+}
+
+vk::QueryPipelineStatisticFlags vk_gpu_profiler::inherited_statistics() const noexcept
+{
+    return active_statistics_scope_ != invalid_scope ? statistics_flags : vk::QueryPipelineStatisticFlags{};
+}
+
+const vk_gpu_scope_stats* vk_gpu_profiler::find_scope_stats(const std::string_view name) const noexcept
+{
+    return algo::find_ptr(scope_stats_, name, &vk_gpu_scope_stats::name);
+}
+
+u32 vk_gpu_profiler::find_or_add_scope_stats(const std::string_view name) noexcept
+{
+    // a handful of scopes, a linear search beats hashing the name every time
+    for (u32 i = 0; i < scope_stats_.size(); ++i) {
+        if (scope_stats_[i].name == name) {
+            return i;
+        }
+    }
+
+    scope_stats_.push_back(vk_gpu_scope_stats{.name = std::string{name}});
+    return static_cast<u32>(scope_stats_.size() - 1);
+}
+
+} // namespace volkano
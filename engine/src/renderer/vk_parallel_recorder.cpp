@@ -0,0 +1,106 @@
+/*
+ * Copyright (C) 2023 Emre Simsirli
+ *
+ * Licensed under GPLv3 or any later version.
+ * Refer to the included LICENSE file.
+ */
+
+#include "renderer/vk_parallel_recorder.h"
+
+#include <algorithm>
+#include <memory_resource>
+
+#include "core/memory/scratch_arena.h"
+#include "renderer/vk_renderer.h"
+
+namespace volkano {
+
+void vk_parallel_recorder::initialize(const vk::Device device, const u32 queue_family_index,
+  const u32 frame_count, const u32 slot_count) noexcept
+{
+    VKE_ASSERT(frame_count != 0 && slot_count != 0);
+
+    device_ = device;
+    slot_count_ = slot_count;
+    slots_.resize(frame_count * slot_count);
+    for (slot& s : slots_) {
+        s.pool = vk_check_result(device_.createCommandPool(vk::CommandPoolCreateInfo{
+          .flags = vk::CommandPoolCreateFlagBits::eTransient,
+          .queueFamilyIndex = queue_family_index
+        }));
+
+        s.cmd = vk_check_result(device_.allocateCommandBuffers(vk::CommandBufferAllocateInfo{
+          .commandPool = s.pool,
+          .level = vk::CommandBufferLevel::eSecondary,
+          .commandBufferCount = 1
+        })).front();
+    }
+
+    VKE_LOG(renderer, verbose, "parallel recorder created, {} slots per frame", slot_count_);
+}
+
+void vk_parallel_recorder::destroy() noexcept
+{
+    if (!device_) {
+        return;
+    }
+
+    for (const slot& s : slots_) {
+        device_.destroy(s.pool);
+    }
+    slots_.clear();
+    device_ = nullptr;
+}
+
+void vk_parallel_recorder::reset(const u32 frame_index) noexcept
+{
+    for (u32 i = 0; i < slot_count_; ++i) {
+        vk_check_result(device_.resetCommandPool(slots_[frame_index * slot_count_ + i].pool));
+    }
+}
+
+void vk_parallel_recorder::record(const vk::CommandBuffer primary, const u32 frame_index, job_system& jobs,
+  const vk::CommandBufferInheritanceRenderingInfo& rendering_info,
+  const u32 item_count, const u32 min_items_per_slot, const record_fn& record_range,
+  const vk::QueryPipelineStatisticFlags inherited_statistics) noexcept
+{
+    const u32 max_chunks = std::max(1u, item_count / std::max(1u, min_items_per_slot));
+    const u32 chunk_count = std::min(slot_count_, max_chunks);
+    const u32 chunk_size = (item_count + chunk_count - 1) / std::max(1u, chunk_count);
+
+    const vk::CommandBufferInheritanceInfo inheritance_info{
+      .pNext = &rendering_info,
+      .pipelineStatistics = inherited_statistics
+    };
+    const auto record_chunk = [&](const u32 chunk_index) {
+        const vk::CommandBuffer cmd = slots_[frame_index * slot_count_ + chunk_index].cmd;
+        vk_check_result(cmd.begin(vk::CommandBufferBeginInfo{
+          .flags = vk::CommandBufferUsageFlagBits::eOneTimeSubmit | vk::CommandBufferUsageFlagBits::eRenderPassContinue,
+          .pInheritanceInfo = &inheritance_info
+        }));
+
+        const u32 begin = std::min(item_count, chunk_index * chunk_size);
+        const u32 end = std::min(item_count, begin + chunk_size);
+        record_range(cmd, begin, end);
+
+        vk_check_result(cmd.end());
+    };
+
+    job_counter chunks_recorded;
+    for (u32 chunk_index = 1; chunk_index < chunk_count; ++chunk_index) {
+        jobs.run([&, chunk_index] { record_chunk(chunk_index); }, &chunks_recorded);
+    }
+    record_chunk(0);
+    jobs.wait(chunks_recorded);
+
+    // rebuilt every frame, scratch memory keeps it off the heap
+    scratch_scope scratch;
+    std::pmr::vector<vk::CommandBuffer> secondaries{scratch.resource()};
+    secondaries.reserve(chunk_count);
+    for (u32 chunk_index = 0; chunk_index < chunk_count; ++chunk_index) {
+        secondaries.push_back(slots_[frame_index * slot_count_ + chunk_index].cmd);
+    }
+    primary.executeCommands(secondaries);
+}
+
+} // namespace volkano
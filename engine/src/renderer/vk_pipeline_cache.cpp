@@ -0,0 +1,100 @@
+/*
+ * Copyright (C) 2023 Emre Simsirli
+ *
+ * Licensed under GPLv3 or any later version.
+ * Refer to the included LICENSE file.
+ */
+
+#include "renderer/vk_pipeline_cache.h"
+
+#include <cstring>
+
+#include "renderer/vk_renderer.h"
+
+namespace volkano {
+
+namespace {
+
+bool is_cache_compatible(const std::span<const u8> blob, const vk::PhysicalDeviceProperties& properties) noexcept
+{
+    VkPipelineCacheHeaderVersionOne header;
+    if (blob.size() < sizeof(header)) {
+        VKE_LOG(renderer, warning, "pipeline cache is too small to contain a header: {} bytes", blob.size());
+        return false;
+    }
+
+    std::memcpy(&header, blob.data(), sizeof(header));
+    if (header.headerSize < sizeof(header) || header.headerVersion != VK_PIPELINE_CACHE_HEADER_VERSION_ONE) {
+        VKE_LOG(renderer, warning, "pipeline cache header is invalid, size: {} version: {}",
+          header.headerSize, static_cast<u32>(header.headerVersion));
+        return false;
+    }
+
+    if (header.vendorID != properties.vendorID || header.deviceID != properties.deviceID) {
+        VKE_LOG(renderer, info, "pipeline cache belongs to another device, vendor: {:#x} device: {:#x}",
+          header.vendorID, header.deviceID);
+        return false;
+    }
+
+    if (std::memcmp(header.pipelineCacheUUID, properties.pipelineCacheUUID.data(), VK_UUID_SIZE) != 0) {
+        VKE_LOG(renderer, info, "pipeline cache uuid does not match, driver probably changed");
+        return false;
+    }
+
+    return true;
+}
+
+} // namespace
+
+void vk_pipeline_cache::initialize(const vk::Device device, const vk::PhysicalDevice physical_device, fs::path path) noexcept
+{
+    device_ = device;
+    path_ = std::move(path);
+
+    std::vector<u8> blob;
+    if (fs::exists(path_)) {
+        blob = fs::read_bytes_from_file(path_);
+        if (!is_cache_compatible(blob, physical_device.getProperties())) {
+            blob.clear();
+        }
+    }
+
+    loaded_from_disk_ = !blob.empty();
+    cache_ = vk_check_result(device_.createPipelineCache(vk::PipelineCacheCreateInfo{
+      .initialDataSize = blob.size(),
+      .pInitialData = blob.data()
+    }));
+
+    VKE_LOG(renderer, verbose, "pipeline cache created, {} bytes loaded from {}", blob.size(), path_.string());
+}
+
+void vk_pipeline_cache::destroy() noexcept
+{
+    if (!cache_) {
+        return;
+    }
+
+    save();
+    device_.destroy(cache_);
+    cache_ = nullptr;
+}
+
+void vk_pipeline_cache::save() const noexcept
+{
+    const std::vector<u8> blob = vk_check_result(device_.getPipelineCacheData(cache_));
+    if (blob.empty()) {
+        return;
+    }
+
+    // write next to the old cache first so a crash mid-write does not leave a truncated cache behind
+    fs::path tmp_path = path_;
+    tmp_path += ".tmp";
+    fs::write_bytes_to_file(tmp_path, blob);
+
+    std::error_code err;
+    fs::rename(tmp_path, path_, err);
+    VKE_CLOG(err, renderer, warning, "pipeline cache could not be saved to {}: {}", path_.string(), err.message());
+    VKE_CLOG(!err, renderer, verbose, "pipeline cache saved to {}, {} bytes", path_.string(), blob.size());
+}
+
+} // namespace volkano
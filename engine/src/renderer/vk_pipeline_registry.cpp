@@ -0,0 +1,301 @@
+/*
+ * Copyright (C) 2023 Emre Simsirli
+ *
+ * Licensed under GPLv3 or any later version.
+ * Refer to the included LICENSE file.
+ */
+
+#include "renderer/vk_pipeline_registry.h"
+
+#include "core/util/hash.h"
+#include "renderer/vk_renderer.h"
+
+namespace volkano {
+
+namespace {
+
+u64 hash_pipeline_desc(const vk_graphics_pipeline_desc& desc, const u64 vert_hash, const u64 frag_hash) noexcept
+{
+    u64 hash = hash_combine(vert_hash, frag_hash);
+    hash = hash_values(std::span{desc.vertex_layout.bindings.data(), desc.vertex_layout.bindings.size()}, hash);
+    hash = hash_values(std::span{desc.vertex_layout.attributes.data(), desc.vertex_layout.attributes.size()}, hash);
+    hash = hash_value(desc.topology, hash);
+    hash = hash_value(desc.polygon_mode, hash);
+    hash = hash_value(desc.cull_mode, hash);
+    hash = hash_value(desc.front_face, hash);
+    hash = hash_value(desc.blend_state, hash);
+    hash = hash_value(static_cast<VkPipelineLayout>(desc.layout), hash);
+    hash = hash_values(std::span{desc.color_formats.data(), desc.color_formats.size()}, hash);
+    hash = hash_value(desc.depth_format, hash);
+    hash = hash_value(desc.depth_test_enable, hash);
+    hash = hash_value(desc.depth_write_enable, hash);
+    hash = hash_value(desc.depth_compare_op, hash);
+    return hash;
+}
+
+/** compares the same state hash_pipeline_desc hashes, shaders are compared by their code */
+bool is_same_pipeline_state(const vk_graphics_pipeline_desc& l, const vk_graphics_pipeline_desc& r) noexcept
+{
+    return l.vertex_layout.bindings == r.vertex_layout.bindings
+      && l.vertex_layout.attributes == r.vertex_layout.attributes
+      && l.topology == r.topology
+      && l.polygon_mode == r.polygon_mode
+      && l.cull_mode == r.cull_mode
+      && l.front_face == r.front_face
+      && l.blend_state == r.blend_state
+      && l.layout == r.layout
+      && l.color_formats == r.color_formats
+      && l.depth_format == r.depth_format
+      && l.depth_test_enable == r.depth_test_enable
+      && l.depth_write_enable == r.depth_write_enable
+      && l.depth_compare_op == r.depth_compare_op;
+}
+
+} // namespace
+
+void vk_pipeline_registry::initialize(const vk::Device device, const vk::PipelineCache cache, job_system& jobs) noexcept
+{
+    device_ = device;
+    cache_ = cache;
+    jobs_ = &jobs;
+}
+
+void vk_pipeline_registry::destroy() noexcept
+{
+    if (!device_) {
+        return;
+    }
+
+    jobs_->wait(compile_jobs_);
+    for (entry& e : entries_) {
+        device_.destroy(vk::Pipeline{e.pipeline.load(std::memory_order_acquire)});
+    }
+
+    entries_.clear();
+    hash_to_index_.clear();
+    shader_codes_.clear();
+    compiling_indices_.clear();
+    device_ = nullptr;
+}
+
+vk_pipeline_handle vk_pipeline_registry::request(const vk_graphics_pipeline_desc& desc, const vk_pipeline_compile_mode mode) noexcept
+{
+    std::shared_ptr<const shader_code> vert = load_shader_code(desc.vertex_shader_path);
+    std::shared_ptr<const shader_code> frag = load_shader_code(desc.fragment_shader_path);
+
+    const u64 hash = hash_pipeline_desc(desc, vert->hash, frag->hash);
+    const auto [candidates_begin, candidates_end] = hash_to_index_.equal_range(hash);
+    for (auto it = candidates_begin; it != candidates_end; ++it) {
+        const entry& candidate = entries_[it->second];
+        const bool is_same_vert = candidate.vert == vert || candidate.vert->spirv == vert->spirv;
+        const bool is_same_frag = candidate.frag == frag || candidate.frag->spirv == frag->spirv;
+        if (is_same_vert && is_same_frag && is_same_pipeline_state(candidate.desc, desc)) {
+            return vk_pipeline_handle{it->second};
+        }
+    }
+
+    const auto index = static_cast<u32>(entries_.size());
+    entry& e = entries_.emplace_back();
+    e.hash = hash;
+    e.desc = desc;
+    e.vert = vert;
+    e.frag = frag;
+    e.debug_name = fmt::format("{}|{}", desc.vertex_shader_path.filename().string(), desc.fragment_shader_path.filename().string());
+    hash_to_index_.emplace(hash, index);
+
+    if (mode == vk_pipeline_compile_mode::sync) {
+        e.pipeline.store(static_cast<VkPipeline>(create_pipeline(desc, *vert, *frag)), std::memory_order_release);
+        VKE_LOG(renderer, verbose, "pipeline {} ({:#x}) compiled synchronously", e.debug_name, hash);
+    } else {
+        compiling_indices_.push_back(index);
+        compiling_count_.fetch_add(1, std::memory_order_relaxed);
+
+        // entries live in a deque so the address stays valid while the registry grows. compiles take
+        // long, in the background they are never run inline by a thread that waits on frame work
+        jobs_->run([this, &e, desc, vert = std::move(vert), frag = std::move(frag)]() {
+            e.pipeline.store(static_cast<VkPipeline>(create_pipeline(desc, *vert, *frag)), std::memory_order_release);
+            compiling_count_.fetch_sub(1, std::memory_order_relaxed);
+        }, &compile_jobs_, job_priority::background);
+        VKE_LOG(renderer, verbose, "pipeline {} ({:#x}) queued for compilation", e.debug_name, hash);
+    }
+
+    return vk_pipeline_handle{index};
+}
+
+void vk_pipeline_registry::set_fallback(const vk_pipeline_handle handle) noexcept
+{
+    VKE_ASSERT_MSG(is_ready(handle), "fallback pipeline must be compiled synchronously");
+    fallback_ = handle;
+}
+
+void vk_pipeline_registry::update() noexcept
+{
+    std::erase_if(compiling_indices_, [&](const u32 index) {
+        if (!is_ready(vk_pipeline_handle{index})) {
+            return false;
+        }
+
+        VKE_LOG(renderer, verbose, "pipeline {} ({:#x}) is ready", entries_[index].debug_name, entries_[index].hash);
+        return true;
+    });
+}
+
+vk::Pipeline vk_pipeline_registry::get(const vk_pipeline_handle handle) const noexcept
+{
+    if (const VkPipeline pipeline = entry_at(handle).pipeline.load(std::memory_order_acquire)) {
+        return vk::Pipeline{pipeline};
+    }
+
+    VKE_ASSERT_MSG(fallback_.is_valid(), "pipeline is not ready and there is no fallback");
+    return vk::Pipeline{entry_at(fallback_).pipeline.load(std::memory_order_acquire)};
+}
+
+bool vk_pipeline_registry::is_ready(const vk_pipeline_handle handle) const noexcept
+{
+    return entry_at(handle).pipeline.load(std::memory_order_acquire) != VK_NULL_HANDLE;
+}
+
+usize vk_pipeline_registry::pipeline_count() const noexcept
+{
+    return entries_.size();
+}
+
+std::shared_ptr<const vk_pipeline_registry::shader_code> vk_pipeline_registry::load_shader_code(const fs::path& path) noexcept
+{
+    auto& code = shader_codes_[path.string()];
+    if (!code) {
+        std::vector<u8> spirv = fs::read_bytes_from_file(path);
+        const u64 hash = hash_values(std::span<const u8>{spirv});
+        code = std::make_shared<const shader_code>(shader_code{.spirv = std::move(spirv), .hash = hash});
+    }
+    return code;
+}
+
+vk::Pipeline vk_pipeline_registry::create_pipeline(const vk_graphics_pipeline_desc& desc,
+  const shader_code& vert, const shader_code& frag) const noexcept
+{
+    const auto create_shader_module = [&](const shader_code& code) {
+        return vk_check_result(device_.createShaderModule(vk::ShaderModuleCreateInfo{
+          .codeSize = code.spirv.size(),
+          .pCode = reinterpret_cast<const u32*>(code.spirv.data())
+        }));
+    };
+
+    const vk::ShaderModule vert_module = create_shader_module(vert);
+    const vk::ShaderModule frag_module = create_shader_module(frag);
+
+    const static_vector<vk::PipelineShaderStageCreateInfo, 2> shader_stage_create_infos{
+      vk::PipelineShaderStageCreateInfo{
+        .stage = vk::ShaderStageFlagBits::eVertex,
+        .module = vert_module,
+        .pName = "main"
+      },
+      vk::PipelineShaderStageCreateInfo{
+        .stage = vk::ShaderStageFlagBits::eFragment,
+        .module = frag_module,
+        .pName = "main"
+      }
+    };
+
+    const static_vector<vk::DynamicState, 2> dynamic_states{
+      vk::DynamicState::eViewport,
+      vk::DynamicState::eScissor
+    };
+
+    const vk::PipelineDynamicStateCreateInfo dynamic_state_create_info{
+      .dynamicStateCount = dynamic_states.size(),
+      .pDynamicStates = dynamic_states.data()
+    };
+
+    const vk::PipelineVertexInputStateCreateInfo vertex_input_state_create_info{
+      .vertexBindingDescriptionCount = desc.vertex_layout.bindings.size(),
+      .pVertexBindingDescriptions = desc.vertex_layout.bindings.data(),
+      .vertexAttributeDescriptionCount = desc.vertex_layout.attributes.size(),
+      .pVertexAttributeDescriptions = desc.vertex_layout.attributes.data()
+    };
+
+    const vk::PipelineInputAssemblyStateCreateInfo input_assembly_state_create_info{
+      .topology = desc.topology,
+      .primitiveRestartEnable = false
+    };
+
+    const vk::PipelineViewportStateCreateInfo viewport_state_create_info{
+      .viewportCount = 1,
+      .scissorCount = 1
+    };
+
+    const vk::PipelineRasterizationStateCreateInfo rasterization_state_create_info{
+      .depthClampEnable = false,
+      .rasterizerDiscardEnable = false,
+      .polygonMode = desc.polygon_mode,
+      .cullMode = desc.cull_mode,
+      .frontFace = desc.front_face,
+      .depthBiasClamp = false,
+      .lineWidth = 1.f
+    };
+
+    const vk::PipelineMultisampleStateCreateInfo multisample_state_create_info{
+      .rasterizationSamples = vk::SampleCountFlagBits::e1,
+      .sampleShadingEnable = false // msaa disabled
+    };
+
+    // every color attachment blends the same way
+    static_vector<vk::PipelineColorBlendAttachmentState, 4> blend_states;
+    for (usize i = 0; i < desc.color_formats.size(); ++i) {
+        blend_states.push_back(desc.blend_state);
+    }
+
+    const vk::PipelineColorBlendStateCreateInfo color_blend_state_create_info{
+      .logicOpEnable = false,
+      .logicOp = vk::LogicOp::eCopy,
+      .attachmentCount = blend_states.size(),
+      .pAttachments = blend_states.data(),
+      .blendConstants = {{0.f, 0.f, 0.f, 0.f}}
+    };
+
+    const vk::PipelineDepthStencilStateCreateInfo depth_stencil_state_create_info{
+      .depthTestEnable = desc.depth_test_enable,
+      .depthWriteEnable = desc.depth_write_enable,
+      .depthCompareOp = desc.depth_compare_op,
+      .depthBoundsTestEnable = false,
+      .stencilTestEnable = false,
+      .minDepthBounds = 0.f,
+      .maxDepthBounds = 1.f
+    };
+
+    const vk::PipelineRenderingCreateInfo rendering_create_info{
+      .colorAttachmentCount = desc.color_formats.size(),
+      .pColorAttachmentFormats = desc.color_formats.data(),
+      .depthAttachmentFormat = desc.depth_format
+    };
+
+    const vk::GraphicsPipelineCreateInfo pipeline_create_info{
+      .pNext = &rendering_create_info,
+      .stageCount = shader_stage_create_infos.size(),
+      .pStages = shader_stage_create_infos.data(),
+      .pVertexInputState = &vertex_input_state_create_info,
+      .pInputAssemblyState = &input_assembly_state_create_info,
+      .pViewportState = &viewport_state_create_info,
+      .pRasterizationState = &rasterization_state_create_info,
+      .pMultisampleState = &multisample_state_create_info,
+      .pDepthStencilState = desc.depth_format != vk::Format::eUndefined ? &depth_stencil_state_create_info : nullptr,
+      .pColorBlendState = &color_blend_state_create_info,
+      .pDynamicState = &dynamic_state_create_info,
+      .layout = desc.layout
+    };
+
+    // the pipeline cache is internally synchronized so workers can share it
+    const vk::Pipeline pipeline = vk_check_result(device_.createGraphicsPipeline(cache_, pipeline_create_info));
+
+    device_.destroy(vert_module);
+    device_.destroy(frag_module);
+    return pipeline;
+}
+
+const vk_pipeline_registry::entry& vk_pipeline_registry::entry_at(const vk_pipeline_handle handle) const noexcept
+{
+    VKE_ASSERT(handle.index < entries_.size());
+    return entries_[handle.index];
+}
+
+} // namespace volkano
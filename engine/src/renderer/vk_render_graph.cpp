@@ -0,0 +1,630 @@
+/*
+ * Copyright (C) 2023 Emre Simsirli
+ *
+ * Licensed under GPLv3 or any later version.
+ * Refer to the included LICENSE file.
+ */
+
+#include "renderer/vk_render_graph.h"
+
+#include <algorithm>
+#include <numeric>
+#include <span>
+
+#include "renderer/vk_renderer.h"
+
+namespace volkano {
+
+namespace {
+
+constexpr vk::AccessFlags2 write_access_mask = vk::AccessFlagBits2::eShaderWrite
+  | vk::AccessFlagBits2::eShaderStorageWrite
+  | vk::AccessFlagBits2::eColorAttachmentWrite
+  | vk::AccessFlagBits2::eDepthStencilAttachmentWrite
+  | vk::AccessFlagBits2::eTransferWrite
+  | vk::AccessFlagBits2::eHostWrite
+  | vk::AccessFlagBits2::eMemoryWrite;
+
+vk::DeviceSize align_up(const vk::DeviceSize value, const vk::DeviceSize alignment) noexcept
+{
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+bool lifetimes_overlap(const u32 first_a, const u32 last_a, const u32 first_b, const u32 last_b) noexcept
+{
+    return first_a <= last_b && first_b <= last_a;
+}
+
+bool ranges_overlap(const vk::DeviceSize offset_a, const vk::DeviceSize size_a,
+  const vk::DeviceSize offset_b, const vk::DeviceSize size_b) noexcept
+{
+    return offset_a < offset_b + size_b && offset_b < offset_a + size_a;
+}
+
+} // namespace
+
+vk::DeviceSize vk_rg_place_transients(const std::span<vk_rg_placement> placements, const vk::DeviceSize alignment) noexcept
+{
+    // largest first, each image takes the lowest offset that is free for its whole lifetime
+    std::vector<u32> order(placements.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::ranges::stable_sort(order, std::greater{}, [&](const u32 index) { return placements[index].size; });
+
+    vk::DeviceSize block_size = 0;
+    std::vector<const vk_rg_placement*> placed;
+    std::vector<const vk_rg_placement*> conflicts;
+    for (const u32 index : order) {
+        vk_rg_placement& p = placements[index];
+
+        conflicts.clear();
+        for (const vk_rg_placement* other : placed) {
+            if (lifetimes_overlap(p.first_pass, p.last_pass, other->first_pass, other->last_pass)) {
+                conflicts.push_back(other);
+            }
+        }
+        std::ranges::sort(conflicts, std::less{}, [](const vk_rg_placement* other) { return other->offset; });
+
+        vk::DeviceSize offset = 0;
+        for (const vk_rg_placement* other : conflicts) {
+            if (offset + p.size <= other->offset) {
+                break;
+            }
+            offset = std::max(offset, align_up(other->offset + other->size, alignment));
+        }
+
+        p.offset = offset;
+        block_size = std::max(block_size, p.offset + p.size);
+        placed.push_back(&p);
+    }
+    return block_size;
+}
+
+void vk_render_graph::pass_builder::read(const vk_rg_resource resource, const vk_rg_usage& usage) noexcept
+{
+    graph_.add_use(pass_index_, resource, usage, /*reads=*/true, /*writes=*/false);
+}
+
+void vk_render_graph::pass_builder::write(const vk_rg_resource resource, const vk_rg_usage& usage) noexcept
+{
+    graph_.add_use(pass_index_, resource, usage, /*reads=*/false, /*writes=*/true);
+}
+
+void vk_render_graph::pass_builder::read_write(const vk_rg_resource resource, const vk_rg_usage& usage) noexcept
+{
+    graph_.add_use(pass_index_, resource, usage, /*reads=*/true, /*writes=*/true);
+}
+
+void vk_render_graph::pass_builder::set_side_effects() noexcept
+{
+    graph_.passes_[pass_index_].has_side_effects = true;
+}
+
+void vk_render_graph::initialize(const vk::Device device, const vma::Allocator allocator, std::pmr::memory_resource* frame_memory) noexcept
+{
+    VKE_ASSERT(frame_memory != nullptr);
+
+    device_ = device;
+    allocator_ = allocator;
+    frame_memory_ = frame_memory;
+}
+
+void vk_render_graph::destroy() noexcept
+{
+    if (!device_) {
+        return;
+    }
+
+    reset();
+    destroy_transients();
+    device_ = nullptr;
+}
+
+void vk_render_graph::reset() noexcept
+{
+    resources_.clear();
+    passes_.clear();
+    final_image_barriers_.clear();
+    final_buffer_barriers_.clear();
+    is_compiled_ = false;
+}
+
+vk_rg_resource vk_render_graph::import_image(std::string name, const vk::Image image, const vk::ImageView view,
+  const vk_rg_image_desc& desc, const vk_rg_usage& initial_usage, std::optional<vk_rg_usage> final_usage) noexcept
+{
+    VKE_ASSERT(!is_compiled_);
+
+    const vk::AccessFlags2 initial_writes = initial_usage.access & write_access_mask;
+    resources_.push_back(resource{
+      .name = std::move(name),
+      .is_image = true,
+      .desc = desc,
+      .image = image,
+      .view = view,
+      .initial_state = resource_state{
+        .write_stages = initial_writes ? initial_usage.stages : vk::PipelineStageFlags2{},
+        .write_access = initial_writes,
+        .read_stages = initial_usage.stages,
+        .layout = initial_usage.layout
+      },
+      .final_usage = final_usage
+    });
+    return vk_rg_resource{static_cast<u32>(resources_.size() - 1)};
+}
+
+vk_rg_resource vk_render_graph::import_buffer(std::string name, const vk::Buffer buffer, const vk_rg_usage& initial_usage) noexcept
+{
+    VKE_ASSERT(!is_compiled_);
+
+    const vk::AccessFlags2 initial_writes = initial_usage.access & write_access_mask;
+    resources_.push_back(resource{
+      .name = std::move(name),
+      .buffer = buffer,
+      .initial_state = resource_state{
+        .write_stages = initial_writes ? initial_usage.stages : vk::PipelineStageFlags2{},
+        .write_access = initial_writes,
+        .read_stages = initial_usage.stages
+      }
+    });
+    return vk_rg_resource{static_cast<u32>(resources_.size() - 1)};
+}
+
+vk_rg_resource vk_render_graph::create_image(std::string name, const vk_rg_image_desc& desc) noexcept
+{
+    VKE_ASSERT(!is_compiled_);
+    VKE_ASSERT_MSG(desc.extent.width != 0 && desc.extent.height != 0, "transient image {} has no extent", name);
+
+    resources_.push_back(resource{
+      .name = std::move(name),
+      .is_image = true,
+      .is_transient = true,
+      .desc = desc
+    });
+    return vk_rg_resource{static_cast<u32>(resources_.size() - 1)};
+}
+
+void vk_render_graph::add_pass(std::string name, const std::function<void(pass_builder&)>& setup, execute_fn execute) noexcept
+{
+    VKE_ASSERT(!is_compiled_);
+
+    const auto pass_index = static_cast<u32>(passes_.size());
+    passes_.push_back(pass{
+      .name = std::move(name),
+      .uses = std::pmr::vector<resource_use>{frame_memory_},
+      .execute = std::move(execute),
+      .image_barriers = std::pmr::vector<vk::ImageMemoryBarrier2>{frame_memory_},
+      .buffer_barriers = std::pmr::vector<vk::BufferMemoryBarrier2>{frame_memory_}
+    });
+
+    pass_builder builder{*this, pass_index};
+    setup(builder);
+}
+
+void vk_render_graph::compile() noexcept
+{
+    VKE_ASSERT(!is_compiled_);
+
+    stats_ = vk_rg_stats{.pass_count = static_cast<u32>(passes_.size())};
+
+    cull_passes();
+    compute_lifetimes();
+    allocate_transients();
+    compute_barriers();
+    is_compiled_ = true;
+}
+
+void vk_render_graph::execute(const vk::CommandBuffer cmd, vk_gpu_profiler* profiler) const noexcept
+{
+    VKE_ASSERT_MSG(is_compiled_, "render graph must be compiled before it is executed");
+
+    const auto record_barriers = [cmd](const std::span<const vk::ImageMemoryBarrier2> image_barriers,
+      const std::span<const vk::BufferMemoryBarrier2> buffer_barriers) {
+        if (image_barriers.empty() && buffer_barriers.empty()) {
+            return;
+        }
+
+        cmd.pipelineBarrier2(vk::DependencyInfo{
+          .bufferMemoryBarrierCount = static_cast<u32>(buffer_barriers.size()),
+          .pBufferMemoryBarriers = buffer_barriers.data(),
+          .imageMemoryBarrierCount = static_cast<u32>(image_barriers.size()),
+          .pImageMemoryBarriers = image_barriers.data()
+        });
+    };
+
+    for (const pass& p : passes_) {
+        if (p.is_culled) {
+            continue;
+        }
+
+        record_barriers(p.image_barriers, p.buffer_barriers);
+
+        const u32 scope_id = profiler ? profiler->begin_scope(cmd, p.name) : vk_gpu_profiler::invalid_scope;
+        if (p.execute) {
+            p.execute(cmd);
+        }
+        if (profiler) {
+            profiler->end_scope(cmd, scope_id);
+        }
+    }
+
+    record_barriers(final_image_barriers_, final_buffer_barriers_);
+}
+
+vk::Image vk_render_graph::image(const vk_rg_resource resource) const noexcept
+{
+    const auto& r = resource_at(resource);
+    VKE_ASSERT_MSG(r.is_image, "{} is not an image", r.name);
+    return r.image;
+}
+
+vk::ImageView vk_render_graph::image_view(const vk_rg_resource resource) const noexcept
+{
+    const auto& r = resource_at(resource);
+    VKE_ASSERT_MSG(r.is_image, "{} is not an image", r.name);
+    return r.view;
+}
+
+vk::Buffer vk_render_graph::buffer(const vk_rg_resource resource) const noexcept
+{
+    const auto& r = resource_at(resource);
+    VKE_ASSERT_MSG(!r.is_image, "{} is not a buffer", r.name);
+    return r.buffer;
+}
+
+const vk_rg_image_desc& vk_render_graph::image_desc(const vk_rg_resource resource) const noexcept
+{
+    const auto& r = resource_at(resource);
+    VKE_ASSERT_MSG(r.is_image, "{} is not an image", r.name);
+    return r.desc;
+}
+
+bool vk_render_graph::is_culled(const u32 pass_index) const noexcept
+{
+    VKE_ASSERT(is_compiled_ && pass_index < passes_.size());
+    return passes_[pass_index].is_culled;
+}
+
+std::span<const vk::ImageMemoryBarrier2> vk_render_graph::image_barriers(const u32 pass_index) const noexcept
+{
+    VKE_ASSERT(is_compiled_ && pass_index < passes_.size());
+    return passes_[pass_index].image_barriers;
+}
+
+std::span<const vk::BufferMemoryBarrier2> vk_render_graph::buffer_barriers(const u32 pass_index) const noexcept
+{
+    VKE_ASSERT(is_compiled_ && pass_index < passes_.size());
+    return passes_[pass_index].buffer_barriers;
+}
+
+void vk_render_graph::add_use(const u32 pass_index, const vk_rg_resource resource,
+  const vk_rg_usage& usage, const bool reads, const bool writes) noexcept
+{
+    VKE_ASSERT(resource.index < resources_.size());
+    VKE_ASSERT_MSG(!resources_[resource.index].is_image || usage.layout != vk::ImageLayout::eUndefined,
+      "pass {} uses image {} without a layout", passes_[pass_index].name, resources_[resource.index].name);
+
+    passes_[pass_index].uses.push_back(resource_use{
+      .resource_index = resource.index,
+      .usage = usage,
+      .reads = reads,
+      .writes = writes
+    });
+}
+
+void vk_render_graph::cull_passes() noexcept
+{
+    // imported resources are visible outside of the graph, transients only matter if a live pass reads them
+    std::pmr::vector<bool> is_needed(resources_.size(), frame_memory_);
+    for (usize i = 0; i < resources_.size(); ++i) {
+        is_needed[i] = !resources_[i].is_transient;
+    }
+
+    for (auto it = passes_.rbegin(); it != passes_.rend(); ++it) {
+        pass& p = *it;
+        p.is_culled = !p.has_side_effects && std::ranges::none_of(p.uses, [&](const resource_use& use) {
+            return use.writes && is_needed[use.resource_index];
+        });
+
+        if (p.is_culled) {
+            ++stats_.culled_pass_count;
+            continue;
+        }
+
+        // a full overwrite hides every earlier write from the passes after this one
+        for (const resource_use& use : p.uses) {
+            if (use.writes && !use.reads && resources_[use.resource_index].is_transient) {
+                is_needed[use.resource_index] = false;
+            }
+        }
+        for (const resource_use& use : p.uses) {
+            if (use.reads) {
+                is_needed[use.resource_index] = true;
+            }
+        }
+    }
+}
+
+void vk_render_graph::compute_lifetimes() noexcept
+{
+    for (u32 pass_index = 0; pass_index < passes_.size(); ++pass_index) {
+        const pass& p = passes_[pass_index];
+        if (p.is_culled) {
+            continue;
+        }
+
+        for (const resource_use& use : p.uses) {
+            resource& r = resources_[use.resource_index];
+            r.image_usage |= use.usage.image_usage;
+            r.first_pass = std::min(r.first_pass, pass_index);
+            r.last_pass = std::max(r.last_pass, pass_index);
+        }
+    }
+}
+
+void vk_render_graph::allocate_transients() noexcept
+{
+    // the cached images are compared as a whole, a hash of the layout could collide
+    bool is_cached = true;
+    u32 transient_count = 0;
+    for (resource& r : resources_) {
+        const bool is_used = r.first_pass != std::numeric_limits<u32>::max();
+        if (!r.is_transient || !is_used) {
+            continue;
+        }
+
+        r.transient_index = transient_count++;
+        if (is_cached && r.transient_index < transients_.size()) {
+            const transient_image& t = transients_[r.transient_index];
+            is_cached = t.desc == r.desc && t.usage == r.image_usage && t.first_pass == r.first_pass && t.last_pass == r.last_pass;
+        }
+    }
+
+    is_cached = is_cached && transient_count == transients_.size();
+    if (!is_cached) {
+        // only this graph's frame used the old images and its fence has been waited on
+        destroy_transients();
+
+        for (const resource& r : resources_) {
+            if (r.transient_index == std::numeric_limits<u32>::max()) {
+                continue;
+            }
+
+            transients_.push_back(transient_image{
+              .desc = r.desc,
+              .usage = r.image_usage,
+              .first_pass = r.first_pass,
+              .last_pass = r.last_pass,
+              .image = vk_check_result(device_.createImage(vk::ImageCreateInfo{
+                .imageType = vk::ImageType::e2D,
+                .format = r.desc.format,
+                .extent = vk::Extent3D{r.desc.extent.width, r.desc.extent.height, 1},
+                .mipLevels = 1,
+                .arrayLayers = 1,
+                .samples = vk::SampleCountFlagBits::e1,
+                .tiling = vk::ImageTiling::eOptimal,
+                .usage = r.image_usage,
+                .sharingMode = vk::SharingMode::eExclusive,
+                .initialLayout = vk::ImageLayout::eUndefined
+              }))
+            });
+        }
+
+        if (!transients_.empty()) {
+            vk::MemoryRequirements block_requirements{
+              .size = 0,
+              .alignment = 1,
+              .memoryTypeBits = std::numeric_limits<u32>::max()
+            };
+
+            std::vector<vk_rg_placement> placements;
+            placements.reserve(transients_.size());
+            for (transient_image& t : transients_) {
+                const vk::MemoryRequirements requirements = device_.getImageMemoryRequirements(t.image);
+                t.size = requirements.size;
+                block_requirements.alignment = std::max(block_requirements.alignment, requirements.alignment);
+                block_requirements.memoryTypeBits &= requirements.memoryTypeBits;
+                placements.push_back(vk_rg_placement{
+                  .first_pass = t.first_pass,
+                  .last_pass = t.last_pass,
+                  .size = t.size
+                });
+            }
+            VKE_ASSERT_MSG(block_requirements.memoryTypeBits != 0, "transient images do not share a memory type");
+
+            block_requirements.size = vk_rg_place_transients(placements, block_requirements.alignment);
+            for (usize i = 0; i < transients_.size(); ++i) {
+                transients_[i].offset = placements[i].offset;
+            }
+
+            transient_memory_ = vk_check_result(allocator_.allocateMemory(block_requirements, vma::AllocationCreateInfo{
+              .requiredFlags = vk::MemoryPropertyFlagBits::eDeviceLocal
+            }));
+
+            for (transient_image& t : transients_) {
+                vk_check_result(allocator_.bindImageMemory2(transient_memory_, t.offset, t.image, nullptr));
+                t.view = vk_check_result(device_.createImageView(vk::ImageViewCreateInfo{
+                  .image = t.image,
+                  .viewType = vk::ImageViewType::e2D,
+                  .format = t.desc.format,
+                  .subresourceRange = {
+                    .aspectMask = t.desc.aspect,
+                    .baseMipLevel = 0,
+                    .levelCount = 1,
+                    .baseArrayLayer = 0,
+                    .layerCount = 1
+                  }
+                }));
+            }
+
+            VKE_LOG(renderer, verbose, "render graph allocated {} transient images in {} bytes", transients_.size(), block_requirements.size);
+        }
+    }
+
+    for (resource& r : resources_) {
+        if (r.transient_index == std::numeric_limits<u32>::max()) {
+            continue;
+        }
+
+        const transient_image& t = transients_[r.transient_index];
+        r.image = t.image;
+        r.view = t.view;
+        stats_.transient_requested_size += t.size;
+        stats_.transient_memory_size = std::max(stats_.transient_memory_size, t.offset + t.size);
+    }
+}
+
+void vk_render_graph::destroy_transients() noexcept
+{
+    for (const transient_image& t : transients_) {
+        device_.destroy(t.view);
+        device_.destroy(t.image);
+    }
+    transients_.clear();
+
+    if (transient_memory_) {
+        allocator_.freeMemory(transient_memory_);
+        transient_memory_ = nullptr;
+    }
+}
+
+void vk_render_graph::compute_barriers() noexcept
+{
+    std::pmr::vector<resource_state> states(resources_.size(), frame_memory_);
+    // stages of the write that the state's reads already waited for
+    std::pmr::vector<vk::PipelineStageFlags2> visible_stages(resources_.size(), frame_memory_);
+    for (usize i = 0; i < resources_.size(); ++i) {
+        states[i] = resources_[i].initial_state;
+    }
+
+    const auto make_image_barrier = [&](const resource& r, const resource_state& state, const vk_rg_usage& usage,
+      const vk::PipelineStageFlags2 src_stages) {
+        return vk::ImageMemoryBarrier2{
+          .srcStageMask = src_stages,
+          .srcAccessMask = state.write_access,
+          .dstStageMask = usage.stages,
+          .dstAccessMask = usage.access,
+          .oldLayout = state.layout,
+          .newLayout = usage.layout,
+          .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+          .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+          .image = r.image,
+          .subresourceRange = {
+            .aspectMask = r.desc.aspect,
+            .baseMipLevel = 0,
+            .levelCount = VK_REMAINING_MIP_LEVELS,
+            .baseArrayLayer = 0,
+            .layerCount = VK_REMAINING_ARRAY_LAYERS
+          }
+        };
+    };
+
+    const auto make_buffer_barrier = [&](const resource& r, const resource_state& state, const vk_rg_usage& usage,
+      const vk::PipelineStageFlags2 src_stages) {
+        return vk::BufferMemoryBarrier2{
+          .srcStageMask = src_stages,
+          .srcAccessMask = state.write_access,
+          .dstStageMask = usage.stages,
+          .dstAccessMask = usage.access,
+          .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+          .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+          .buffer = r.buffer,
+          .offset = 0,
+          .size = VK_WHOLE_SIZE
+        };
+    };
+
+    // emits the barrier a use needs against the previous state of the resource and advances the state,
+    // pass barriers live in frame memory while the final ones keep their capacity across frames
+    const auto transition = [&](const u32 resource_index, const vk_rg_usage& usage, const bool writes,
+      auto& image_barriers, auto& buffer_barriers) {
+        const resource& r = resources_[resource_index];
+        resource_state& state = states[resource_index];
+
+        const bool changes_layout = r.is_image && state.layout != usage.layout;
+        bool needs_barrier = false;
+        vk::PipelineStageFlags2 src_stages;
+        if (writes || changes_layout) {
+            // write after write, write after read, or a layout transition which is a write itself
+            src_stages = state.write_stages | state.read_stages;
+            needs_barrier = changes_layout || src_stages;
+        } else if (state.write_access && (usage.stages & ~visible_stages[resource_index])) {
+            // read after write that no earlier barrier made visible to these stages
+            src_stages = state.write_stages;
+            needs_barrier = true;
+        }
+
+        if (needs_barrier) {
+            if (r.is_image) {
+                image_barriers.push_back(make_image_barrier(r, state, usage, src_stages));
+            } else {
+                buffer_barriers.push_back(make_buffer_barrier(r, state, usage, src_stages));
+            }
+            ++stats_.barrier_count;
+        }
+
+        if (writes) {
+            visible_stages[resource_index] = vk::PipelineStageFlags2{};
+            state.read_stages = vk::PipelineStageFlags2{};
+            state.write_stages = usage.stages;
+            state.write_access = usage.access & write_access_mask;
+        } else if (changes_layout) {
+            // later readers chain through the stages the transition was ordered before
+            visible_stages[resource_index] = usage.stages;
+            state.read_stages = usage.stages;
+            state.write_stages = usage.stages;
+        } else {
+            visible_stages[resource_index] |= usage.stages;
+            state.read_stages |= usage.stages;
+        }
+        if (r.is_image) {
+            state.layout = usage.layout;
+        }
+    };
+
+    for (u32 pass_index = 0; pass_index < passes_.size(); ++pass_index) {
+        pass& p = passes_[pass_index];
+        p.image_barriers.clear();
+        p.buffer_barriers.clear();
+        if (p.is_culled) {
+            continue;
+        }
+
+        for (const resource_use& use : p.uses) {
+            const resource& r = resources_[use.resource_index];
+            if (r.is_transient && r.first_pass == pass_index) {
+                // the memory may still be in use by an aliased image whose lifetime ended earlier
+                const transient_image& t = transients_[r.transient_index];
+                resource_state& state = states[use.resource_index];
+                for (usize i = 0; i < resources_.size(); ++i) {
+                    const resource& other = resources_[i];
+                    if (other.transient_index == std::numeric_limits<u32>::max() || other.last_pass >= pass_index) {
+                        continue;
+                    }
+
+                    const transient_image& other_t = transients_[other.transient_index];
+                    if (ranges_overlap(t.offset, t.size, other_t.offset, other_t.size)) {
+                        state.write_stages |= states[i].write_stages;
+                        state.write_access |= states[i].write_access;
+                        state.read_stages |= states[i].read_stages;
+                    }
+                }
+                state.layout = vk::ImageLayout::eUndefined;
+            }
+
+            transition(use.resource_index, use.usage, use.writes, p.image_barriers, p.buffer_barriers);
+        }
+    }
+
+    for (usize i = 0; i < resources_.size(); ++i) {
+        if (const resource& r = resources_[i]; r.final_usage) {
+            transition(static_cast<u32>(i), *r.final_usage, /*writes=*/false, final_image_barriers_, final_buffer_barriers_);
+        }
+    }
+}
+
+const vk_render_graph::resource& vk_render_graph::resource_at(const vk_rg_resource handle) const noexcept
+{
+    VKE_ASSERT(handle.index < resources_.size());
+    return resources_[handle.index];
+}
+
+} // namespace volkano
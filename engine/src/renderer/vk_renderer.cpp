@@ -7,6 +7,9 @@
 
 #include "renderer/vk_renderer.h"
 
+#include <algorithm>
+#include <cstring>
+#include <iterator>
 #include <span>
 
 #include <SDL2/SDL_vulkan.h>
@@ -17,8 +20,10 @@
 
 #include "version.h"
 #include "core/algo/contains_if.h"
+#include "core/container/small_vector.h"
 #include "core/container/static_vector.h"
 #include "core/util/fmt_formatters.h"
+#include "core/util/variant_visit_nt.h"
 #include "renderer/vk_fmt_formatters.h"
 
 VULKAN_HPP_DEFAULT_DISPATCH_LOADER_DYNAMIC_STORAGE
@@ -125,24 +130,52 @@ u32 rate_physical_device(const vk::PhysicalDevice dev) noexcept
         case vk::PhysicalDeviceType::eVirtualGpu:
             rating += 50;
             break;
-        case vk::PhysicalDeviceType::eOther:
         case vk::PhysicalDeviceType::eCpu:
+            // software implementations like lavapipe are the last resort, they make headless runs possible anywhere
+            rating += 1;
+            break;
+        case vk::PhysicalDeviceType::eOther:
             break;
     }
 
     return rating;
 }
 
+vk::IndexType to_vk_index_type(const mesh_index_buffer& indices) noexcept
+{
+    return visit_nt(indices,
+      [](const mesh_buffer<u16>&) { return vk::IndexType::eUint16; },
+      [](const mesh_buffer<u32>&) { return vk::IndexType::eUint32; });
+}
+
+vk::Format find_depth_format(const vk::PhysicalDevice physical_device) noexcept
+{
+    // at least one of the first two is guaranteed, d16 is the last resort
+    for (const vk::Format format : {vk::Format::eD32Sfloat, vk::Format::eX8D24UnormPack32, vk::Format::eD16Unorm}) {
+        const vk::FormatProperties properties = physical_device.getFormatProperties(format);
+        if (properties.optimalTilingFeatures & vk::FormatFeatureFlagBits::eDepthStencilAttachment) {
+            return format;
+        }
+    }
+
+    VKE_ASSERT_MSG(false, "no supported depth format");
+    return vk::Format::eUndefined;
+}
+
 } // namespace
 
 void vk_renderer::initialize() noexcept
 {
     VKE_ASSERT(dyn_loader_.success());
 
+    const auto init_begin = std::chrono::steady_clock::now();
+    jobs_ = &engine_->get_job_system();
+
     create_vk_instance();
-    create_surface();
+    if (!config_.headless) {
+        create_surface();
+    }
     cache_physical_devices();
-    create_graphics_pipeline();
 
     const vma::VulkanFunctions vk_funcs = vma::functionsFromDispatcher(VULKAN_HPP_DEFAULT_DISPATCHER);
     allocator_ = vk_check_result(vma::createAllocator(vma::AllocatorCreateInfo{
@@ -153,73 +186,257 @@ void vk_renderer::initialize() noexcept
       .vulkanApiVersion = available_vk_version_
     }));
 
-    create_framebuffers();
-    create_vertex_buffer();
-    create_command_pool();
-    create_sync_objects();
+    if (config_.headless) {
+        create_offscreen_targets();
+    }
+
+    upload_context_.initialize(device_, allocator_, transfer_queue_,
+      queue_family_indices_.transfer_index, queue_family_indices_.graphics_index);
+
+    pipeline_cache_.initialize(device_, physical_device_, config_.pipeline_cache_path);
+    pipeline_registry_.initialize(device_, pipeline_cache_.get(), *jobs_);
+
+    const auto pipeline_begin = std::chrono::steady_clock::now();
+    // object data is shared between the upload, culling and drawing queues
+    static_vector<u32, 3> culling_family_indices;
+    for (const u32 family_index : {queue_family_indices_.transfer_index, queue_family_indices_.compute_index, queue_family_indices_.graphics_index}) {
+        if (!ranges::contains(culling_family_indices, family_index)) {
+            culling_family_indices.push_back(family_index);
+        }
+    }
+    bindless_heap_.initialize(device_, physical_device_);
+    gpu_culling_.initialize(device_, allocator_, pipeline_cache_.get(), bindless_heap_,
+      std::span{culling_family_indices.data(), culling_family_indices.size()}, config_.frames_in_flight);
+    depth_fmt_ = find_depth_format(physical_device_);
+    create_graphics_pipeline();
+    const std::chrono::duration<f64, std::milli> pipeline_time = std::chrono::steady_clock::now() - pipeline_begin;
+
+    create_mesh_buffers();
+    create_frame_data();
+    create_gpu_profiler();
+
+    frame_capture_.initialize(allocator_, config_.frames_in_flight);
+    if (!config_.capture_directory.empty()) {
+        frame_capture_.set_continuous(config_.capture_directory);
+    }
+
+    last_frame_time_ = std::chrono::steady_clock::now();
+
+    const std::chrono::duration<f64, std::milli> init_time = last_frame_time_ - init_begin;
+    VKE_LOG(renderer, info, "renderer initialized in {:.3f}ms, pipelines created in {:.3f}ms ({} pipeline cache)",
+      init_time.count(), pipeline_time.count(), pipeline_cache_.was_loaded_from_disk() ? "warm" : "cold");
+}
+
+void vk_renderer::wait_for_frame() noexcept
+{
+    if (is_frame_ready_) {
+        return;
+    }
+
+    const auto wait_begin = std::chrono::steady_clock::now();
+    vk_check_result(device_.waitForFences({current_frame().in_flight_fence}, /*waitAll=*/true, /*timeout=*/std::numeric_limits<u64>::max()));
+    const std::chrono::duration<f64, std::milli> fence_wait = std::chrono::steady_clock::now() - wait_begin;
+
+    fence_wait_ms_ = fence_wait.count();
+    is_frame_ready_ = true;
 }
 
 void vk_renderer::render() noexcept
 {
-    vk_check_result(device_.waitForFences({in_flight_fence_}, /*waitAll=*/true, /*timeout=*/std::numeric_limits<u64>::max()));
-    vk_check_result(device_.resetFences({in_flight_fence_}));
+    vk_frame_data& frame = current_frame();
 
-    const u32 image_idx = vk_check_result(device_.acquireNextImageKHR(
-      swapchain_, /*timeout=*/std::numeric_limits<u64>::max(), image_available_semaphore_));
-    command_buffer_.reset();
-    record_command_buffer(image_idx);
+    wait_for_frame();
+    is_frame_ready_ = false;
 
-    const vk::PipelineStageFlags wait_stage{vk::PipelineStageFlagBits::eColorAttachmentOutput};
-    const vk::SubmitInfo submit_info{
-      .waitSemaphoreCount = 1,
-      .pWaitSemaphores = &image_available_semaphore_,
-      .pWaitDstStageMask = &wait_stage,
-      .commandBufferCount = 1,
-      .pCommandBuffers = &command_buffer_,
-      .signalSemaphoreCount = 1,
-      .pSignalSemaphores = &render_finished_semaphore_
+    // gpu is done with everything this frame submitted last time around
+    for (const auto& destruction : frame.deferred_destructions) {
+        destruction();
+    }
+    frame.deferred_destructions.clear();
+    // the graph holds on to frame memory until it is reset
+    frame.render_graph.reset();
+    frame.frame_arena.reset();
+    gpu_profiler_.begin_frame(current_frame_);
+    frame_capture_.resolve(current_frame_);
+
+    // every frame in flight renders into its own offscreen target when headless
+    u32 image_idx = current_frame_;
+    if (!config_.headless) {
+        const vk::ResultValue<u32> acquired = device_.acquireNextImageKHR(swapchain_,
+          /*timeout=*/std::numeric_limits<u64>::max(), frame.image_available_semaphore);
+        // nothing was acquired, the frame is skipped and its fence stays signaled
+        if (acquired.result == vk::Result::eErrorOutOfDateKHR) {
+            on_window_resize();
+            skip_frame();
+            return;
+        }
+
+        VKE_ASSERT_MSG(acquired.result == vk::Result::eSuccess || acquired.result == vk::Result::eSuboptimalKHR,
+          "result: {}", acquired.result);
+        image_idx = acquired.value;
+
+        if (!acquired_images_[image_idx]) {
+            acquired_images_[image_idx] = true;
+            if (--unacquired_image_count_ == 0 && !retired_swapchains_.empty()) {
+                release_retired_swapchains(frame);
+            }
+        }
+    }
+
+    // a previous frame may still be rendering into this image if there are more frames than images
+    if (vk::Fence& image_fence = image_in_flight_fences_[image_idx]; image_fence && image_fence != frame.in_flight_fence) {
+        vk_check_result(device_.waitForFences({image_fence}, /*waitAll=*/true, /*timeout=*/std::numeric_limits<u64>::max()));
+    }
+    image_in_flight_fences_[image_idx] = frame.in_flight_fence;
+
+    vk_check_result(device_.resetFences({frame.in_flight_fence}));
+
+    upload_context_.submit();
+    upload_context_.collect();
+    pipeline_registry_.update();
+
+    submit_culling(frame);
+    stream_instances(frame);
+
+    const auto record_begin = std::chrono::steady_clock::now();
+    vk_check_result(device_.resetCommandPool(frame.command_pool));
+    if (parallel_recorder_.slot_count() != 0) {
+        parallel_recorder_.reset(current_frame_);
+    }
+    record_command_buffer(frame.command_buffer, image_idx);
+    const std::chrono::duration<f64, std::milli> record_time = std::chrono::steady_clock::now() - record_begin;
+
+    static_vector<vk::SemaphoreSubmitInfo, 3> wait_infos{
+      vk::SemaphoreSubmitInfo{
+        .semaphore = frame.cull_finished_semaphore,
+        .stageMask = vk_gpu_culling::consumer_stages()
+      }
+    };
+
+    if (!config_.headless) {
+        wait_infos.push_back(vk::SemaphoreSubmitInfo{
+          .semaphore = frame.image_available_semaphore,
+          .stageMask = vk::PipelineStageFlagBits2::eColorAttachmentOutput
+        });
+    }
+
+    // uploads overlap rendering, only the stages that consume uploaded data wait for them
+    if (const vk::PipelineStageFlags2 upload_wait_stages = upload_context_.wait_stages()) {
+        wait_infos.push_back(vk::SemaphoreSubmitInfo{
+          .semaphore = upload_context_.timeline_semaphore(),
+          .value = upload_context_.last_submitted_value(),
+          .stageMask = upload_wait_stages
+        });
+    }
+
+    const vk::CommandBufferSubmitInfo cmd_submit_info{.commandBuffer = frame.command_buffer};
+    // there is nothing to present to when headless
+    const vk::Semaphore render_finished_semaphore = config_.headless ? nullptr : render_finished_semaphores_[image_idx];
+    const vk::SemaphoreSubmitInfo signal_info{
+      .semaphore = render_finished_semaphore,
+      .stageMask = vk::PipelineStageFlagBits2::eColorAttachmentOutput
+    };
+    const vk::SubmitInfo2 submit_info{
+      .waitSemaphoreInfoCount = wait_infos.size(),
+      .pWaitSemaphoreInfos = wait_infos.data(),
+      .commandBufferInfoCount = 1,
+      .pCommandBufferInfos = &cmd_submit_info,
+      .signalSemaphoreInfoCount = config_.headless ? 0u : 1u,
+      .pSignalSemaphoreInfos = &signal_info
     };
 
-    vk_check_result(graphics_queue_.submit({submit_info}, in_flight_fence_));
+    vk_check_result(graphics_queue_.submit2({submit_info}, frame.in_flight_fence));
+    // culling and drawing both waited for the uploads so far
+    upload_context_.reset_wait_stages();
+
+    if (config_.headless) {
+        current_frame_ = (current_frame_ + 1) % config_.frames_in_flight;
+        update_frame_stats(fence_wait_ms_, record_time.count());
+        return;
+    }
 
     const vk::PresentInfoKHR present_info{
       .waitSemaphoreCount = 1,
-      .pWaitSemaphores = &render_finished_semaphore_,
+      .pWaitSemaphores = &render_finished_semaphore,
       .swapchainCount = 1,
       .pSwapchains = &swapchain_,
       .pImageIndices = &image_idx
     };
 
+    current_frame_ = (current_frame_ + 1) % config_.frames_in_flight;
+    update_frame_stats(fence_wait_ms_, record_time.count());
+
     const vk::Result present_result = present_queue_.presentKHR(present_info);
     if (present_result == vk::Result::eSuboptimalKHR || present_result == vk::Result::eErrorOutOfDateKHR) {
         on_window_resize();
     }
 }
 
+void vk_renderer::skip_frame() noexcept
+{
+    // instances are queued again every tick, keeping them would draw them twice in the next frame
+    pending_instances_.clear();
+    pending_batch_sizes_.clear();
+}
+
+void vk_renderer::draw_instanced(const std::span<const mesh_instance> instances) noexcept
+{
+    // the frame that will draw these may still be in flight, they are streamed once its fence signals
+    if (instances.empty()) {
+        return;
+    }
+
+    pending_instances_.insert(pending_instances_.end(), instances.begin(), instances.end());
+    pending_batch_sizes_.push_back(static_cast<u32>(instances.size()));
+}
+
 void vk_renderer::on_window_resize() noexcept
 {
-    destroy_surface_objects();
+    // offscreen targets keep the configured extent
+    if (config_.headless) {
+        return;
+    }
+
+    const auto resize_begin = std::chrono::steady_clock::now();
 
     create_swap_chain();
-    create_framebuffers();
+
+    const std::chrono::duration<f64, std::milli> resize_time = std::chrono::steady_clock::now() - resize_begin;
+    VKE_LOG(renderer, verbose, "swapchain recreated in {:.3f}ms", resize_time.count());
+}
+
+void vk_renderer::set_present_mode(const vk::PresentModeKHR present_mode, const u32 image_count) noexcept
+{
+    config_.present_mode = present_mode;
+    config_.swapchain_image_count = image_count;
+    if (!config_.headless && device_) {
+        create_swap_chain();
+    }
 }
 
 vk_renderer::~vk_renderer()
 {
     if (device_) {
-        destroy_surface_objects();
+        if (config_.headless && frame_stats_.frame_count != 0) {
+            VKE_LOG(renderer, info, "headless run finished, {} frames, frame time avg: {:.3f}ms",
+              frame_stats_.frame_count, frame_stats_.total_frame_time_ms / static_cast<f64>(frame_stats_.frame_count));
+        }
 
-        allocator_.destroyBuffer(mesh_buffer_, mesh_buffer_allocation_);
+        destroy_surface_objects();
+        destroy_frame_data();
+
+        upload_context_.destroy();
+        gpu_culling_.destroy();
+        bindless_heap_.destroy();
+        gpu_profiler_.destroy();
+        frame_capture_.destroy();
+        destroy_buffer(allocator_, mesh_vertex_buffer_);
+        destroy_buffer(allocator_, mesh_index_buffer_);
         allocator_.destroy();
 
         device_.destroy(swapchain_);
-        device_.destroy(pipeline_layout_);
-        device_.destroy(pipeline_);
-        device_.destroy(render_pass_);
-        device_.destroy(command_pool_);
-        device_.destroy(image_available_semaphore_);
-        device_.destroy(render_finished_semaphore_);
-        device_.destroy(in_flight_fence_);
+        pipeline_registry_.destroy();
+        pipeline_cache_.destroy();
         device_.destroy();
     }
 
@@ -255,7 +472,7 @@ void vk_renderer::create_vk_instance() noexcept
       .apiVersion = available_vk_version_
     };
 
-    static_vector<const char*, 8> instance_layers;
+    small_vector<const char*, 8> instance_layers;
 
 #if DEBUG
     {
@@ -270,12 +487,16 @@ void vk_renderer::create_vk_instance() noexcept
     };
 #endif // DEBUG
 
-    static_vector<const char*, 8> instance_extensions;
+    // sdl decides how many extensions a window needs, usually few but there is no upper bound
+    small_vector<const char*, 8> instance_extensions;
     {
-        u32 n_sdl_extensions = 0;
-        SDL_Vulkan_GetInstanceExtensions(engine_->get_window(), &n_sdl_extensions, nullptr);
-        instance_extensions.resize(n_sdl_extensions);
-        SDL_Vulkan_GetInstanceExtensions(engine_->get_window(), &n_sdl_extensions, instance_extensions.data());
+        // there is no window to present to when headless
+        if (!config_.headless) {
+            u32 n_sdl_extensions = 0;
+            SDL_Vulkan_GetInstanceExtensions(engine_->get_window(), &n_sdl_extensions, nullptr);
+            instance_extensions.resize(n_sdl_extensions);
+            SDL_Vulkan_GetInstanceExtensions(engine_->get_window(), &n_sdl_extensions, instance_extensions.data());
+        }
 #if DEBUG
         instance_extensions.push_back("VK_EXT_debug_utils");
 #endif // DEBUG
@@ -352,7 +573,9 @@ void vk_renderer::switch_physical_device_to(const vk::PhysicalDevice dev) noexce
     populate_queue_family_indices();
     create_logical_device();
     cache_queues();
-    create_swap_chain();
+    if (!config_.headless) {
+        create_swap_chain();
+    }
 }
 
 void vk_renderer::populate_queue_family_indices() noexcept
@@ -363,9 +586,9 @@ void vk_renderer::populate_queue_family_indices() noexcept
           props.queueFlags & vk::QueueFlagBits::eGraphics) {
             queue_family_indices_.graphics_index = idx;
 
-            // prefer the same queue for presentation as graphics
+            // prefer the same queue for presentation as graphics, nothing is presented when headless
             if (queue_family_indices_.present_index == vk_queue_family_indices::invalid_index &&
-              vk_check_result(physical_device_.getSurfaceSupportKHR(idx, surface_))) {
+              (config_.headless || vk_check_result(physical_device_.getSurfaceSupportKHR(idx, surface_)))) {
                 queue_family_indices_.present_index = idx;
             }
         }
@@ -438,14 +661,49 @@ void vk_renderer::create_logical_device() noexcept
     const std::vector<vk::ExtensionProperties> device_extension_properties = vk_check_result(physical_device_.enumerateDeviceExtensionProperties());
     VKE_LOG(renderer, verbose, "device extension properties:\n\t{}", fmt::join(device_extension_properties, "\n\t"));
 
-    const static_vector<const char*, 4> device_extensions{
-      VK_KHR_SWAPCHAIN_EXTENSION_NAME
-    };
+    static_vector<const char*, 4> device_extensions;
+    if (!config_.headless) {
+        device_extensions.push_back(VK_KHR_SWAPCHAIN_EXTENSION_NAME);
+    }
 
     validate_required_extensions(device_extensions, device_extension_properties);
 
-    const vk::PhysicalDeviceFeatures physical_device_features;
+    vk::PhysicalDeviceVulkan12Features vk12_features{};
+    vk12_features.timelineSemaphore = true;
+    vk12_features.drawIndirectCount = true;
+    // bindless heap
+    vk12_features.runtimeDescriptorArray = true;
+    vk12_features.descriptorBindingPartiallyBound = true;
+    vk12_features.descriptorBindingUpdateUnusedWhilePending = true;
+    vk12_features.descriptorBindingStorageBufferUpdateAfterBind = true;
+    vk12_features.descriptorBindingSampledImageUpdateAfterBind = true;
+    vk12_features.shaderSampledImageArrayNonUniformIndexing = true;
+    vk12_features.hostQueryReset = true;
+
+    vk::PhysicalDeviceVulkan13Features vk13_features{};
+    vk13_features.pNext = &vk12_features;
+    vk13_features.synchronization2 = true;
+    vk13_features.dynamicRendering = true;
+
+    // statistics queries stay active while secondaries execute, which needs inherited queries as well
+    const vk::PhysicalDeviceFeatures supported_features = physical_device_.getFeatures();
+    supports_pipeline_statistics_ = supported_features.pipelineStatisticsQuery && supported_features.inheritedQueries;
+
+    // the bindless heap indexes its arrays with push constants, which are dynamically uniform
+    VKE_ASSERT_MSG(supported_features.shaderStorageBufferArrayDynamicIndexing && supported_features.shaderSampledImageArrayDynamicIndexing,
+      "bindless heap needs dynamic indexing of storage buffer and sampled image arrays");
+
+    // culled draw commands carry the object index in firstInstance
+    VKE_ASSERT_MSG(supported_features.drawIndirectFirstInstance, "gpu culling needs non-zero firstInstance in indirect draws");
+
+    vk::PhysicalDeviceFeatures physical_device_features{};
+    physical_device_features.pipelineStatisticsQuery = supports_pipeline_statistics_;
+    physical_device_features.inheritedQueries = supports_pipeline_statistics_;
+    physical_device_features.shaderStorageBufferArrayDynamicIndexing = true;
+    physical_device_features.shaderSampledImageArrayDynamicIndexing = true;
+    physical_device_features.drawIndirectFirstInstance = true;
     const vk::DeviceCreateInfo create_info{
+      .pNext = &vk13_features,
       .queueCreateInfoCount = create_infos.size(),
       .pQueueCreateInfos = create_infos.data(),
       .enabledExtensionCount = device_extensions.size(),
@@ -483,17 +741,23 @@ void vk_renderer::create_swap_chain() noexcept
     }();
     VKE_LOG(renderer, verbose, "swap chain surface format: {} color space: {}", surface_fmt.format, surface_fmt.colorSpace);
 
-    const vk::PresentModeKHR present_mode = [&]() {
-        for (const auto& availablePresentMode : surface_capabilities_.present_modes) {
-            if (availablePresentMode == vk::PresentModeKHR::eMailbox) {
-                return availablePresentMode;
-            }
-        }
+    present_mode_ = config_.present_mode;
+    if (!ranges::contains(surface_capabilities_.present_modes, present_mode_)) {
+        VKE_LOG(renderer, warning, "present mode {} is not supported, falling back to fifo", present_mode_);
+        present_mode_ = vk::PresentModeKHR::eFifo;
+    }
 
-        return vk::PresentModeKHR::eFifo;
-    }();
-    VKE_LOG(renderer, verbose, "swap chain present mode: {}", present_mode);
+    const vk::SurfaceCapabilitiesKHR& capabilities = surface_capabilities_.capabilities;
+    u32 image_count = config_.swapchain_image_count != 0 ? config_.swapchain_image_count : capabilities.minImageCount + 1;
+    image_count = std::max(image_count, capabilities.minImageCount);
+    if (capabilities.maxImageCount != 0) {
+        image_count = std::min(image_count, capabilities.maxImageCount);
+    }
+    VKE_LOG(renderer, verbose, "swap chain present mode: {}, image count: {}", present_mode_, image_count);
 
+    // pipelines are built for the format of the first swapchain
+    VKE_ASSERT_MSG(!swapchain_ || surface_fmt.format == surface_fmt_,
+      "surface format changed from {} to {}", surface_fmt_, surface_fmt.format);
     surface_fmt_ = surface_fmt.format;
     extent_ = [&]() {
         if (surface_capabilities_.capabilities.currentExtent.width != std::numeric_limits<u32>::max()) {
@@ -513,29 +777,54 @@ void vk_renderer::create_swap_chain() noexcept
         }
     }();
 
+    // frames are copied out of the swapchain for captures
+    vk::ImageUsageFlags image_usage = vk::ImageUsageFlagBits::eColorAttachment;
+    supports_capture_ = static_cast<bool>(surface_capabilities_.capabilities.supportedUsageFlags & vk::ImageUsageFlagBits::eTransferSrc);
+    if (supports_capture_) {
+        image_usage |= vk::ImageUsageFlagBits::eTransferSrc;
+    }
+
     const vk::SwapchainCreateInfoKHR swapchain_create_info{
       .surface = surface_,
-      .minImageCount = surface_capabilities_.capabilities.minImageCount + 1,
+      .minImageCount = image_count,
       .imageFormat = surface_fmt_,
       .imageColorSpace = surface_fmt.colorSpace,
       .imageExtent = extent_,
       .imageArrayLayers = 1,
-      .imageUsage = vk::ImageUsageFlagBits::eColorAttachment,
+      .imageUsage = image_usage,
       .imageSharingMode = vk::SharingMode::eExclusive,
       .queueFamilyIndexCount = 0,
       .pQueueFamilyIndices = nullptr,
       .preTransform = surface_capabilities_.capabilities.currentTransform,
       .compositeAlpha = vk::CompositeAlphaFlagBitsKHR::eOpaque,
-      .presentMode = present_mode,
+      .presentMode = present_mode_,
       .clipped = true,
       .oldSwapchain = swapchain_
     };
 
     swapchain_ = vk_check_result(device_.createSwapchainKHR(swapchain_create_info));
     swapchain_images_ = vk_check_result(device_.getSwapchainImagesKHR(swapchain_));
-
-    if (swapchain_create_info.oldSwapchain) {
-        device_.destroy(swapchain_create_info.oldSwapchain);
+    image_in_flight_fences_.assign(swapchain_images_.size(), nullptr);
+
+    // frames in flight may still render into or present the old images and the fences of the frames
+    // do not cover the presents, the old swapchain is retired instead of waiting for the device to go idle
+    if (const vk::SwapchainKHR old_swapchain = swapchain_create_info.oldSwapchain) {
+        retired_swapchains_.push_back(vk_retired_swapchain{
+          .swapchain = old_swapchain,
+          .image_views = std::move(swapchain_image_views_),
+          .render_finished_semaphores = std::move(render_finished_semaphores_)
+        });
+        swapchain_image_views_.clear();
+        render_finished_semaphores_.clear();
+    }
+    acquired_images_.assign(swapchain_images_.size(), false);
+    unacquired_image_count_ = swapchain_images_.size();
+
+    // present holds on to its wait semaphore until the image is acquired again, which may be long
+    // after the frame slot that signaled it comes around, so there is one semaphore per image
+    render_finished_semaphores_.reserve(swapchain_images_.size());
+    for (usize i = 0; i < swapchain_images_.size(); ++i) {
+        render_finished_semaphores_.push_back(vk_check_result(device_.createSemaphore({})));
     }
 
     swapchain_image_views_.reserve(swapchain_images_.size());
@@ -565,291 +854,412 @@ void vk_renderer::create_swap_chain() noexcept
     VKE_LOG(renderer, verbose, "swapchain initialized");
 }
 
-void vk_renderer::create_graphics_pipeline() noexcept
+void vk_renderer::create_offscreen_targets() noexcept
 {
-    const std::vector<u8> vert = fs::read_bytes_from_file("engine/shaders/triangle.vert.spr");
-    const std::vector<u8> frag = fs::read_bytes_from_file("engine/shaders/triangle.frag.spr");
+    // srgb so that the pipeline and the captured pixels match what a typical surface format produces
+    surface_fmt_ = vk::Format::eR8G8B8A8Srgb;
+    extent_ = config_.headless_extent;
+    supports_capture_ = true;
+
+    for (u32 i = 0; i < config_.frames_in_flight; ++i) {
+        auto [image, allocation] = vk_check_result(allocator_.createImage(
+          vk::ImageCreateInfo{
+            .imageType = vk::ImageType::e2D,
+            .format = surface_fmt_,
+            .extent = vk::Extent3D{.width = extent_.width, .height = extent_.height, .depth = 1},
+            .mipLevels = 1,
+            .arrayLayers = 1,
+            .samples = vk::SampleCountFlagBits::e1,
+            .tiling = vk::ImageTiling::eOptimal,
+            .usage = vk::ImageUsageFlagBits::eColorAttachment | vk::ImageUsageFlagBits::eTransferSrc,
+            .sharingMode = vk::SharingMode::eExclusive,
+            .initialLayout = vk::ImageLayout::eUndefined
+          },
+          vma::AllocationCreateInfo{
+            .usage = vma::MemoryUsage::eAutoPreferDevice
+          }));
+
+        const vk::ImageView view = vk_check_result(device_.createImageView(
+          vk::ImageViewCreateInfo{
+            .image = image,
+            .viewType = vk::ImageViewType::e2D,
+            .format = surface_fmt_,
+            .subresourceRange = vk::ImageSubresourceRange{
+              .aspectMask = vk::ImageAspectFlagBits::eColor,
+              .baseMipLevel = 0,
+              .levelCount = 1,
+              .baseArrayLayer = 0,
+              .layerCount = 1
+            }
+          }));
 
-    const vk::ShaderModule vert_module = create_shader_module(vert);
-    const vk::ShaderModule frag_module = create_shader_module(frag);
+        swapchain_images_.push_back(image);
+        swapchain_image_views_.push_back(view);
+        offscreen_allocations_.push_back(allocation);
+    }
 
-    const static_vector<vk::PipelineShaderStageCreateInfo, 2> shader_stage_create_infos{
-      vk::PipelineShaderStageCreateInfo{
-        .stage = vk::ShaderStageFlagBits::eVertex,
-        .module = vert_module,
-        .pName = "main"
-      },
-      vk::PipelineShaderStageCreateInfo{
-        .stage = vk::ShaderStageFlagBits::eFragment,
-        .module = frag_module,
-        .pName = "main"
-      }
-    };
+    image_in_flight_fences_.assign(swapchain_images_.size(), nullptr);
 
-    const static_vector<vk::DynamicState, 2> dynamic_states{
-      vk::DynamicState::eViewport,
-      vk::DynamicState::eScissor
-    };
+    VKE_LOG(renderer, verbose, "offscreen targets initialized, extent: {}x{}", extent_.width, extent_.height);
+}
 
-    const vk::PipelineDynamicStateCreateInfo dynamic_state_create_info{
-      .dynamicStateCount = dynamic_states.size(),
-      .pDynamicStates = dynamic_states.data()
+void vk_renderer::create_graphics_pipeline() noexcept
+{
+    vk_graphics_pipeline_desc desc{
+      .vertex_shader_path = "engine/shaders/triangle.vert.spr",
+      .fragment_shader_path = "engine/shaders/triangle.frag.spr",
+      .layout = bindless_heap_.pipeline_layout()
     };
+    desc.color_formats.push_back(surface_fmt_);
+    desc.depth_format = depth_fmt_;
+    desc.depth_test_enable = true;
+    desc.depth_write_enable = true;
 
-    const vk::VertexInputBindingDescription binding_description{
+    desc.vertex_layout.bindings.push_back(vk::VertexInputBindingDescription{
       .binding = 0,
       .stride = sizeof(vertex),
       .inputRate = vk::VertexInputRate::eVertex
-    };
-
-    const static_vector<vk::VertexInputAttributeDescription, 2> attr_descriptions{
-      vk::VertexInputAttributeDescription{
-        .location = 0,
-        .binding = 0,
-        .format = vk::Format::eR32G32B32Sfloat,
-        .offset = static_cast<u32>(offsetof(vertex, position))
-      },
-      vk::VertexInputAttributeDescription{
-        .location = 1,
-        .binding = 0,
-        .format = vk::Format::eR32G32B32Sfloat,
-        .offset = static_cast<u32>(offsetof(vertex, color))
-      }
-    };
-
-    const vk::PipelineVertexInputStateCreateInfo vertex_input_state_create_info{
-      .vertexBindingDescriptionCount = 1,
-      .pVertexBindingDescriptions = &binding_description,
-      .vertexAttributeDescriptionCount = attr_descriptions.size(),
-      .pVertexAttributeDescriptions = attr_descriptions.data()
-    };
-
-    const vk::PipelineInputAssemblyStateCreateInfo input_assembly_state_create_info{
-      .topology = vk::PrimitiveTopology::eTriangleList,
-      .primitiveRestartEnable = false
-    };
-
-    const vk::PipelineViewportStateCreateInfo viewport_state_create_info{
-      .viewportCount = 1,
-      .scissorCount = 1
-    };
+    });
+    desc.vertex_layout.attributes.push_back(vk::VertexInputAttributeDescription{
+      .location = 0,
+      .binding = 0,
+      .format = vk::Format::eR32G32B32Sfloat,
+      .offset = static_cast<u32>(offsetof(vertex, position))
+    });
+    desc.vertex_layout.attributes.push_back(vk::VertexInputAttributeDescription{
+      .location = 1,
+      .binding = 0,
+      .format = vk::Format::eR32G32B32Sfloat,
+      .offset = static_cast<u32>(offsetof(vertex, color))
+    });
+
+    // everything else can compile in the background and draw with this until it is ready
+    triangle_pipeline_ = pipeline_registry_.request(desc, vk_pipeline_compile_mode::sync);
+    pipeline_registry_.set_fallback(triangle_pipeline_);
+
+    // same mesh layout with a second stream that advances once per instance
+    desc.vertex_shader_path = "engine/shaders/triangle_instanced.vert.spr";
+    desc.vertex_layout.bindings.push_back(vk::VertexInputBindingDescription{
+      .binding = 1,
+      .stride = sizeof(mesh_instance),
+      .inputRate = vk::VertexInputRate::eInstance
+    });
+    desc.vertex_layout.attributes.push_back(vk::VertexInputAttributeDescription{
+      .location = 2,
+      .binding = 1,
+      .format = vk::Format::eR32G32B32A32Sfloat,
+      .offset = static_cast<u32>(offsetof(mesh_instance, translation)) // translation and scale
+    });
+    desc.vertex_layout.attributes.push_back(vk::VertexInputAttributeDescription{
+      .location = 3,
+      .binding = 1,
+      .format = vk::Format::eR32G32B32Sfloat,
+      .offset = static_cast<u32>(offsetof(mesh_instance, color))
+    });
+    instanced_pipeline_ = pipeline_registry_.request(desc);
+
+    VKE_LOG(renderer, verbose, "graphics pipelines created");
+}
 
-    const vk::PipelineRasterizationStateCreateInfo rasterization_state_create_info{
-      .depthClampEnable = false,
-      .rasterizerDiscardEnable = false,
-      .polygonMode = vk::PolygonMode::eFill,
-      .cullMode = vk::CullModeFlagBits::eBack,
-      .frontFace = vk::FrontFace::eClockwise,
-      .depthBiasClamp = false,
-      .lineWidth = 1.f
-    };
+void vk_renderer::create_mesh_buffers() noexcept
+{
+    const mesh_buffer<vertex>& vert_buf = triangle_mesh_.get_vertex_buffer();
+    mesh_vertex_buffer_ = create_device_local_buffer(allocator_, vert_buf.size_in_bytes(),
+      vk::BufferUsageFlagBits::eVertexBuffer | vk::BufferUsageFlagBits::eTransferDst);
 
-    const vk::PipelineMultisampleStateCreateInfo multisample_state_create_info{
-      .rasterizationSamples = vk::SampleCountFlagBits::e1,
-      .sampleShadingEnable = false // msaa disabled
-    };
+    upload_context_.upload(mesh_vertex_buffer_, /*dst_offset=*/0, std::span{vert_buf.buf},
+      vk::PipelineStageFlagBits2::eVertexAttributeInput, vk::AccessFlagBits2::eVertexAttributeRead);
 
-    const vk::PipelineColorBlendAttachmentState color_blend_attachment_state{
-      .blendEnable = false,
-      .srcColorBlendFactor = vk::BlendFactor::eOne,
-      .dstColorBlendFactor = vk::BlendFactor::eZero,
-      .colorBlendOp = vk::BlendOp::eAdd,
-      .srcAlphaBlendFactor = vk::BlendFactor::eOne,
-      .dstAlphaBlendFactor = vk::BlendFactor::eZero,
-      .alphaBlendOp = vk::BlendOp::eAdd,
-      .colorWriteMask = vk::ColorComponentFlagBits::eR | vk::ColorComponentFlagBits::eG
-        | vk::ColorComponentFlagBits::eB | vk::ColorComponentFlagBits::eA
-    };
+    // unindexed meshes are drawn with draw and drawIndirectCount instead
+    if (triangle_mesh_.has_indices()) {
+        const std::span<const std::byte> index_bytes = visit_nt(triangle_mesh_.get_index_buffer(),
+          [](const auto& index_buf) { return std::as_bytes(std::span{index_buf.buf}); });
 
-    const vk::PipelineColorBlendStateCreateInfo color_blend_state_create_info{
-      .logicOpEnable = false,
-      .logicOp = vk::LogicOp::eCopy,
-      .attachmentCount = 1,
-      .pAttachments = &color_blend_attachment_state,
-      .blendConstants = {{0.f, 0.f, 0.f, 0.f}}
-    };
+        mesh_index_buffer_ = create_device_local_buffer(allocator_, index_bytes.size(),
+          vk::BufferUsageFlagBits::eIndexBuffer | vk::BufferUsageFlagBits::eTransferDst);
+        upload_context_.upload(mesh_index_buffer_, /*dst_offset=*/0, index_bytes,
+          vk::PipelineStageFlagBits2::eIndexInput, vk::AccessFlagBits2::eIndexRead);
+    }
 
-    const vk::PipelineLayoutCreateInfo pipeline_layout_create_info{};
-    pipeline_layout_ = vk_check_result(device_.createPipelineLayout(pipeline_layout_create_info));
-
-    create_render_pass();
-
-    const vk::GraphicsPipelineCreateInfo pipeline_create_info{
-      .stageCount = shader_stage_create_infos.size(),
-      .pStages = shader_stage_create_infos.data(),
-      .pVertexInputState = &vertex_input_state_create_info,
-      .pInputAssemblyState = &input_assembly_state_create_info,
-      .pViewportState = &viewport_state_create_info,
-      .pRasterizationState = &rasterization_state_create_info,
-      .pMultisampleState = &multisample_state_create_info,
-      .pDepthStencilState = nullptr,
-      .pColorBlendState = &color_blend_state_create_info,
-      .pDynamicState = &dynamic_state_create_info,
-      .layout = pipeline_layout_,
-      .renderPass = render_pass_,
-      .subpass = 0
-    };
+    // grid of triangles which overshoots the screen so that culling has something to reject
+    constexpr i32 grid_extent = 24;
+    constexpr f32 grid_spacing = 0.1f;
+    constexpr f32 object_scale = 0.08f;
 
-    pipeline_ = vk_check_result(device_.createGraphicsPipeline(nullptr, pipeline_create_info));
+    sphere mesh_bounds;
+    for (const vertex& v : vert_buf.buf) {
+        mesh_bounds.radius = std::max(mesh_bounds.radius, v.position.length());
+    }
 
-    device_.destroy(vert_module);
-    device_.destroy(frag_module);
+    std::vector<vk_gpu_object> objects;
+    for (i32 y = -grid_extent / 2; y < grid_extent / 2; ++y) {
+        for (i32 x = -grid_extent / 2; x < grid_extent / 2; ++x) {
+            const vec3f translation{static_cast<f32>(x) * grid_spacing, static_cast<f32>(y) * grid_spacing, 0.f};
+            objects.push_back(vk_gpu_object{
+              .translation = translation,
+              .scale = object_scale,
+              .bounds = sphere{.center = translation, .radius = mesh_bounds.radius * object_scale}
+            });
+        }
+    }
+    gpu_culling_.set_objects(upload_context_, objects);
 
-    VKE_LOG(renderer, verbose, "graphics pipeline created");
+    upload_context_.submit();
+    VKE_LOG(renderer, verbose, "mesh buffers created, {} objects", objects.size());
 }
 
-void vk_renderer::create_render_pass() noexcept
+void vk_renderer::create_frame_data() noexcept
 {
-    const vk::AttachmentDescription color_attachment_desc{
-      .format = surface_fmt_,
-      .samples = vk::SampleCountFlagBits::e1,
-      .loadOp = vk::AttachmentLoadOp::eClear,
-      .storeOp = vk::AttachmentStoreOp::eStore,
-      .stencilLoadOp = vk::AttachmentLoadOp::eDontCare,
-      .stencilStoreOp = vk::AttachmentStoreOp::eDontCare,
-      .initialLayout = vk::ImageLayout::eUndefined,
-      .finalLayout = vk::ImageLayout::ePresentSrcKHR
-    };
-
-    const vk::AttachmentReference color_attachment_ref{
-      .attachment = 0,
-      .layout = vk::ImageLayout::eColorAttachmentOptimal
-    };
+    frames_.resize(config_.frames_in_flight);
+    for (vk_frame_data& frame : frames_) {
+        // pools are reset as a whole each frame instead of resetting individual buffers
+        frame.command_pool = vk_check_result(device_.createCommandPool(vk::CommandPoolCreateInfo{
+          .flags = vk::CommandPoolCreateFlagBits::eTransient,
+          .queueFamilyIndex = queue_family_indices_.graphics_index
+        }));
+
+        frame.command_buffer = vk_check_result(device_.allocateCommandBuffers(vk::CommandBufferAllocateInfo{
+          .commandPool = frame.command_pool,
+          .level = vk::CommandBufferLevel::ePrimary,
+          .commandBufferCount = 1
+        })).front();
+
+        frame.image_available_semaphore = vk_check_result(device_.createSemaphore({}));
+        frame.in_flight_fence = vk_check_result(device_.createFence(vk::FenceCreateInfo{.flags = vk::FenceCreateFlagBits::eSignaled}));
+
+        frame.compute_command_pool = vk_check_result(device_.createCommandPool(vk::CommandPoolCreateInfo{
+          .flags = vk::CommandPoolCreateFlagBits::eTransient,
+          .queueFamilyIndex = queue_family_indices_.compute_index
+        }));
+
+        frame.compute_command_buffer = vk_check_result(device_.allocateCommandBuffers(vk::CommandBufferAllocateInfo{
+          .commandPool = frame.compute_command_pool,
+          .level = vk::CommandBufferLevel::ePrimary,
+          .commandBufferCount = 1
+        })).front();
+
+        frame.cull_finished_semaphore = vk_check_result(device_.createSemaphore({}));
+
+        void* instance_data = nullptr;
+        frame.instance_buffer = create_host_visible_buffer(allocator_, sizeof(mesh_instance) * config_.max_instances_per_frame,
+          vk::BufferUsageFlagBits::eVertexBuffer, instance_data);
+        frame.instance_data = static_cast<mesh_instance*>(instance_data);
+
+        frame.render_graph.initialize(device_, allocator_, &frame.frame_arena);
+    }
 
-    const vk::SubpassDescription subpass_description{
-      .pipelineBindPoint = vk::PipelineBindPoint::eGraphics,
-      .colorAttachmentCount = 1,
-      .pColorAttachments = &color_attachment_ref,
-    };
+    if (config_.recording_threads > 1) {
+        parallel_recorder_.initialize(device_, queue_family_indices_.graphics_index, config_.frames_in_flight, config_.recording_threads);
+    }
 
-    const vk::SubpassDependency dependency{
-      .srcSubpass = VK_SUBPASS_EXTERNAL,
-      .dstSubpass = 0,
-      .srcStageMask = vk::PipelineStageFlagBits::eColorAttachmentOutput,
-      .dstStageMask = vk::PipelineStageFlagBits::eColorAttachmentOutput,
-      .srcAccessMask = vk::AccessFlagBits::eNone,
-      .dstAccessMask = vk::AccessFlagBits::eColorAttachmentWrite,
-    };
+    VKE_LOG(renderer, verbose, "frame data created, frames in flight: {}", config_.frames_in_flight);
+}
 
-    const vk::RenderPassCreateInfo render_pass_create_info{
-      .attachmentCount = 1,
-      .pAttachments = &color_attachment_desc,
-      .subpassCount = 1,
-      .pSubpasses = &subpass_description,
-      .dependencyCount = 1,
-      .pDependencies = &dependency
-    };
+void vk_renderer::create_gpu_profiler() noexcept
+{
+    if (!config_.gpu_profiling) {
+        return;
+    }
 
-    render_pass_ = vk_check_result(device_.createRenderPass(render_pass_create_info));
-    VKE_LOG(renderer, verbose, "render pass created");
+    // scopes are recorded on the graphics and the compute queue
+    const std::vector<vk::QueueFamilyProperties> q_family_props = physical_device_.getQueueFamilyProperties();
+    const u32 timestamp_valid_bits = std::min(
+      q_family_props[queue_family_indices_.graphics_index].timestampValidBits,
+      q_family_props[queue_family_indices_.compute_index].timestampValidBits);
+
+    gpu_profiler_.initialize(device_, physical_device_, timestamp_valid_bits, config_.frames_in_flight, vk_gpu_profiler_config{
+      .debug_labels = DEBUG != 0,
+      .pipeline_statistics = config_.gpu_pipeline_statistics && supports_pipeline_statistics_
+    });
 }
 
-void vk_renderer::create_framebuffers() noexcept
+void vk_renderer::destroy_frame_data() noexcept
 {
-    swapchain_framebuffers_.reserve(swapchain_image_views_.size());
-    for (const vk::ImageView img_view : swapchain_image_views_) {
-        const vk::FramebufferCreateInfo framebuffer_create_info{
-          .renderPass = render_pass_,
-          .attachmentCount = 1,
-          .pAttachments = &img_view,
-          .width = extent_.width,
-          .height = extent_.height,
-          .layers = 1
-        };
+    for (vk_frame_data& frame : frames_) {
+        for (const auto& destruction : frame.deferred_destructions) {
+            destruction();
+        }
 
-        const vk::Framebuffer framebuffer = vk_check_result(device_.createFramebuffer(framebuffer_create_info));
-        swapchain_framebuffers_.emplace_back(framebuffer);
+        device_.destroy(frame.command_pool);
+        device_.destroy(frame.image_available_semaphore);
+        device_.destroy(frame.in_flight_fence);
+        device_.destroy(frame.compute_command_pool);
+        device_.destroy(frame.cull_finished_semaphore);
+        destroy_buffer(allocator_, frame.instance_buffer);
+        frame.render_graph.destroy();
     }
-    VKE_LOG(renderer, verbose, "framebuffers created");
+    frames_.clear();
+    parallel_recorder_.destroy();
 }
 
-void vk_renderer::create_vertex_buffer() noexcept
+void vk_renderer::destroy_surface_objects() noexcept
 {
-    const mesh_buffer<vertex>& vert_buf = triangle_mesh_.get_vertex_buffer();
-    const vk::BufferCreateInfo buffer_create_info{
-      .size = vk::DeviceSize{vert_buf.size_in_bytes()},
-      .usage = vk::BufferUsageFlagBits::eVertexBuffer | vk::BufferUsageFlagBits::eTransferDst,
-      .sharingMode = vk::SharingMode::eExclusive,
-    };
-
-    const vma::AllocationCreateInfo alloc_create_info{
-      .flags = vma::AllocationCreateFlagBits::eMapped | vma::AllocationCreateFlagBits::eHostAccessRandom,
-      .usage = vma::MemoryUsage::eAuto,
-      .preferredFlags = vk::MemoryPropertyFlagBits::eHostCoherent
-    };
-
-    vma::AllocationInfo alloc_info;
-    std::tie(mesh_buffer_, mesh_buffer_allocation_) =
-      vk_check_result(allocator_.createBuffer(buffer_create_info, alloc_create_info, alloc_info));
+    vk_check_result(device_.waitIdle());
 
-    std::memcpy(alloc_info.pMappedData, vert_buf.data(), vert_buf.size_in_bytes());
-    allocator_.flushAllocation(mesh_buffer_allocation_, alloc_info.offset, alloc_info.size);
-}
+    for (vk::ImageView view : swapchain_image_views_) {
+        device_.destroy(view);
+    }
 
-void vk_renderer::create_command_pool() noexcept
-{
-    const vk::CommandPoolCreateInfo command_pool_create_info{
-      .flags = vk::CommandPoolCreateFlagBits::eResetCommandBuffer,
-      .queueFamilyIndex = static_cast<u32>(queue_family_indices_.graphics_index)
-    };
+    for (vk::Semaphore semaphore : render_finished_semaphores_) {
+        device_.destroy(semaphore);
+    }
 
-    command_pool_ = vk_check_result(device_.createCommandPool(command_pool_create_info));
+    for (usize i = 0; i < offscreen_allocations_.size(); ++i) {
+        allocator_.destroyImage(swapchain_images_[i], offscreen_allocations_[i]);
+    }
 
-    const vk::CommandBufferAllocateInfo command_buffer_allocate_info{
-      .commandPool = command_pool_,
-      .level = vk::CommandBufferLevel::ePrimary,
-      .commandBufferCount = 1
-    };
+    for (const vk_retired_swapchain& retired : retired_swapchains_) {
+        for (const vk::ImageView view : retired.image_views) {
+            device_.destroy(view);
+        }
+        for (const vk::Semaphore semaphore : retired.render_finished_semaphores) {
+            device_.destroy(semaphore);
+        }
+        device_.destroy(retired.swapchain);
+    }
 
-    command_buffer_ = vk_check_result(device_.allocateCommandBuffers(command_buffer_allocate_info)).front();
-    VKE_LOG(renderer, verbose, "cmd buffer allocated");
+    offscreen_allocations_.clear();
+    retired_swapchains_.clear();
+    swapchain_images_.clear();
+    swapchain_image_views_.clear();
+    render_finished_semaphores_.clear();
+    image_in_flight_fences_.clear();
 }
 
-void vk_renderer::create_sync_objects() noexcept
+void vk_renderer::release_retired_swapchains(vk_frame_data& frame) noexcept
 {
-    image_available_semaphore_ = vk_check_result(device_.createSemaphore({}));
-    render_finished_semaphore_ = vk_check_result(device_.createSemaphore({}));
-    in_flight_fence_ = vk_check_result(device_.createFence(vk::FenceCreateInfo{.flags = vk::FenceCreateFlagBits::eSignaled}));
+    // presents of the old images completed once all new images were acquired, this frame's fence
+    // additionally covers every submit that rendered into them
+    frame.deferred_destructions.emplace_back([device = device_, retired_swapchains = std::move(retired_swapchains_)]() {
+        for (const vk_retired_swapchain& retired : retired_swapchains) {
+            for (const vk::ImageView view : retired.image_views) {
+                device.destroy(view);
+            }
+            for (const vk::Semaphore semaphore : retired.render_finished_semaphores) {
+                device.destroy(semaphore);
+            }
+            device.destroy(retired.swapchain);
+        }
+    });
+    retired_swapchains_.clear();
 }
 
-void vk_renderer::destroy_surface_objects() noexcept
+void vk_renderer::record_command_buffer(const vk::CommandBuffer cmd, const u32 img_index) noexcept
 {
-    vk_check_result(device_.waitIdle());
+    vk::CommandBufferBeginInfo cmd_buffer_begin_info{};
+    vk_check_result(cmd.begin(cmd_buffer_begin_info));
 
-    for (vk::ImageView view : swapchain_image_views_) {
-        device_.destroy(view);
+    upload_context_.record_acquire_barriers(cmd);
+
+    vk_render_graph& graph = current_frame().render_graph;
+
+    // previous contents are cleared anyway, the acquire semaphore is waited on at color output.
+    // offscreen targets have no present engine to hand them to, they are left as a copy source
+    const vk_rg_resource backbuffer = graph.import_image("backbuffer", swapchain_images_[img_index], swapchain_image_views_[img_index],
+      vk_rg_image_desc{.format = surface_fmt_, .extent = extent_},
+      vk_rg_usage{.stages = vk::PipelineStageFlagBits2::eColorAttachmentOutput},
+      config_.headless ? vk_rg_usages::transfer_src : vk_rg_usages::present);
+    const vk_rg_resource depth = graph.create_image("depth",
+      vk_rg_image_desc{.format = depth_fmt_, .extent = extent_, .aspect = vk::ImageAspectFlagBits::eDepth});
+
+    graph.add_pass("main",
+      [&](vk_render_graph::pass_builder& builder) {
+          builder.write(backbuffer, vk_rg_usages::color_attachment);
+          builder.write(depth, vk_rg_usages::depth_attachment);
+      },
+      // small enough for std::function to store inline, the graph is looked up again instead of captured
+      [this, backbuffer, depth](const vk::CommandBuffer pass_cmd) {
+          const vk_render_graph& frame_graph = current_frame().render_graph;
+          record_main_pass(pass_cmd, frame_graph.image_view(backbuffer), frame_graph.image_view(depth));
+      });
+
+    if (supports_capture_) {
+        frame_capture_.add_pass(graph, backbuffer, current_frame_);
     }
 
-    for (vk::Framebuffer buffer : swapchain_framebuffers_) {
-        device_.destroy(buffer);
+    graph.compile();
+    {
+        vk_gpu_scope frame_scope{gpu_profiler_, cmd, "frame", /*collect_statistics=*/true};
+        graph.execute(cmd, &gpu_profiler_);
     }
 
-    swapchain_images_.clear();
-    swapchain_image_views_.clear();
-    swapchain_framebuffers_.clear();
+    vk_check_result(cmd.end());
 }
 
-void vk_renderer::record_command_buffer(u32 img_index) noexcept
+void vk_renderer::record_main_pass(const vk::CommandBuffer cmd, const vk::ImageView color_view, const vk::ImageView depth_view) noexcept
 {
-    vk::CommandBufferBeginInfo cmd_buffer_begin_info{};
-    vk_check_result(command_buffer_.begin(cmd_buffer_begin_info));
-
-    const vk::ClearValue clear_color_value{
-      .color = vk::ClearColorValue{{{0.f, 0.f, 0.f, 1.f}}}
+    const vk::RenderingAttachmentInfo color_attachment_info{
+      .imageView = color_view,
+      .imageLayout = vk::ImageLayout::eColorAttachmentOptimal,
+      .loadOp = vk::AttachmentLoadOp::eClear,
+      .storeOp = vk::AttachmentStoreOp::eStore,
+      .clearValue = vk::ClearValue{.color = vk::ClearColorValue{{{0.f, 0.f, 0.f, 1.f}}}}
+    };
+    // depth only lives within the pass, nothing reads it afterwards
+    const vk::RenderingAttachmentInfo depth_attachment_info{
+      .imageView = depth_view,
+      .imageLayout = vk::ImageLayout::eDepthAttachmentOptimal,
+      .loadOp = vk::AttachmentLoadOp::eClear,
+      .storeOp = vk::AttachmentStoreOp::eDontCare,
+      .clearValue = vk::ClearValue{.depthStencil = vk::ClearDepthStencilValue{.depth = 1.f, .stencil = 0}}
     };
-    const vk::RenderPassBeginInfo render_pass_begin_info{
-      .renderPass = render_pass_,
-      .framebuffer = swapchain_framebuffers_[img_index],
+    vk::RenderingInfo rendering_info{
       .renderArea = {
         .offset = {0, 0},
         .extent = extent_
       },
-      .clearValueCount = 1,
-      .pClearValues = &clear_color_value
+      .layerCount = 1,
+      .colorAttachmentCount = 1,
+      .pColorAttachments = &color_attachment_info,
+      .pDepthAttachment = &depth_attachment_info
+    };
+
+    // item 0 is the gpu culled draw, every item after it is one instance batch
+    const vk_frame_data& frame = current_frame();
+    const auto draw_item_count = static_cast<u32>(frame.instance_batches.size() + 1);
+    // sampled once so that every recording thread agrees on it even if the compile finishes mid frame
+    const bool is_instanced_ready = pipeline_registry_.is_ready(instanced_pipeline_);
+    if (!use_parallel_recording(draw_item_count)) {
+        cmd.beginRendering(rendering_info);
+        record_draws(cmd, 0, draw_item_count, is_instanced_ready);
+        cmd.endRendering();
+        return;
+    }
+
+    rendering_info.flags = vk::RenderingFlagBits::eContentsSecondaryCommandBuffers;
+    cmd.beginRendering(rendering_info);
+
+    const vk::CommandBufferInheritanceRenderingInfo inheritance_rendering_info{
+      .colorAttachmentCount = 1,
+      .pColorAttachmentFormats = &surface_fmt_,
+      .depthAttachmentFormat = depth_fmt_,
+      .rasterizationSamples = vk::SampleCountFlagBits::e1
     };
+    parallel_recorder_.record(cmd, current_frame_, *jobs_, inheritance_rendering_info,
+      draw_item_count, config_.min_draws_per_recording_thread,
+      [this, is_instanced_ready](const vk::CommandBuffer secondary, const u32 begin, const u32 end) {
+          record_draws(secondary, begin, end, is_instanced_ready);
+      },
+      gpu_profiler_.inherited_statistics());
 
-    command_buffer_.beginRenderPass(render_pass_begin_info, vk::SubpassContents::eInline);
-    command_buffer_.bindPipeline(vk::PipelineBindPoint::eGraphics, pipeline_);
+    cmd.endRendering();
+}
+
+bool vk_renderer::use_parallel_recording(const u32 draw_item_count) const noexcept
+{
+    return config_.recording_threads > 1 && draw_item_count >= 2 * config_.min_draws_per_recording_thread;
+}
+
+void vk_renderer::record_draws(const vk::CommandBuffer cmd, const u32 begin, const u32 end, const bool is_instanced_ready) const noexcept
+{
+    if (begin == end) {
+        return;
+    }
+
+    const vk_frame_data& frame = frames_[current_frame_];
+
+    // secondaries start without any state, everything is bound again for each range
+    bindless_heap_.bind(cmd, vk::PipelineBindPoint::eGraphics);
 
     const vk::Viewport viewport{
       .x = 0.f,
@@ -859,7 +1269,7 @@ void vk_renderer::record_command_buffer(u32 img_index) noexcept
       .minDepth = 0.f,
       .maxDepth = 1.f
     };
-    command_buffer_.setViewport(/*firstViewport=*/0, /*viewportCount=*/1, &viewport);
+    cmd.setViewport(/*firstViewport=*/0, /*viewportCount=*/1, &viewport);
 
     const vk::Rect2D scissor{
       .offset = {
@@ -868,23 +1278,149 @@ void vk_renderer::record_command_buffer(u32 img_index) noexcept
       },
       .extent = extent_
     };
-    command_buffer_.setScissor(0, 1, &scissor);
+    cmd.setScissor(0, 1, &scissor);
+
+    const bool is_indexed = triangle_mesh_.has_indices();
+    if (is_indexed) {
+        cmd.bindIndexBuffer(mesh_index_buffer_.handle, /*offset=*/0, to_vk_index_type(triangle_mesh_.get_index_buffer()));
+    }
+
+    if (begin == 0) {
+        cmd.bindPipeline(vk::PipelineBindPoint::eGraphics, pipeline_registry_.get(triangle_pipeline_));
+
+        std::array buffers{mesh_vertex_buffer_.handle};
+        std::array offsets{vk::DeviceSize{0}};
+        cmd.bindVertexBuffers(0, buffers, offsets);
+        gpu_culling_.record_draw(cmd, current_frame_, is_indexed);
+    }
+
+    // instanced draws are skipped until their pipeline finishes compiling, the fallback has a different vertex layout
+    const u32 first_batch = std::max(begin, 1u) - 1;
+    const u32 last_batch = end - 1;
+    if (first_batch == last_batch || !is_instanced_ready) {
+        return;
+    }
+
+    cmd.bindPipeline(vk::PipelineBindPoint::eGraphics, pipeline_registry_.get(instanced_pipeline_));
+
+    const std::array instanced_buffers{mesh_vertex_buffer_.handle, frame.instance_buffer.handle};
+    const std::array instanced_offsets{vk::DeviceSize{0}, vk::DeviceSize{0}};
+    cmd.bindVertexBuffers(0, instanced_buffers, instanced_offsets);
+
+    const auto element_count = static_cast<u32>(triangle_mesh_.element_count());
+    for (u32 i = first_batch; i < last_batch; ++i) {
+        const vk_instance_batch& batch = frame.instance_batches[i];
+        if (is_indexed) {
+            cmd.drawIndexed(element_count, batch.instance_count, /*firstIndex=*/0, /*vertexOffset=*/0, batch.first_instance);
+        } else {
+            cmd.draw(element_count, batch.instance_count, /*firstVertex=*/0, batch.first_instance);
+        }
+    }
+}
+
+void vk_renderer::submit_culling(vk_frame_data& frame) noexcept
+{
+    vk_check_result(device_.resetCommandPool(frame.compute_command_pool));
+
+    const vk::CommandBuffer cmd = frame.compute_command_buffer;
+    vk_check_result(cmd.begin(vk::CommandBufferBeginInfo{.flags = vk::CommandBufferUsageFlagBits::eOneTimeSubmit}));
+
+    // there is no camera yet, vertices are emitted in clip space so cull against the clip volume
+    const frustum clip_volume = frustum::from_bounds(vec3f{-1.f, -1.f, 0.f}, vec3f{1.f, 1.f, 1.f});
+    {
+        vk_gpu_scope culling_scope{gpu_profiler_, cmd, "culling"};
+        gpu_culling_.record_cull(cmd, current_frame_, clip_volume,
+          static_cast<u32>(triangle_mesh_.element_count()), triangle_mesh_.has_indices());
+    }
+
+    vk_check_result(cmd.end());
+
+    static_vector<vk::SemaphoreSubmitInfo, 1> wait_infos;
+    if (upload_context_.wait_stages()) {
+        wait_infos.push_back(vk::SemaphoreSubmitInfo{
+          .semaphore = upload_context_.timeline_semaphore(),
+          .value = upload_context_.last_submitted_value(),
+          .stageMask = vk::PipelineStageFlagBits2::eComputeShader
+        });
+    }
+
+    const vk::CommandBufferSubmitInfo cmd_submit_info{.commandBuffer = cmd};
+    const vk::SemaphoreSubmitInfo signal_info{
+      .semaphore = frame.cull_finished_semaphore,
+      .stageMask = vk::PipelineStageFlagBits2::eAllCommands
+    };
+    const vk::SubmitInfo2 submit_info{
+      .waitSemaphoreInfoCount = wait_infos.size(),
+      .pWaitSemaphoreInfos = wait_infos.data(),
+      .commandBufferInfoCount = 1,
+      .pCommandBufferInfos = &cmd_submit_info,
+      .signalSemaphoreInfoCount = 1,
+      .pSignalSemaphoreInfos = &signal_info
+    };
+    vk_check_result(compute_queue_.submit2({submit_info}));
+}
+
+void vk_renderer::stream_instances(vk_frame_data& frame) noexcept
+{
+    frame.instance_count = static_cast<u32>(std::min<usize>(pending_instances_.size(), config_.max_instances_per_frame));
+    if (frame.instance_count < pending_instances_.size()) {
+        VKE_LOG(renderer, warning, "{} instances exceed the per frame capacity, {} are dropped",
+          pending_instances_.size(), pending_instances_.size() - frame.instance_count);
+    }
+
+    // every draw_instanced call is drawn on its own, batches past the capacity are clipped
+    frame.instance_batches.clear();
+    u32 first_instance = 0;
+    for (const u32 batch_size : pending_batch_sizes_) {
+        const u32 instance_count = std::min(batch_size, frame.instance_count - first_instance);
+        if (instance_count == 0) {
+            break;
+        }
 
-    std::array buffers{mesh_buffer_};
-    std::array offsets{vk::DeviceSize{0}};
-    command_buffer_.bindVertexBuffers(0, buffers, offsets);
-    command_buffer_.draw(static_cast<u32>(triangle_mesh_.get_vertex_buffer().size()), 1, 0, 0);
-    command_buffer_.endRenderPass();
+        frame.instance_batches.push_back(vk_instance_batch{.first_instance = first_instance, .instance_count = instance_count});
+        first_instance += instance_count;
+    }
 
-    vk_check_result(command_buffer_.end());
+    if (frame.instance_count != 0) {
+        const vk::DeviceSize byte_count = sizeof(mesh_instance) * frame.instance_count;
+        std::memcpy(frame.instance_data, pending_instances_.data(), byte_count);
+        allocator_.flushAllocation(frame.instance_buffer.allocation, /*offset=*/0, byte_count);
+    }
+    pending_instances_.clear();
+    pending_batch_sizes_.clear();
 }
 
-vk::ShaderModule vk_renderer::create_shader_module(std::span<const u8> spirv_binary) noexcept
+void vk_renderer::update_frame_stats(const f64 fence_wait_ms, const f64 record_ms) noexcept
 {
-    return vk_check_result(device_.createShaderModule(vk::ShaderModuleCreateInfo{
-      .codeSize = spirv_binary.size(),
-      .pCode = reinterpret_cast<const u32*>(spirv_binary.data())
-    }));
+    const auto now = std::chrono::steady_clock::now();
+    const std::chrono::duration<f64, std::milli> frame_time = now - last_frame_time_;
+    last_frame_time_ = now;
+
+    frame_stats_.frame_time_ms.add(frame_time.count());
+    frame_stats_.fence_wait_ms.add(fence_wait_ms);
+    frame_stats_.record_ms.add(record_ms);
+    frame_stats_.total_frame_time_ms += frame_time.count();
+    ++frame_stats_.frame_count;
+
+    if (frame_stats_.frame_count % vk_frame_stats::history_size == 0) {
+        VKE_LOG(renderer, info, "frame time avg: {:.3f}ms min: {:.3f}ms max: {:.3f}ms, fence wait avg: {:.3f}ms ({} frames in flight), "
+          "recording avg: {:.3f}ms ({} threads)",
+          frame_stats_.frame_time_ms.average(),
+          frame_stats_.frame_time_ms.min(),
+          frame_stats_.frame_time_ms.max(),
+          frame_stats_.fence_wait_ms.average(),
+          config_.frames_in_flight,
+          frame_stats_.record_ms.average(),
+          config_.recording_threads);
+
+        if (gpu_profiler_.is_timing_enabled()) {
+            std::string gpu_times;
+            for (const vk_gpu_scope_stats& scope : gpu_profiler_.scope_stats()) {
+                fmt::format_to(std::back_inserter(gpu_times), "{}{}: {:.3f}ms", gpu_times.empty() ? "" : ", ", scope.name, scope.gpu_ms.average());
+            }
+            VKE_LOG(renderer, info, "gpu time avg: {}", gpu_times);
+        }
+    }
 }
 
 } // namespace volkano
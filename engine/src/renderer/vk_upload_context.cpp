@@ -0,0 +1,284 @@
+/*
+ * Copyright (C) 2023 Emre Simsirli
+ *
+ * Licensed under GPLv3 or any later version.
+ * Refer to the included LICENSE file.
+ */
+
+#include "renderer/vk_upload_context.h"
+
+#include <algorithm>
+#include <cstring>
+#include <ranges>
+
+#include "renderer/vk_renderer.h"
+
+namespace volkano {
+
+namespace {
+
+constexpr vk::DeviceSize staging_alignment = 16;
+
+constexpr vk::DeviceSize align_up(const vk::DeviceSize size, const vk::DeviceSize alignment) noexcept
+{
+    return (size + alignment - 1) & ~(alignment - 1);
+}
+
+} // namespace
+
+void vk_upload_context::initialize(const vk::Device device, const vma::Allocator allocator,
+  const vk::Queue transfer_queue, const u32 transfer_family_index, const u32 graphics_family_index,
+  const vk_upload_context_config& config) noexcept
+{
+    device_ = device;
+    allocator_ = allocator;
+    transfer_queue_ = transfer_queue;
+    transfer_family_index_ = transfer_family_index;
+    graphics_family_index_ = graphics_family_index;
+
+    void* mapped_data = nullptr;
+    staging_buffer_ = create_host_visible_buffer(allocator_, config.staging_size,
+      vk::BufferUsageFlagBits::eTransferSrc, mapped_data);
+    staging_data_ = static_cast<u8*>(mapped_data);
+
+    command_pool_ = vk_check_result(device_.createCommandPool(vk::CommandPoolCreateInfo{
+      .flags = vk::CommandPoolCreateFlagBits::eTransient | vk::CommandPoolCreateFlagBits::eResetCommandBuffer,
+      .queueFamilyIndex = transfer_family_index_
+    }));
+
+    const vk::SemaphoreTypeCreateInfo semaphore_type_create_info{
+      .semaphoreType = vk::SemaphoreType::eTimeline,
+      .initialValue = 0
+    };
+    timeline_semaphore_ = vk_check_result(device_.createSemaphore(vk::SemaphoreCreateInfo{
+      .pNext = &semaphore_type_create_info
+    }));
+
+    VKE_LOG(renderer, verbose, "upload context created, staging size: {} bytes, ownership transfer: {}",
+      config.staging_size, has_ownership_transfer());
+}
+
+void vk_upload_context::destroy() noexcept
+{
+    if (!device_) {
+        return;
+    }
+
+    submit();
+    wait(last_submitted_value_);
+    collect();
+
+    device_.destroy(command_pool_);
+    device_.destroy(timeline_semaphore_);
+    destroy_buffer(allocator_, staging_buffer_);
+    device_ = nullptr;
+}
+
+u64 vk_upload_context::upload(const vk_buffer& dst, const vk::DeviceSize dst_offset, const std::span<const std::byte> data,
+  const vk::PipelineStageFlags2 dst_stage, const vk::AccessFlags2 dst_access) noexcept
+{
+    const vk::DeviceSize src_offset = allocate_staging(data.size());
+    std::memcpy(staging_data_ + src_offset, data.data(), data.size());
+    allocator_.flushAllocation(staging_buffer_.allocation, src_offset, data.size());
+
+    VKE_ASSERT(dst_offset + data.size() <= dst.size);
+    pending_copies_.push_back(pending_copy{
+      .dst = dst.handle,
+      .transfers_ownership = has_ownership_transfer() && dst.sharing_mode == vk::SharingMode::eExclusive,
+      .region = vk::BufferCopy{
+        .srcOffset = src_offset,
+        .dstOffset = dst_offset,
+        .size = data.size()
+      },
+      .dst_stage = dst_stage,
+      .dst_access = dst_access
+    });
+
+    return last_submitted_value_ + 1;
+}
+
+u64 vk_upload_context::submit() noexcept
+{
+    if (pending_copies_.empty()) {
+        return last_submitted_value_;
+    }
+
+    vk::CommandBuffer cmd = nullptr;
+    if (free_command_buffers_.empty()) {
+        cmd = vk_check_result(device_.allocateCommandBuffers(vk::CommandBufferAllocateInfo{
+          .commandPool = command_pool_,
+          .level = vk::CommandBufferLevel::ePrimary,
+          .commandBufferCount = 1
+        })).front();
+    } else {
+        cmd = free_command_buffers_.back();
+        free_command_buffers_.pop_back();
+    }
+
+    vk_check_result(cmd.begin(vk::CommandBufferBeginInfo{.flags = vk::CommandBufferUsageFlagBits::eOneTimeSubmit}));
+
+    // one copy command per destination buffer with all its regions
+    std::ranges::stable_sort(pending_copies_, [](const pending_copy& l, const pending_copy& r) { return l.dst < r.dst; });
+
+    std::vector<vk::BufferCopy> regions;
+    std::vector<vk::BufferMemoryBarrier2> release_barriers;
+    for (auto it = pending_copies_.begin(); it != pending_copies_.end();) {
+        const auto dst_end = std::find_if(it, pending_copies_.end(), [dst = it->dst](const pending_copy& c) { return c.dst != dst; });
+
+        regions.clear();
+        for (const pending_copy& copy : std::ranges::subrange(it, dst_end)) {
+            regions.push_back(copy.region);
+            wait_stages_ |= copy.dst_stage;
+
+            if (copy.transfers_ownership) {
+                release_barriers.push_back(vk::BufferMemoryBarrier2{
+                  .srcStageMask = vk::PipelineStageFlagBits2::eCopy,
+                  .srcAccessMask = vk::AccessFlagBits2::eTransferWrite,
+                  .dstStageMask = vk::PipelineStageFlagBits2::eNone,
+                  .dstAccessMask = vk::AccessFlagBits2::eNone,
+                  .srcQueueFamilyIndex = transfer_family_index_,
+                  .dstQueueFamilyIndex = graphics_family_index_,
+                  .buffer = copy.dst,
+                  .offset = copy.region.dstOffset,
+                  .size = copy.region.size
+                });
+                pending_acquire_barriers_.push_back(vk::BufferMemoryBarrier2{
+                  .srcStageMask = vk::PipelineStageFlagBits2::eNone,
+                  .srcAccessMask = vk::AccessFlagBits2::eNone,
+                  .dstStageMask = copy.dst_stage,
+                  .dstAccessMask = copy.dst_access,
+                  .srcQueueFamilyIndex = transfer_family_index_,
+                  .dstQueueFamilyIndex = graphics_family_index_,
+                  .buffer = copy.dst,
+                  .offset = copy.region.dstOffset,
+                  .size = copy.region.size
+                });
+            }
+        }
+
+        cmd.copyBuffer(staging_buffer_.handle, it->dst, regions);
+        it = dst_end;
+    }
+
+    if (!release_barriers.empty()) {
+        cmd.pipelineBarrier2(vk::DependencyInfo{
+          .bufferMemoryBarrierCount = static_cast<u32>(release_barriers.size()),
+          .pBufferMemoryBarriers = release_barriers.data()
+        });
+    }
+
+    vk_check_result(cmd.end());
+
+    ++last_submitted_value_;
+    const vk::CommandBufferSubmitInfo cmd_submit_info{.commandBuffer = cmd};
+    const vk::SemaphoreSubmitInfo signal_info{
+      .semaphore = timeline_semaphore_,
+      .value = last_submitted_value_,
+      .stageMask = vk::PipelineStageFlagBits2::eAllCommands
+    };
+    const vk::SubmitInfo2 submit_info{
+      .commandBufferInfoCount = 1,
+      .pCommandBufferInfos = &cmd_submit_info,
+      .signalSemaphoreInfoCount = 1,
+      .pSignalSemaphoreInfos = &signal_info
+    };
+    vk_check_result(transfer_queue_.submit2({submit_info}));
+
+    VKE_LOG(renderer, verbose, "upload batch {} submitted, {} copies, {} staging bytes",
+      last_submitted_value_, pending_copies_.size(), batch_staging_bytes_);
+
+    in_flight_batches_.push_back(in_flight_batch{
+      .cmd = cmd,
+      .timeline_value = last_submitted_value_,
+      .staging_bytes = std::exchange(batch_staging_bytes_, 0)
+    });
+    pending_copies_.clear();
+
+    return last_submitted_value_;
+}
+
+void vk_upload_context::collect() noexcept
+{
+    while (!in_flight_batches_.empty() && is_complete(in_flight_batches_.front().timeline_value)) {
+        const in_flight_batch& batch = in_flight_batches_.front();
+        staging_in_use_ -= batch.staging_bytes;
+        vk_check_result(batch.cmd.reset());
+        free_command_buffers_.push_back(batch.cmd);
+        in_flight_batches_.pop_front();
+    }
+}
+
+void vk_upload_context::record_acquire_barriers(const vk::CommandBuffer cmd) noexcept
+{
+    if (pending_acquire_barriers_.empty()) {
+        return;
+    }
+
+    cmd.pipelineBarrier2(vk::DependencyInfo{
+      .bufferMemoryBarrierCount = static_cast<u32>(pending_acquire_barriers_.size()),
+      .pBufferMemoryBarriers = pending_acquire_barriers_.data()
+    });
+    pending_acquire_barriers_.clear();
+}
+
+bool vk_upload_context::is_complete(const u64 timeline_value) noexcept
+{
+    if (timeline_value <= last_completed_value_) {
+        return true;
+    }
+
+    last_completed_value_ = vk_check_result(device_.getSemaphoreCounterValue(timeline_semaphore_));
+    return timeline_value <= last_completed_value_;
+}
+
+void vk_upload_context::wait(const u64 timeline_value) noexcept
+{
+    if (is_complete(timeline_value)) {
+        return;
+    }
+
+    const vk::SemaphoreWaitInfo wait_info{
+      .semaphoreCount = 1,
+      .pSemaphores = &timeline_semaphore_,
+      .pValues = &timeline_value
+    };
+    vk_check_result(device_.waitSemaphores(wait_info, /*timeout=*/std::numeric_limits<u64>::max()));
+    last_completed_value_ = timeline_value;
+}
+
+vk::DeviceSize vk_upload_context::allocate_staging(const vk::DeviceSize size) noexcept
+{
+    const vk::DeviceSize aligned_size = align_up(size, staging_alignment);
+    VKE_ASSERT_MSG(aligned_size <= staging_buffer_.size, "upload of {} bytes does not fit into the staging buffer", size);
+
+    while (true) {
+        if (staging_in_use_ == 0) {
+            staging_head_ = 0;
+        }
+
+        // allocations can't wrap around the ring, the tail end of the buffer is skipped instead
+        const vk::DeviceSize wrap_padding = staging_head_ + aligned_size > staging_buffer_.size
+          ? staging_buffer_.size - staging_head_
+          : 0;
+        const vk::DeviceSize required_size = wrap_padding + aligned_size;
+
+        if (staging_buffer_.size - staging_in_use_ >= required_size) {
+            const vk::DeviceSize offset = wrap_padding != 0 ? 0 : staging_head_ % staging_buffer_.size;
+            staging_head_ = offset + aligned_size;
+            staging_in_use_ += required_size;
+            batch_staging_bytes_ += required_size;
+            return offset;
+        }
+
+        // ring is full, stall until the oldest batch retires
+        if (in_flight_batches_.empty()) {
+            submit();
+        }
+
+        VKE_LOG(renderer, debug, "staging ring is full, waiting for upload batch {}", in_flight_batches_.front().timeline_value);
+        wait(in_flight_batches_.front().timeline_value);
+        collect();
+    }
+}
+
+} // namespace volkano
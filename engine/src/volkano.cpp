@@ -9,6 +9,7 @@
 #include <SDL2/SDL_vulkan.h>
 
 #include "volkano.h"
+#include "core/memory/allocation_tracker.h"
 #include "core/util/variant_visit_nt.h"
 #include "renderer/vk_renderer.h"
 
@@ -16,16 +17,54 @@ VKE_DEFINE_LOG_CATEGORY_STATIC(engine, verbose);
 
 namespace volkano {
 
+namespace {
+
+vk_renderer_config make_renderer_config(const engine_config& config) noexcept
+{
+    return vk_renderer_config{
+      .recording_threads = config.recording_threads,
+      .headless = config.headless,
+      .headless_extent = vk::Extent2D{config.headless_extent.x, config.headless_extent.y},
+      .capture_directory = config.capture_directory
+    };
+}
+
+} // namespace
+
 engine::engine() noexcept
-    : engine(std::make_unique<vk_renderer>(this))
+    : engine(engine_config{})
+{
+}
+
+engine::engine(const engine_config& config) noexcept
+    : engine(std::make_unique<vk_renderer>(this, make_renderer_config(config)), config)
 {
 }
 
-engine::engine(std::unique_ptr<renderer_interface> renderer) noexcept
-  : renderer_{std::move(renderer)}
+engine::engine(std::unique_ptr<renderer_interface> renderer, const engine_config& config) noexcept
+  : config_{config},
+    jobs_{config.job_worker_count},
+    renderer_{std::move(renderer)},
+    frame_pacer_{frame_pacer_config{.target_frame_rate = config.target_frame_rate}}
 {
     VKE_ASSERT(renderer_ != nullptr);
 
+    if (config_.async_logging) {
+        logger::get().enable_async();
+    }
+    if (!config_.log_config_path.empty()) {
+        log_config_watcher_ = std::make_unique<log_config_watcher>(config_.log_config_path);
+    }
+    if (!config_.capture_path.empty() && config_.max_frames == 0) {
+        VKE_LOG(engine, warning, "{} is never written, capturing the last frame needs a frame limit", config_.capture_path.string());
+    }
+
+    if (config_.headless) {
+        VKE_LOG(engine, info, "running headless at {}x{}", config_.headless_extent.x, config_.headless_extent.y);
+        renderer_->initialize();
+        return;
+    }
+
     VKE_ASSERT_MSG(SDL_Init(SDL_INIT_VIDEO | SDL_INIT_EVENTS) >= 0, "SDL init error: {}", SDL_GetError());
 
     // todo read from config, dont init right away
@@ -39,12 +78,27 @@ engine::engine(std::unique_ptr<renderer_interface> renderer) noexcept
 
 engine::~engine() noexcept
 {
-    SDL_Quit();
+    // the renderer may still reference the window
+    renderer_.reset();
+    log_config_watcher_.reset();
+    if (!config_.headless) {
+        SDL_Quit();
+    }
+    if (config_.async_logging) {
+        logger::get().disable_async();
+    }
 }
 
 bool engine::tick() noexcept
 {
-    while (SDL_PollEvent(&window_event_)) {
+    // input is sampled once the frame may start and the renderer can take it, so it is as fresh as possible
+    frame_pacer_.begin_frame();
+    if (should_render_) {
+        renderer_->wait_for_frame();
+    }
+    frame_pacer_.mark_input_sampled();
+
+    while (!config_.headless && SDL_PollEvent(&window_event_)) {
         switch (window_event_.type) {
             case SDL_QUIT:
                 return false;
@@ -72,13 +126,45 @@ bool engine::tick() noexcept
     }
 
     if (should_render_) {
+        // the copy is read back without stalling, it is written out by the time the renderer shuts down
+        if (!config_.capture_path.empty() && rendered_frame_count_ + 1 == config_.max_frames) {
+            renderer_->capture_frame(config_.capture_path);
+        }
         renderer_->render();
+        ++rendered_frame_count_;
+    } else {
+        renderer_->skip_frame();
     }
-    return true;
+    frame_pacer_.end_frame();
+
+    if (const frame_pacer_stats& stats = frame_pacer_.stats(); stats.frame_count % frame_pacer_stats::history_size == 0) {
+        VKE_LOG(engine, info, "frame pacing - target: {:.1f}fps, cpu avg: {:.3f}ms, wait avg: {:.3f}ms, frame start interval avg: {:.3f}ms, "
+          "frame start jitter: {:.3f}ms, input latency avg: {:.3f}ms",
+          frame_pacer_.target_frame_rate(),
+          stats.cpu_ms.average(),
+          stats.wait_ms.average(),
+          stats.frame_start_interval_ms.average(),
+          stats.frame_start_interval_ms.standard_deviation(),
+          stats.input_latency_ms.average());
+
+        if constexpr (is_tracking_allocations()) {
+            // a steady state frame is expected to stay off the heap entirely
+            const u64 allocation_count = thread_heap_allocation_count();
+            VKE_LOG(engine, info, "heap allocations - main thread avg: {:.2f} per frame",
+              static_cast<f64>(allocation_count - reported_allocation_count_) / frame_pacer_stats::history_size);
+            reported_allocation_count_ = allocation_count;
+        }
+    }
+
+    return config_.max_frames == 0 || rendered_frame_count_ < config_.max_frames;
 }
 
 vec2u engine::get_window_extent() noexcept
 {
+    if (config_.headless) {
+        return config_.headless_extent;
+    }
+
     vec2u window_extent;
     SDL_Vulkan_GetDrawableSize(window_,
       reinterpret_cast<int*>(&window_extent.x),
@@ -5,11 +5,68 @@
  * Refer to the included LICENSE file.
  */
 
+#include <charconv>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <string_view>
+#include <vector>
+
 #include "volkano.h"
 
-int main([[maybe_unused]] int argc, [[maybe_unused]] char* argv[])
+int main(int argc, char* argv[])
 {
-    volkano::engine engine;
-    while (engine.tick()) {}
+    // --headless renders without a window, --frames N stops after N frames, --capture out.ppm writes
+    // the last of them, --capture-all dir writes every frame to the directory, --fps N paces frames
+    // to a target rate, --async-log writes logs on a background thread, --log-config file sets
+    // category verbosities and is reapplied whenever it changes
+    volkano::engine_config config;
+    for (int i = 1; i < argc; ++i) {
+        const std::string_view arg{argv[i]};
+        if (arg == "--headless") {
+            config.headless = true;
+        } else if (arg == "--frames" && i + 1 < argc) {
+            const std::string_view frames{argv[++i]};
+            const auto [end, error] = std::from_chars(frames.data(), frames.data() + frames.size(), config.max_frames);
+            if (error != std::errc{} || end != frames.data() + frames.size()) {
+                std::fprintf(stderr, "--frames expects a frame count, got %s\n", argv[i]);
+                return EXIT_FAILURE;
+            }
+        } else if (arg == "--capture" && i + 1 < argc) {
+            config.capture_path = argv[++i];
+        } else if (arg == "--fps" && i + 1 < argc) {
+            const std::string_view fps{argv[++i]};
+            const auto [end, error] = std::from_chars(fps.data(), fps.data() + fps.size(), config.target_frame_rate);
+            if (error != std::errc{} || end != fps.data() + fps.size() || config.target_frame_rate < 0.0) {
+                std::fprintf(stderr, "--fps expects a non-negative frame rate, got %s\n", argv[i]);
+                return EXIT_FAILURE;
+            }
+        } else if (arg == "--capture-all" && i + 1 < argc) {
+            config.capture_directory = argv[++i];
+        } else if (arg == "--async-log") {
+            config.async_logging = true;
+        } else if (arg == "--log-config" && i + 1 < argc) {
+            config.log_config_path = argv[++i];
+        }
+    }
+
+    volkano::engine engine{config};
+
+    // a ring of triangles drawn with one instanced draw call
+    constexpr volkano::u32 ring_instance_count = 256;
+    std::vector<volkano::mesh_instance> ring_instances;
+    for (volkano::u32 i = 0; i < ring_instance_count; ++i) {
+        const volkano::f32 t = static_cast<volkano::f32>(i) / static_cast<volkano::f32>(ring_instance_count);
+        const volkano::f32 angle = t * 2.f * volkano::math::consts::pi;
+        ring_instances.push_back(volkano::mesh_instance{
+          .translation = volkano::vec3f{std::cos(angle) * 0.8f, std::sin(angle) * 0.8f, 0.f},
+          .scale = 0.05f,
+          .color = volkano::vec3f{t, 1.f - t, 1.f}
+        });
+    }
+
+    do {
+        engine.get_renderer()->draw_instanced(ring_instances);
+    } while (engine.tick());
     return 0;
 }
@@ -0,0 +1,93 @@
+/*
+ * Copyright (C) 2023 Emre Simsirli
+ *
+ * Licensed under GPLv3 or any later version.
+ * Refer to the included LICENSE file.
+ */
+
+#include <set>
+#include <thread>
+#include <vector>
+
+#include <doctest/doctest.h>
+
+#include "core/memory/block_pool.h"
+
+namespace {
+
+using volkano::block_pool;
+using volkano::u32;
+using volkano::u64;
+
+struct large {
+    u64 values[4];
+};
+
+} // namespace
+
+TEST_CASE("block pool hands out every block once")
+{
+    block_pool<u32, large> pool{4};
+    std::set<void*> blocks;
+    for (u32 i = 0; i < pool.capacity(); ++i) {
+        auto* block = pool.allocate();
+        REQUIRE(block != nullptr);
+        CHECK(pool.owns(block));
+        blocks.insert(block);
+    }
+    CHECK(blocks.size() == 4);
+    CHECK(pool.allocate() == nullptr);
+
+    pool.deallocate(static_cast<block_pool<u32, large>::block_type*>(*blocks.begin()));
+    CHECK(pool.allocate() == *blocks.begin());
+}
+
+TEST_CASE("block pool constructs and destroys values")
+{
+    block_pool<u32, large> pool{1};
+    large* value = pool.create<large>(large{{1, 2, 3, 4}});
+    REQUIRE(value != nullptr);
+    CHECK(value->values[3] == 4);
+    CHECK(pool.create<u32>(1u) == nullptr);
+
+    pool.destroy(value);
+    u32* other = pool.create<u32>(7u);
+    REQUIRE(other != nullptr);
+    CHECK(*other == 7);
+    pool.destroy(other);
+}
+
+TEST_CASE("block pool is safe to use from many threads")
+{
+    constexpr u32 thread_count = 4;
+    constexpr u32 iterations = 20000;
+    block_pool<u64> pool{8};
+
+    std::vector<std::jthread> threads;
+    std::vector<u32> failures(thread_count);
+    for (u32 t = 0; t < thread_count; ++t) {
+        threads.emplace_back([&pool, &failures, t] {
+            for (u32 i = 0; i < iterations; ++i) {
+                u64* value = pool.create<u64>(u64{t} << 32 | i);
+                if (value == nullptr) {
+                    continue;
+                }
+                std::this_thread::yield();
+                // nobody else may have been handed the same block in the meantime
+                if (*value != (u64{t} << 32 | i)) {
+                    ++failures[t];
+                }
+                pool.destroy(value);
+            }
+        });
+    }
+    threads.clear();
+
+    for (const u32 failure_count : failures) {
+        CHECK(failure_count == 0);
+    }
+    for (u32 i = 0; i < pool.capacity(); ++i) {
+        CHECK(pool.allocate() != nullptr);
+    }
+    CHECK(pool.allocate() == nullptr);
+}
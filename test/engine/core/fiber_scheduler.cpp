@@ -0,0 +1,118 @@
+/*
+ * Copyright (C) 2023 Emre Simsirli
+ *
+ * Licensed under GPLv3 or any later version.
+ * Refer to the included LICENSE file.
+ */
+
+#include <atomic>
+
+#include <doctest/doctest.h>
+
+#include "core/thread/fiber_scheduler.h"
+
+namespace {
+
+using volkano::fiber;
+using volkano::fiber_counter;
+using volkano::fiber_scheduler;
+using volkano::fiber_scheduler_config;
+using volkano::u32;
+
+struct ping_pong {
+    fiber* main = nullptr;
+    fiber* child = nullptr;
+    u32 steps = 0;
+};
+
+void ping_pong_main(void* arg)
+{
+    auto& state = *static_cast<ping_pong*>(arg);
+    while (true) {
+        ++state.steps;
+        fiber::switch_to(*state.child, *state.main);
+    }
+}
+
+} // namespace
+
+TEST_CASE("fiber switches back and forth with its creator")
+{
+    fiber main;
+    ping_pong state;
+    fiber child{&ping_pong_main, &state};
+    state.main = &main;
+    state.child = &child;
+
+    for (u32 i = 0; i < 3; ++i) {
+        fiber::switch_to(main, child);
+    }
+    CHECK(state.steps == 3);
+}
+
+TEST_CASE("fiber scheduler runs every job of a counter")
+{
+    fiber_scheduler scheduler{fiber_scheduler_config{.worker_count = 4}};
+    fiber_counter counter;
+    std::atomic<u32> sum = 0;
+
+    for (u32 i = 1; i <= 100; ++i) {
+        scheduler.run([&sum, i]() { sum.fetch_add(i, std::memory_order_relaxed); }, &counter);
+    }
+    CHECK_FALSE(scheduler.is_in_job());
+    scheduler.wait(counter);
+
+    CHECK(counter.is_done());
+    CHECK(sum.load() == 5050);
+}
+
+TEST_CASE("fiber scheduler parks waiting jobs instead of blocking workers")
+{
+    // every outer job waits on its own inner jobs, with a single worker this only finishes
+    // if waiting jobs give the thread back
+    constexpr u32 outer_count = 16;
+    fiber_scheduler scheduler{fiber_scheduler_config{.worker_count = 1, .fiber_count = 64}};
+    fiber_counter outer;
+    std::atomic<u32> inner_runs = 0;
+    std::atomic<u32> in_job = 0;
+
+    for (u32 i = 0; i < outer_count; ++i) {
+        scheduler.run([&]() {
+            in_job.fetch_add(scheduler.is_in_job() ? 1 : 0, std::memory_order_relaxed);
+            fiber_counter inner;
+            for (u32 j = 0; j < 2; ++j) {
+                scheduler.run([&inner_runs]() { inner_runs.fetch_add(1, std::memory_order_relaxed); }, &inner);
+            }
+            scheduler.wait(inner);
+        }, &outer);
+    }
+    scheduler.wait(outer);
+
+    CHECK(inner_runs.load() == outer_count * 2);
+    CHECK(in_job.load() == outer_count);
+}
+
+TEST_CASE("fiber scheduler resumes parked jobs on any worker")
+{
+    fiber_scheduler scheduler{fiber_scheduler_config{.worker_count = 3, .fiber_count = 32}};
+    fiber_counter root;
+    std::atomic<u32> leaves = 0;
+
+    // a small tree of jobs that wait at every level
+    scheduler.run([&]() {
+        fiber_counter level1;
+        for (u32 i = 0; i < 4; ++i) {
+            scheduler.run([&]() {
+                fiber_counter level2;
+                for (u32 j = 0; j < 4; ++j) {
+                    scheduler.run([&leaves]() { leaves.fetch_add(1, std::memory_order_relaxed); }, &level2);
+                }
+                scheduler.wait(level2);
+            }, &level1);
+        }
+        scheduler.wait(level1);
+    }, &root);
+    scheduler.wait(root);
+
+    CHECK(leaves.load() == 16);
+}
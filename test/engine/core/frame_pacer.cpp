@@ -0,0 +1,58 @@
+/*
+ * Copyright (C) 2023 Emre Simsirli
+ *
+ * Licensed under GPLv3 or any later version.
+ * Refer to the included LICENSE file.
+ */
+
+#include <chrono>
+
+#include <doctest/doctest.h>
+
+#include "core/time/frame_pacer.h"
+
+namespace {
+
+using volkano::frame_pacer;
+using volkano::frame_pacer_config;
+
+using namespace std::chrono_literals;
+
+} // namespace
+
+TEST_CASE("frame pacer wait never returns early")
+{
+    const frame_pacer::clock::time_point deadline = frame_pacer::clock::now() + 3ms;
+    frame_pacer::wait_until(deadline, /*spin_threshold=*/1ms);
+    CHECK(frame_pacer::clock::now() >= deadline);
+}
+
+TEST_CASE("frame pacer holds frames to the target rate")
+{
+    constexpr int frame_count = 20;
+    frame_pacer pacer{frame_pacer_config{.target_frame_rate = 200.0}};
+
+    const auto begin = frame_pacer::clock::now();
+    for (int i = 0; i < frame_count; ++i) {
+        pacer.begin_frame();
+        pacer.end_frame();
+    }
+    const auto elapsed = frame_pacer::clock::now() - begin;
+
+    // the first frame starts right away, every other one waits for a 5ms period. single intervals
+    // depend on the scheduler, only the total is checked and with plenty of room above it
+    constexpr auto expected = (frame_count - 1) * 5ms;
+    CHECK(elapsed >= expected);
+    CHECK(elapsed < 4 * expected);
+    CHECK(pacer.stats().frame_count == frame_count);
+    CHECK(pacer.stats().frame_start_interval_ms.size() == frame_count - 1);
+}
+
+TEST_CASE("frame pacer without a target does not wait")
+{
+    frame_pacer pacer;
+    pacer.begin_frame();
+    pacer.end_frame();
+
+    CHECK(pacer.stats().wait_ms.last() < 1.0);
+}
@@ -0,0 +1,51 @@
+/*
+ * Copyright (C) 2023 Emre Simsirli
+ *
+ * Licensed under GPLv3 or any later version.
+ * Refer to the included LICENSE file.
+ */
+
+#include <doctest/doctest.h>
+
+#include "core/math/frustum.h"
+
+namespace {
+
+using volkano::frustum;
+using volkano::plane;
+using volkano::sphere;
+using volkano::vec3f;
+
+const frustum clip_volume = frustum::from_bounds(vec3f{-1.f, -1.f, 0.f}, vec3f{1.f, 1.f, 1.f});
+
+} // namespace
+
+TEST_CASE("plane signed distance")
+{
+    const plane p = plane::from_point_normal(vec3f{0.f, 2.f, 0.f}, vec3f{0.f, 4.f, 0.f});
+    CHECK(p.normal == vec3f::unit_y());
+    CHECK(p.signed_distance(vec3f{5.f, 3.f, -1.f}) == doctest::Approx(1.f));
+    CHECK(p.signed_distance(vec3f{0.f, 0.f, 0.f}) == doctest::Approx(-2.f));
+}
+
+TEST_CASE("frustum sphere intersection")
+{
+    SUBCASE("inside") {
+        CHECK(clip_volume.intersects(sphere{.center = vec3f{0.f, 0.f, 0.5f}, .radius = 0.1f}));
+    }
+
+    SUBCASE("straddling a plane") {
+        CHECK(clip_volume.intersects(sphere{.center = vec3f{1.05f, 0.f, 0.5f}, .radius = 0.1f}));
+        CHECK(clip_volume.intersects(sphere{.center = vec3f{0.f, -1.05f, 0.f}, .radius = 0.1f}));
+    }
+
+    SUBCASE("outside") {
+        CHECK_FALSE(clip_volume.intersects(sphere{.center = vec3f{1.2f, 0.f, 0.5f}, .radius = 0.1f}));
+        CHECK_FALSE(clip_volume.intersects(sphere{.center = vec3f{0.f, 0.f, -0.5f}, .radius = 0.1f}));
+        CHECK_FALSE(clip_volume.intersects(sphere{.center = vec3f{0.f, 3.f, 0.5f}, .radius = 1.f}));
+    }
+
+    SUBCASE("enclosing the frustum") {
+        CHECK(clip_volume.intersects(sphere{.center = vec3f{0.f, 0.f, 0.f}, .radius = 10.f}));
+    }
+}
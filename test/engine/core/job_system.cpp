@@ -0,0 +1,129 @@
+/*
+ * Copyright (C) 2023 Emre Simsirli
+ *
+ * Licensed under GPLv3 or any later version.
+ * Refer to the included LICENSE file.
+ */
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include <doctest/doctest.h>
+
+#include "core/thread/job_system.h"
+
+namespace {
+
+using volkano::job_counter;
+using volkano::job_system;
+using volkano::u32;
+using volkano::u64;
+
+} // namespace
+
+TEST_CASE("job system runs every job of a counter")
+{
+    job_system jobs{4};
+    job_counter counter;
+    std::atomic<u32> sum = 0;
+
+    for (u32 i = 1; i <= 100; ++i) {
+        jobs.run([&sum, i]() { sum.fetch_add(i, std::memory_order_relaxed); }, &counter);
+    }
+    jobs.wait(counter);
+
+    CHECK(counter.is_done());
+    CHECK(sum.load() == 5050);
+}
+
+TEST_CASE("job system parallel for covers the range exactly once")
+{
+    job_system jobs{3};
+    std::vector<std::atomic<u32>> hits(10'000);
+
+    jobs.parallel_for(0, static_cast<u32>(hits.size()), /*min_chunk_size=*/16, [&](const u32 begin, const u32 end) {
+        for (u32 i = begin; i < end; ++i) {
+            hits[i].fetch_add(1, std::memory_order_relaxed);
+        }
+    });
+
+    bool all_once = true;
+    for (const std::atomic<u32>& hit : hits) {
+        all_once &= hit.load() == 1;
+    }
+    CHECK(all_once);
+}
+
+TEST_CASE("job system jobs can wait on the jobs they spawn")
+{
+    job_system jobs{2};
+    job_counter outer;
+    std::atomic<u64> leaves = 0;
+
+    // more waiting jobs than workers, waiting must run other jobs instead of blocking
+    for (u32 i = 0; i < 8; ++i) {
+        jobs.run([&]() {
+            job_counter inner;
+            for (u32 j = 0; j < 8; ++j) {
+                jobs.run([&leaves]() { leaves.fetch_add(1, std::memory_order_relaxed); }, &inner);
+            }
+            jobs.wait(inner);
+        }, &outer);
+    }
+    jobs.wait(outer);
+
+    CHECK(leaves.load() == 64);
+    CHECK(jobs.stats().executed_count == 72);
+}
+
+TEST_CASE("job system identifies worker threads")
+{
+    job_system jobs{2};
+    job_counter counter;
+    std::atomic<u32> worker_index = jobs.worker_count();
+
+    CHECK(jobs.current_queue_index() == jobs.worker_count());
+    while (worker_index.load() == jobs.worker_count()) {
+        jobs.run([&]() {
+            if (jobs.current_queue_index() < jobs.worker_count()) {
+                worker_index.store(jobs.current_queue_index());
+            }
+        }, &counter);
+        jobs.wait(counter);
+    }
+    CHECK(worker_index.load() < jobs.worker_count());
+}
+
+TEST_CASE("job system waits never run background jobs inline")
+{
+    job_system jobs{1};
+    std::atomic<bool> is_worker_busy = false;
+    std::atomic<bool> release_worker = false;
+
+    // keeps the only worker busy so that nothing but the waiting thread could run the background job
+    job_counter blocker;
+    jobs.run([&]() {
+        is_worker_busy.store(true);
+        while (!release_worker.load()) {
+            std::this_thread::yield();
+        }
+    }, &blocker);
+    while (!is_worker_busy.load()) {
+        std::this_thread::yield();
+    }
+
+    job_counter background;
+    std::atomic<u32> background_queue_index = jobs.worker_count();
+    jobs.run([&]() { background_queue_index.store(jobs.current_queue_index()); }, &background, volkano::job_priority::background);
+
+    job_counter normal;
+    jobs.run([]() {}, &normal);
+    jobs.wait(normal);
+    CHECK_FALSE(background.is_done());
+
+    release_worker.store(true);
+    jobs.wait(background);
+    jobs.wait(blocker);
+    CHECK(background_queue_index.load() < jobs.worker_count());
+}
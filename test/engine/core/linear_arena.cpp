@@ -0,0 +1,141 @@
+/*
+ * Copyright (C) 2023 Emre Simsirli
+ *
+ * Licensed under GPLv3 or any later version.
+ * Refer to the included LICENSE file.
+ */
+
+#include <memory>
+#include <memory_resource>
+#include <vector>
+
+#include <doctest/doctest.h>
+
+#include "core/memory/allocation_tracker.h"
+#include "core/memory/linear_arena.h"
+#include "core/memory/scratch_arena.h"
+
+namespace {
+
+using volkano::linear_arena;
+using volkano::scratch_scope;
+using volkano::u32;
+using volkano::u64;
+using volkano::uintptr;
+using volkano::usize;
+
+bool is_aligned(const void* ptr, const usize alignment)
+{
+    return reinterpret_cast<uintptr>(ptr) % alignment == 0;
+}
+
+} // namespace
+
+TEST_CASE("allocation tracker counts heap allocations")
+{
+    const u64 allocation_count = volkano::thread_heap_allocation_count();
+    const auto value = std::make_unique<u64>(1);
+    CHECK(*value == 1);
+    CHECK(volkano::thread_heap_allocation_count() == allocation_count + (volkano::is_tracking_allocations() ? 1 : 0));
+}
+
+TEST_CASE("linear arena aligns and bumps")
+{
+    linear_arena arena{1024};
+
+    void* a = arena.allocate_bytes(3, 1);
+    void* b = arena.allocate_bytes(8, 8);
+    void* c = arena.allocate_bytes(16, 64);
+    CHECK(is_aligned(b, 8));
+    CHECK(is_aligned(c, 64));
+    CHECK(static_cast<std::byte*>(b) > static_cast<std::byte*>(a));
+    CHECK(static_cast<std::byte*>(c) > static_cast<std::byte*>(b));
+    CHECK(arena.used() <= 3 + 8 + 16 + 7 + 63);
+
+    arena.reset();
+    CHECK(arena.used() == 0);
+    CHECK(arena.allocate_bytes(3, 1) == a);
+}
+
+TEST_CASE("linear arena grows to its peak once emptied")
+{
+    linear_arena arena{256};
+
+    void* first = arena.allocate_bytes(200);
+    void* overflow = arena.allocate_bytes(200);
+    CHECK(first != overflow);
+    CHECK(arena.capacity() == 256);
+    CHECK(arena.used() > 400);
+
+    arena.reset();
+    CHECK(arena.capacity() >= 400);
+    CHECK(arena.used() == 0);
+
+    // the same workload fits into the block now
+    const usize capacity = arena.capacity();
+    static_cast<void>(arena.allocate_bytes(200));
+    static_cast<void>(arena.allocate_bytes(200));
+    arena.reset();
+    CHECK(arena.capacity() == capacity);
+}
+
+TEST_CASE("linear arena rewinds to markers")
+{
+    linear_arena arena{256};
+    static_cast<void>(arena.allocate_bytes(16));
+
+    const linear_arena::marker mark = arena.mark();
+    const usize used = arena.used();
+    void* next = arena.allocate_bytes(16);
+    static_cast<void>(arena.allocate_bytes(1024));
+    CHECK(arena.used() > used);
+
+    arena.rewind(mark);
+    CHECK(arena.used() == used);
+    CHECK(arena.allocate_bytes(16) == next);
+}
+
+TEST_CASE("linear arena backs pmr containers")
+{
+    linear_arena arena{4096};
+    {
+        std::pmr::vector<u32> values{&arena};
+        for (u32 i = 0; i < 100; ++i) {
+            values.push_back(i);
+        }
+        CHECK(values.back() == 99);
+        CHECK(arena.used() >= 100 * sizeof(u32));
+    }
+    arena.reset();
+
+    // a warmed up arena serves the same workload without touching the heap
+    const u64 allocation_count = volkano::thread_heap_allocation_count();
+    for (u32 frame = 0; frame < 4; ++frame) {
+        std::pmr::vector<u32> values{&arena};
+        for (u32 i = 0; i < 100; ++i) {
+            values.push_back(i);
+        }
+        arena.reset();
+    }
+    CHECK(volkano::thread_heap_allocation_count() == allocation_count);
+}
+
+TEST_CASE("scratch scopes release what was allocated within them")
+{
+    linear_arena& arena = volkano::thread_scratch_arena();
+    const usize used = arena.used();
+    {
+        scratch_scope outer;
+        std::pmr::vector<u32> values{outer.resource()};
+        values.resize(64);
+        const usize outer_used = arena.used();
+        CHECK(outer_used > used);
+        {
+            scratch_scope inner;
+            static_cast<void>(inner.arena().allocate_array<u64>(32));
+            CHECK(arena.used() > outer_used);
+        }
+        CHECK(arena.used() == outer_used);
+    }
+    CHECK(arena.used() == used);
+}
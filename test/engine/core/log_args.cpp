@@ -0,0 +1,73 @@
+/*
+ * Copyright (C) 2023 Emre Simsirli
+ *
+ * Licensed under GPLv3 or any later version.
+ * Refer to the included LICENSE file.
+ */
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <doctest/doctest.h>
+
+#include "core/logging/log_args.h"
+
+namespace {
+
+using volkano::deferred_log_arg;
+using volkano::deferred_log_arg_t;
+using volkano::log_buffer;
+using volkano::u8;
+using volkano::u64;
+using volkano::usize;
+
+template<typename... Args>
+std::string encode_and_format(const std::string_view format, const Args&... args)
+{
+    std::vector<std::byte> bytes((usize{0} + ... + volkano::encoded_log_arg_size(args)));
+    [[maybe_unused]] std::byte* cursor = bytes.data();
+    ((cursor = volkano::encode_log_arg(cursor, args)), ...);
+    CHECK(cursor == bytes.data() + bytes.size());
+
+    log_buffer out;
+    volkano::format_deferred_log<deferred_log_arg_t<Args>...>(format, bytes.data(), out);
+    return std::string{out.data(), out.size()};
+}
+
+} // namespace
+
+TEST_CASE("deferred log args are numbers, enums and strings only")
+{
+    enum class mode : u8 { fast };
+    CHECK(deferred_log_arg<int>);
+    CHECK(deferred_log_arg<const double&>);
+    CHECK(deferred_log_arg<mode>);
+    CHECK(deferred_log_arg<const char(&)[4]>);
+    CHECK(deferred_log_arg<std::string&>);
+    CHECK(deferred_log_arg<std::string_view>);
+    CHECK_FALSE(deferred_log_arg<const int*>);
+    CHECK_FALSE(deferred_log_arg<std::vector<int>>);
+}
+
+TEST_CASE("deferred log args format the same as the original arguments")
+{
+    std::string owned = "owned";
+    const char* c_str = "c string";
+
+    CHECK(encode_and_format("no args") == "no args");
+    CHECK(encode_and_format("{} {:.2f} {} {}", 42, 1.5, u64{1} << 40, true) == "42 1.50 1099511627776 true");
+    CHECK(encode_and_format("{}|{}|{}|{}", owned, c_str, std::string_view{"view"}, "") == "owned|c string|view|");
+}
+
+TEST_CASE("deferred log args copy strings instead of pointing at them")
+{
+    std::string text = "before";
+    std::vector<std::byte> bytes(volkano::encoded_log_arg_size(text));
+    volkano::encode_log_arg(bytes.data(), text);
+    text = "after!";
+
+    log_buffer out;
+    volkano::format_deferred_log<std::string_view>("{}", bytes.data(), out);
+    CHECK(std::string_view{out.data(), out.size()} == "before");
+}
@@ -0,0 +1,66 @@
+/*
+ * Copyright (C) 2023 Emre Simsirli
+ *
+ * Licensed under GPLv3 or any later version.
+ * Refer to the included LICENSE file.
+ */
+
+#include <vector>
+
+#include <doctest/doctest.h>
+
+#include "core/logging/log_config.h"
+#include "core/logging/logging.h"
+
+VKE_DEFINE_LOG_CATEGORY_STATIC(log_config_test, warning);
+
+namespace {
+
+using volkano::log_config_entry;
+using volkano::log_verbosity;
+using volkano::logger;
+
+} // namespace
+
+TEST_CASE("log config parses entries separated by commas and lines")
+{
+    const std::vector<log_config_entry> entries = volkano::parse_log_config(
+      "renderer=verbose, vulkan_validation = error\n"
+      "# comment=info\n"
+      "engine=debug # trailing comment\r\n"
+      "broken, missing=, =info, fs=loud\n"
+      "*=warning");
+
+    REQUIRE(entries.size() == 4);
+    CHECK(entries[0].category == "renderer");
+    CHECK(entries[0].verbosity == log_verbosity::verbose);
+    CHECK(entries[1].category == "vulkan_validation");
+    CHECK(entries[1].verbosity == log_verbosity::error);
+    CHECK(entries[2].category == "engine");
+    CHECK(entries[2].verbosity == log_verbosity::debug);
+    CHECK(entries[3].category == log_config_entry::all_categories);
+    CHECK(entries[3].verbosity == log_verbosity::warning);
+}
+
+TEST_CASE("log categories are found by their dense id")
+{
+    const auto id = logger::get().find_category_id("log_config_test");
+    REQUIRE(id.has_value());
+    CHECK(*id == logcat_log_config_test.id());
+    CHECK_FALSE(logger::get().find_category_id("no_such_category").has_value());
+
+    logger::get().set_category_verbosity(*id, log_verbosity::debug);
+    CHECK(logcat_log_config_test.verbosity() == log_verbosity::debug);
+    logger::get().set_category_verbosity(*id, log_verbosity::warning);
+}
+
+TEST_CASE("log config is applied on top of the default verbosities")
+{
+    const std::vector<log_config_entry> entries = volkano::parse_log_config("log_config_test=verbose");
+    logger::get().apply_config(entries);
+    CHECK(logcat_log_config_test.verbosity() == log_verbosity::verbose);
+
+    // categories that are no longer listed go back to their default
+    logger::get().apply_config({});
+    CHECK(logcat_log_config_test.verbosity() == log_verbosity::warning);
+}
@@ -0,0 +1,129 @@
+/*
+ * Copyright (C) 2023 Emre Simsirli
+ *
+ * Licensed under GPLv3 or any later version.
+ * Refer to the included LICENSE file.
+ */
+
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include <doctest/doctest.h>
+
+#include "core/logging/log_ring.h"
+
+namespace {
+
+using volkano::log_ring;
+using volkano::u32;
+using volkano::usize;
+
+bool push(log_ring& ring, const std::string_view text)
+{
+    std::byte* record = ring.try_reserve(static_cast<u32>(text.size()));
+    if (record == nullptr) {
+        return false;
+    }
+    std::memcpy(record, text.data(), text.size());
+    log_ring::commit(record);
+    return true;
+}
+
+std::vector<std::string> pop_all(log_ring& ring)
+{
+    std::vector<std::string> records;
+    ring.consume([&](const std::span<const std::byte> record) {
+        records.emplace_back(reinterpret_cast<const char*>(record.data()), record.size());
+    });
+    return records;
+}
+
+} // namespace
+
+TEST_CASE("log ring hands out records in order")
+{
+    log_ring ring{256};
+    CHECK(push(ring, "first"));
+    CHECK(push(ring, "second"));
+
+    const std::vector<std::string> records = pop_all(ring);
+    REQUIRE(records.size() == 2);
+    CHECK(records[0] == "first");
+    CHECK(records[1] == "second");
+    CHECK(ring.read_position() == ring.write_position());
+}
+
+TEST_CASE("log ring stops at records that are not committed")
+{
+    log_ring ring{256};
+    std::byte* pending = ring.try_reserve(4);
+    REQUIRE(pending != nullptr);
+    CHECK(push(ring, "after"));
+
+    CHECK(pop_all(ring).empty());
+    std::memcpy(pending, "wait", 4);
+    log_ring::commit(pending);
+
+    const std::vector<std::string> records = pop_all(ring);
+    REQUIRE(records.size() == 2);
+    CHECK(records[0] == "wait");
+    CHECK(records[1] == "after");
+}
+
+TEST_CASE("log ring rejects records when full and wraps once consumed")
+{
+    log_ring ring{256};
+    const std::string text(ring.max_record_size(), 'x');
+
+    usize pushed = 0;
+    while (push(ring, text)) {
+        ++pushed;
+    }
+    CHECK(pushed > 0);
+    CHECK(pop_all(ring).size() == pushed);
+
+    // the next records straddle the end of the buffer and are moved to its start
+    for (u32 round = 0; round < 8; ++round) {
+        REQUIRE(push(ring, text));
+        const std::vector<std::string> records = pop_all(ring);
+        REQUIRE(records.size() == 1);
+        CHECK(records[0] == text);
+    }
+}
+
+TEST_CASE("log ring keeps every record of concurrent producers")
+{
+    constexpr u32 producer_count = 4;
+    constexpr u32 records_per_producer = 10'000;
+    log_ring ring{4096};
+
+    std::vector<std::jthread> producers;
+    for (u32 p = 0; p < producer_count; ++p) {
+        producers.emplace_back([&ring, p]() {
+            for (u32 i = 0; i < records_per_producer; ++i) {
+                const std::string text = std::to_string(p) + ':' + std::to_string(i);
+                while (!push(ring, text)) {
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+
+    std::vector<u32> next(producer_count, 0);
+    bool in_order = true;
+    usize received = 0;
+    while (received < producer_count * records_per_producer) {
+        received += ring.consume([&](const std::span<const std::byte> record) {
+            const std::string text{reinterpret_cast<const char*>(record.data()), record.size()};
+            const usize colon = text.find(':');
+            const auto p = static_cast<u32>(std::stoul(text.substr(0, colon)));
+            const auto i = static_cast<u32>(std::stoul(text.substr(colon + 1)));
+            in_order &= next[p] == i;
+            next[p] = i + 1;
+        });
+    }
+    CHECK(in_order);
+}
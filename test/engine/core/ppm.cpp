@@ -0,0 +1,58 @@
+/*
+ * Copyright (C) 2023 Emre Simsirli
+ *
+ * Licensed under GPLv3 or any later version.
+ * Refer to the included LICENSE file.
+ */
+
+#include <string_view>
+#include <vector>
+
+#include <doctest/doctest.h>
+
+#include "core/image/ppm.h"
+
+namespace {
+
+using volkano::encode_ppm;
+using volkano::pixel_layout;
+using volkano::u8;
+
+constexpr std::string_view header_2x2 = "P6\n2 2\n255\n";
+
+std::vector<u8> pixels_of(const std::vector<u8>& ppm, const std::size_t pixel_count)
+{
+    return std::vector<u8>(ppm.end() - static_cast<std::ptrdiff_t>(pixel_count * 3), ppm.end());
+}
+
+} // namespace
+
+TEST_CASE("ppm header and pixels")
+{
+    const std::vector<u8> pixels{
+      1, 2, 3, 255,   4, 5, 6, 255,
+      7, 8, 9, 255,   10, 11, 12, 255
+    };
+
+    const std::vector<u8> ppm = encode_ppm(2, 2, pixels, pixel_layout::rgba8);
+    REQUIRE(ppm.size() == header_2x2.size() + 2 * 2 * 3);
+    CHECK(std::string_view{reinterpret_cast<const char*>(ppm.data()), header_2x2.size()} == header_2x2);
+    CHECK(pixels_of(ppm, 4) == std::vector<u8>{1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12});
+}
+
+TEST_CASE("ppm swizzles bgra")
+{
+    const std::vector<u8> ppm = encode_ppm(1, 1, std::vector<u8>{30, 20, 10, 255}, pixel_layout::bgra8);
+    CHECK(pixels_of(ppm, 1) == std::vector<u8>{10, 20, 30});
+}
+
+TEST_CASE("ppm skips row padding")
+{
+    const std::vector<u8> pixels{
+      1, 2, 3, 0,   0xAA, 0xAA, 0xAA, 0xAA,
+      4, 5, 6, 0
+    };
+
+    const std::vector<u8> ppm = encode_ppm(1, 2, pixels, pixel_layout::rgba8, /*row_pitch=*/8);
+    CHECK(pixels_of(ppm, 2) == std::vector<u8>{1, 2, 3, 4, 5, 6});
+}
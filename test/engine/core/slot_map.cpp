@@ -0,0 +1,96 @@
+/*
+ * Copyright (C) 2023 Emre Simsirli
+ *
+ * Licensed under GPLv3 or any later version.
+ * Refer to the included LICENSE file.
+ */
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include <doctest/doctest.h>
+
+#include "core/container/slot_map.h"
+
+namespace {
+
+using volkano::slot_map;
+using volkano::u32;
+
+} // namespace
+
+TEST_CASE("slot map resolves handles after other elements move")
+{
+    slot_map<std::string> map;
+    const auto a = map.insert("a");
+    const auto b = map.insert("b");
+    const auto c = map.insert("c");
+    CHECK(map.size() == 3);
+
+    // c fills the hole a leaves behind
+    CHECK(map.erase(a));
+    CHECK(map.size() == 2);
+    CHECK(map[b] == "b");
+    CHECK(map[c] == "c");
+    CHECK(map.values().front() == "c");
+}
+
+TEST_CASE("slot map detects stale handles")
+{
+    slot_map<u32> map;
+    const auto first = map.insert(1);
+    CHECK(map.erase(first));
+    CHECK_FALSE(map.erase(first));
+    CHECK_FALSE(map.contains(first));
+    CHECK(map.get(first) == nullptr);
+
+    // the slot is reused with a newer generation
+    const auto second = map.insert(2);
+    CHECK(second.index() == first.index());
+    CHECK(second.generation() != first.generation());
+    CHECK(map.get(first) == nullptr);
+    CHECK(*map.get(second) == 2);
+
+    CHECK_FALSE(map.contains(decltype(map)::handle{}));
+}
+
+TEST_CASE("slot map retires slots whose generation runs out")
+{
+    slot_map<u32> map;
+    auto h = map.insert(0);
+    const u32 index = h.index();
+    for (u32 i = 0; i < (1u << slot_map<u32>::generation_bits) - 1; ++i) {
+        CHECK(map.erase(h));
+        h = map.insert(i);
+        REQUIRE(h.index() == index);
+    }
+
+    CHECK(map.erase(h));
+    CHECK_FALSE(map.contains(h));
+    CHECK(map.insert(0).index() != index);
+}
+
+TEST_CASE("slot map iterates live elements densely")
+{
+    slot_map<u32> map;
+    std::vector<slot_map<u32>::handle> handles;
+    for (u32 i = 0; i < 8; ++i) {
+        handles.push_back(map.insert(i));
+    }
+    for (u32 i = 0; i < 8; i += 2) {
+        CHECK(map.erase(handles[i]));
+    }
+
+    std::vector<u32> values{map.begin(), map.end()};
+    std::ranges::sort(values);
+    CHECK(values == std::vector<u32>{1, 3, 5, 7});
+
+    for (u32 i = 0; i < map.size(); ++i) {
+        CHECK(map[map.handle_at(i)] == map.values()[i]);
+    }
+
+    map.clear();
+    CHECK(map.empty());
+    CHECK(std::ranges::none_of(handles, [&](const auto h) { return map.contains(h); }));
+}
@@ -0,0 +1,133 @@
+/*
+ * Copyright (C) 2023 Emre Simsirli
+ *
+ * Licensed under GPLv3 or any later version.
+ * Refer to the included LICENSE file.
+ */
+
+#include <memory>
+#include <string>
+#include <utility>
+
+#include <doctest/doctest.h>
+
+#include "core/container/small_vector.h"
+
+namespace {
+
+using volkano::small_vector;
+using volkano::u32;
+using volkano::usize;
+
+template<typename T>
+struct counting_allocator {
+    using value_type = T;
+
+    usize* allocation_count;
+
+    explicit counting_allocator(usize* count) noexcept : allocation_count{count} {}
+
+    template<typename U>
+    explicit counting_allocator(const counting_allocator<U>& other) noexcept : allocation_count{other.allocation_count} {}
+
+    T* allocate(const usize n)
+    {
+        ++*allocation_count;
+        return std::allocator<T>{}.allocate(n);
+    }
+
+    void deallocate(T* ptr, const usize n) noexcept { std::allocator<T>{}.deallocate(ptr, n); }
+
+    bool operator==(const counting_allocator&) const noexcept = default;
+};
+
+} // namespace
+
+TEST_CASE("small vector stays inline until it outgrows its inline capacity")
+{
+    small_vector<u32, 4> vec;
+    for (u32 i = 0; i < 4; ++i) {
+        vec.push_back(i);
+    }
+    CHECK(vec.is_inline());
+    CHECK(vec.capacity() == 4);
+
+    vec.push_back(4);
+    CHECK_FALSE(vec.is_inline());
+    CHECK(vec.capacity() == 8);
+    CHECK(vec == small_vector<u32, 4>{0, 1, 2, 3, 4});
+}
+
+TEST_CASE("small vector allocates from its allocator")
+{
+    usize allocation_count = 0;
+    using vector = small_vector<u32, 2, counting_allocator<u32>>;
+    vector vec{counting_allocator<u32>{&allocation_count}};
+    vec.push_back(1);
+    vec.push_back(2);
+    CHECK(allocation_count == 0);
+
+    vec.push_back(3);
+    CHECK(allocation_count == 1);
+    vec.reserve(64);
+    CHECK(allocation_count == 2);
+
+    // a buffer from an equal allocator is taken over
+    const vector moved{std::move(vec)};
+    CHECK(allocation_count == 2);
+    CHECK(moved.size() == 3);
+    CHECK(vec.empty());
+    CHECK(vec.is_inline());
+}
+
+TEST_CASE("small vector moves elements that are not trivially relocatable")
+{
+    small_vector<std::string, 2> vec{"a long string that is not stored inline by std::string", "b"};
+    vec.emplace_back("c");
+    CHECK(vec[0] == "a long string that is not stored inline by std::string");
+    CHECK(vec[2] == "c");
+
+    small_vector<std::string, 2> inline_vec{"x"};
+    small_vector<std::string, 2> moved{std::move(inline_vec)};
+    CHECK(moved.is_inline());
+    CHECK(moved.front() == "x");
+    CHECK(inline_vec.empty());
+
+    small_vector<std::string, 2> copy = vec;
+    CHECK(copy == vec);
+    copy = moved;
+    CHECK(copy == moved);
+    CHECK(vec.size() == 3);
+}
+
+TEST_CASE("small vector growth keeps arguments that refer to its own elements")
+{
+    small_vector<std::string, 1> vec{"self"};
+    vec.push_back(vec[0]);
+    vec.push_back(vec[1]);
+    CHECK(vec == small_vector<std::string, 1>{"self", "self", "self"});
+}
+
+TEST_CASE("small vector erases and resizes")
+{
+    small_vector<std::unique_ptr<u32>, 2> vec;
+    for (u32 i = 0; i < 5; ++i) {
+        vec.push_back(std::make_unique<u32>(i));
+    }
+
+    vec.erase(vec.begin() + 1, vec.begin() + 3);
+    REQUIRE(vec.size() == 3);
+    CHECK(*vec[0] == 0);
+    CHECK(*vec[1] == 3);
+    CHECK(*vec[2] == 4);
+
+    vec.pop_back();
+    vec.resize(4);
+    CHECK(vec.size() == 4);
+    CHECK(vec[3] == nullptr);
+    vec.resize(1);
+    CHECK(*vec.back() == 0);
+
+    vec.clear();
+    CHECK(vec.empty());
+}
@@ -6,6 +6,7 @@
  */
 
 #include <exception>
+#include <iterator>
 
 #include <doctest/doctest.h>
 
@@ -132,4 +133,38 @@ TEST_CASE("static_vector - compare") {
     REQUIRE(s4 > s3);
 }
 
+TEST_CASE("static_vector - iterate") {
+    volkano::static_vector<int, 3> v = {1, 2, 3};
+
+    int sum = 0;
+    for (const int i : v) {
+        sum += i;
+    }
+    REQUIRE(sum == 6);
+    REQUIRE(v.end() - v.begin() == 3);
+    REQUIRE(v.cend() - v.cbegin() == 3);
+}
+
+TEST_CASE("static_vector - reverse iterate") {
+    volkano::static_vector<int, 3> v = {1, 2, 3};
+    const auto& cv = v;
+
+    REQUIRE(*v.rbegin() == 3);
+    REQUIRE(*cv.rbegin() == 3);
+    REQUIRE(*v.crbegin() == 3);
+    REQUIRE(*std::prev(v.rend()) == 1);
+    REQUIRE(*std::prev(cv.rend()) == 1);
+    REQUIRE(std::distance(v.rbegin(), v.rend()) == 3);
+    REQUIRE(std::distance(cv.rbegin(), cv.rend()) == 3);
+}
+
+TEST_CASE("static_vector - resize to capacity") {
+    volkano::static_vector<int, 2> v;
+    v.resize(2);
+    REQUIRE(v.size() == 2);
+
+    v.resize(1);
+    REQUIRE(v.size() == 1);
+}
+
 }
@@ -0,0 +1,112 @@
+/*
+ * Copyright (C) 2023 Emre Simsirli
+ *
+ * Licensed under GPLv3 or any later version.
+ * Refer to the included LICENSE file.
+ */
+
+#include <array>
+
+#include <doctest/doctest.h>
+
+#include "core/memory/linear_arena.h"
+#include "renderer/vk_render_graph.h"
+
+namespace {
+
+using volkano::linear_arena;
+using volkano::vk_render_graph;
+using volkano::vk_rg_image_desc;
+using volkano::vk_rg_placement;
+using volkano::vk_rg_resource;
+using volkano::vk_rg_usage;
+
+namespace vk_rg_usages = volkano::vk_rg_usages;
+
+constexpr vk_rg_image_desc color_desc{
+  .format = vk::Format::eB8G8R8A8Srgb,
+  .extent = vk::Extent2D{.width = 64, .height = 64}
+};
+
+// graphs that only use imported resources never touch the device
+void initialize_without_device(vk_render_graph& graph, linear_arena& arena)
+{
+    graph.initialize(vk::Device{}, vma::Allocator{}, &arena);
+}
+
+} // namespace
+
+TEST_CASE("render graph culls a pass whose transient output is never read")
+{
+    linear_arena arena;
+    vk_render_graph graph;
+    initialize_without_device(graph, arena);
+
+    const vk_rg_resource backbuffer = graph.import_image("backbuffer", vk::Image{}, vk::ImageView{}, color_desc,
+      vk_rg_usages::present, vk_rg_usages::present);
+    const vk_rg_resource unread = graph.create_image("unread", color_desc);
+
+    graph.add_pass("unread writer",
+      [&](vk_render_graph::pass_builder& builder) { builder.write(unread, vk_rg_usages::color_attachment); },
+      nullptr);
+    graph.add_pass("main",
+      [&](vk_render_graph::pass_builder& builder) { builder.write(backbuffer, vk_rg_usages::color_attachment); },
+      nullptr);
+    graph.compile();
+
+    CHECK(graph.is_culled(0));
+    CHECK_FALSE(graph.is_culled(1));
+    CHECK(graph.stats().pass_count == 2);
+    CHECK(graph.stats().culled_pass_count == 1);
+    // culled away before anything was allocated for it
+    CHECK(graph.stats().transient_requested_size == 0);
+}
+
+TEST_CASE("render graph orders a read after a write with a barrier")
+{
+    linear_arena arena;
+    vk_render_graph graph;
+    initialize_without_device(graph, arena);
+
+    const vk_rg_resource draws = graph.import_buffer("draw commands", vk::Buffer{}, vk_rg_usage{});
+
+    graph.add_pass("cull",
+      [&](vk_render_graph::pass_builder& builder) { builder.write(draws, vk_rg_usages::compute_storage_write); },
+      nullptr);
+    graph.add_pass("draw",
+      [&](vk_render_graph::pass_builder& builder) {
+          builder.read(draws, vk_rg_usages::indirect_read);
+          builder.set_side_effects();
+      },
+      nullptr);
+    graph.compile();
+
+    // nothing used the buffer before the graph
+    CHECK(graph.buffer_barriers(0).empty());
+
+    REQUIRE(graph.buffer_barriers(1).size() == 1);
+    const vk::BufferMemoryBarrier2& barrier = graph.buffer_barriers(1).front();
+    CHECK(barrier.srcStageMask == vk::PipelineStageFlagBits2::eComputeShader);
+    CHECK(barrier.srcAccessMask == vk::AccessFlagBits2::eShaderStorageWrite);
+    CHECK(barrier.dstStageMask == vk::PipelineStageFlagBits2::eDrawIndirect);
+    CHECK(barrier.dstAccessMask == vk::AccessFlagBits2::eIndirectCommandRead);
+    CHECK(graph.image_barriers(1).empty());
+    CHECK(graph.stats().barrier_count == 1);
+}
+
+TEST_CASE("transients with disjoint lifetimes share memory")
+{
+    std::array placements{
+      vk_rg_placement{.first_pass = 0, .last_pass = 1, .size = 1000},
+      vk_rg_placement{.first_pass = 2, .last_pass = 3, .size = 600},
+      // overlaps both of the others
+      vk_rg_placement{.first_pass = 1, .last_pass = 2, .size = 200}
+    };
+
+    const vk::DeviceSize block_size = volkano::vk_rg_place_transients(placements, /*alignment=*/256);
+
+    CHECK(placements[0].offset == 0);
+    CHECK(placements[1].offset == 0);
+    CHECK(placements[2].offset == 1024);
+    CHECK(block_size == 1224);
+}